@@ -0,0 +1,233 @@
+/*
+Compares ESBTL's map-based Molecular_system with the flat Hierarchy on a large
+structure: reading a PDB file through the same ESBTL line reader into either
+storage, walking the hierarchy, and looking residues up by key.
+
+	hierarchy_benchmark [atom count | file.pdb]
+
+Without a file, a structure of the given size (1M atoms by default) is written
+to a temporary PDB file first.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <ESBTL/default.h>
+
+#include "bio/FlatSystem.h"
+#include "bio/Hierarchy.h"
+#include "bio/HierarchyBuilder.h"
+
+namespace {
+
+using Policy = ESBTL::Accept_all_occupancy_policy<ESBTL::PDB::Line_format<>>;
+
+constexpr int REPEATS = 5;
+constexpr int LOOKUPS = 200000;
+const char *const NAMES[] = {" N  ", " CA ", " C  ", " O  ", " CB ", " CG ", " CD ", " CE "};
+const char *const ELEMENTS[] = {"N", "C", "C", "O", "C", "C", "C", "C"};
+const char CHAINS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+constexpr int RESIDUES_PER_CHAIN = 5000;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//Best of REPEATS runs of fn, in milliseconds
+template <class Function>
+double bestOf(Function fn) {
+	double best = 1e30;
+	for (int i = 0; i < REPEATS; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		best = std::min(best, seconds(start) * 1000.0);
+	}
+	return best;
+}
+
+//Writes atomCount atoms of 8-atom residues, 5000 residues per chain and a new model once chain ids run out
+bool writeStructure(const std::string &path, size_t atomCount) {
+	FILE *file = std::fopen(path.c_str(), "w");
+	if (!file) {
+		return false;
+	}
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> offset(-1.5f, 1.5f);
+	size_t chainsPerModel = sizeof(CHAINS) - 1;
+	size_t atomsPerModel = chainsPerModel * RESIDUES_PER_CHAIN * 8;
+	float x = 0.0f, y = 0.0f, z = 0.0f;
+	for (size_t atom = 0; atom < atomCount; ++atom) {
+		size_t model = atom / atomsPerModel;
+		size_t residue = atom / 8;
+		if (atom % atomsPerModel == 0) {
+			std::fprintf(file, "MODEL     %4zu\n", model + 1);
+		}
+		char chain = CHAINS[residue / RESIDUES_PER_CHAIN % chainsPerModel];
+		int residueNum = static_cast<int>(residue % RESIDUES_PER_CHAIN) + 1;
+		x += offset(random);
+		y += offset(random);
+		z += offset(random);
+		std::fprintf(file, "ATOM  %5zu %4s ALA %c%4d    %8.3f%8.3f%8.3f%6.2f%6.2f          %2s  \n",
+			(atom + 1) % 100000, NAMES[atom % 8], chain, residueNum, x, y, z, 1.0, 20.0, ELEMENTS[atom % 8]);
+		if ((atom + 1) % atomsPerModel == 0 || atom + 1 == atomCount) {
+			std::fprintf(file, "ENDMDL\n");
+		}
+	}
+	return std::fclose(file) == 0;
+}
+
+//Keys of residues to look up, taken from the structure so every lookup hits
+struct ResidueKey {
+	int model;
+	char chain;
+	int residueNum;
+};
+
+std::vector<ResidueKey> lookupKeys(const Hierarchy &hierarchy) {
+	std::vector<ResidueKey> keys;
+	std::mt19937 random(2);
+	std::uniform_int_distribution<size_t> residues(0, hierarchy.residueCount() - 1);
+	for (int i = 0; i < LOOKUPS; ++i) {
+		size_t residue = residues(random);
+		size_t chain = std::upper_bound(hierarchy.chainResidueStarts.begin(), hierarchy.chainResidueStarts.end(),
+			residue) - hierarchy.chainResidueStarts.begin() - 1;
+		size_t model = std::upper_bound(hierarchy.modelChainStarts.begin(), hierarchy.modelChainStarts.end(),
+			chain) - hierarchy.modelChainStarts.begin() - 1;
+		keys.push_back({hierarchy.modelNumbers[model], hierarchy.chainIds[chain], hierarchy.residueNums[residue]});
+	}
+	return keys;
+}
+
+//The same walks on either system type, so both go through the ESBTL iterator API
+template <class System>
+double sumAtomsOfModels(const System &system) {
+	double sum = 0.0;
+	for (auto model = system.models_begin(); model != system.models_end(); ++model) {
+		for (auto atom = model->atoms_begin(); atom != model->atoms_end(); ++atom) {
+			sum += atom->x() + atom->y() + atom->z();
+		}
+	}
+	return sum;
+}
+
+template <class System>
+size_t walkHierarchy(const System &system) {
+	size_t total = 0;
+	for (auto model = system.models_begin(); model != system.models_end(); ++model) {
+		for (auto chain = model->chains_begin(); chain != model->chains_end(); ++chain) {
+			for (auto residue = chain->residues_begin(); residue != chain->residues_end(); ++residue) {
+				for (auto atom = residue->atoms_begin(); atom != residue->atoms_end(); ++atom) {
+					total += atom->atom_name().size() + residue->residue_sequence_number() + atom->chain_identifier();
+				}
+			}
+		}
+	}
+	return total;
+}
+
+//ESBTL's const get_chain() does not compile, so the map lookups go through the non-const accessors
+size_t lookUp(ESBTL::Default_system &system, const std::vector<ResidueKey> &keys) {
+	size_t total = 0;
+	for (const ResidueKey &key : keys) {
+		total += system.get_model(key.model).get_or_create_chain(key.chain).get_residue(key.residueNum, ' ')
+			.number_of_atoms();
+	}
+	return total;
+}
+
+size_t lookUp(const FlatSystem &system, const std::vector<ResidueKey> &keys) {
+	size_t total = 0;
+	for (const ResidueKey &key : keys) {
+		total += system.get_model(key.model).get_chain(key.chain).get_residue(key.residueNum, ' ').number_of_atoms();
+	}
+	return total;
+}
+
+void report(const char *task, double mapMs, double flatMs) {
+	std::printf("%-34s %12.1f %12.1f %9.1fx\n", task, mapMs, flatMs, mapMs / flatMs);
+}
+
+}
+
+int main(int argc, char **argv) {
+	std::string path;
+	bool temporary = false;
+	size_t atomCount = 1000000;
+	if (argc > 1 && std::string(argv[1]).find(".pdb") != std::string::npos) {
+		path = argv[1];
+	} else {
+		if (argc > 1) {
+			atomCount = std::strtoull(argv[1], nullptr, 10);
+		}
+		path = "hierarchy_benchmark.pdb";
+		temporary = true;
+		std::printf("Writing %zu atoms to %s\n", atomCount, path.c_str());
+		if (!writeStructure(path, atomCount)) {
+			std::fprintf(stderr, "ERROR > Could not write %s\n\n", path.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+
+	//Reading: both go through the same line reader and field parsing, only the storage differs
+	std::vector<ESBTL::Default_system> mapSystems;
+	auto start = std::chrono::steady_clock::now();
+	{
+		ESBTL::PDB_line_selector selector;
+		ESBTL::All_atom_system_builder<ESBTL::Default_system> builder(mapSystems, selector.max_nb_systems());
+		ESBTL::read_a_pdb_file(path, selector, builder, Policy());
+	}
+	double mapRead = seconds(start) * 1000.0;
+
+	std::vector<Hierarchy> flatSystems;
+	start = std::chrono::steady_clock::now();
+	{
+		ESBTL::PDB_line_selector selector;
+		HierarchyBuilder builder(flatSystems, selector.max_nb_systems());
+		ESBTL::read_a_pdb_file(path, selector, builder, Policy());
+	}
+	double flatRead = seconds(start) * 1000.0;
+
+	const ESBTL::Default_system &mapSystem = mapSystems[0];
+	const Hierarchy &hierarchy = flatSystems[0];
+	FlatSystem flatSystem(hierarchy);
+	std::printf("%zu models, %zu chains, %zu residues, %zu atoms\n\n", hierarchy.modelCount(),
+		hierarchy.chainCount(), hierarchy.residueCount(), hierarchy.size());
+
+	//Both must see the same structure before their times mean anything
+	size_t mapWalk = walkHierarchy(mapSystem), flatWalk = walkHierarchy(flatSystem);
+	double mapSum = sumAtomsOfModels(mapSystem), flatSum = sumAtomsOfModels(flatSystem);
+	if (mapWalk != flatWalk || std::abs(mapSum - flatSum) > 1e-6 * std::abs(mapSum) + 1e-3) {
+		std::fprintf(stderr, "ERROR > The map-based and the flat hierarchy differ\n\n");
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%-34s %12s %12s %10s\n", "", "maps (ms)", "flat (ms)", "speedup");
+	report("Read PDB file", mapRead, flatRead);
+	volatile double sink = 0.0;
+	report("Model atoms, sum coordinates", bestOf([&] { sink = sumAtomsOfModels(mapSystem); }),
+		bestOf([&] { sink = sumAtomsOfModels(flatSystem); }));
+	report("Model > chain > residue > atom", bestOf([&] { sink = walkHierarchy(mapSystem); }),
+		bestOf([&] { sink = walkHierarchy(flatSystem); }));
+	report("Raw columns, sum coordinates", bestOf([&] { sink = sumAtomsOfModels(mapSystem); }),
+		bestOf([&] {
+			double sum = 0.0;
+			for (size_t i = 0; i < hierarchy.size(); ++i) {
+				sum += static_cast<double>(hierarchy.x[i]) + hierarchy.y[i] + hierarchy.z[i];
+			}
+			sink = sum;
+		}));
+
+	std::vector<ResidueKey> keys = lookupKeys(hierarchy);
+	ESBTL::Default_system &mutableMapSystem = mapSystems[0];
+	report("Residue lookups by key", bestOf([&] { sink = lookUp(mutableMapSystem, keys); }),
+		bestOf([&] { sink = lookUp(flatSystem, keys); }));
+
+	if (temporary) {
+		std::remove(path.c_str());
+	}
+	return EXIT_SUCCESS;
+}
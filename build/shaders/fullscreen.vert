@@ -0,0 +1,13 @@
+#version 330 core
+out vec2 TexCoord;
+
+// Region of the source textures in use, the scene may only cover part of them
+uniform vec2 uvScale;
+
+void main()
+{
+    // Single triangle covering the screen, generated from the vertex index
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = pos * uvScale;
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
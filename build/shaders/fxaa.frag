@@ -0,0 +1,56 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D screenTexture;
+uniform vec2 texelSize;
+uniform vec2 uvScale;
+
+const float FXAA_REDUCE_MIN = 1.0 / 128.0;
+const float FXAA_REDUCE_MUL = 1.0 / 8.0;
+const float FXAA_SPAN_MAX = 8.0;
+
+vec3 fetch(vec2 uv)
+{
+    // Never read outside the rendered region
+    return texture(screenTexture, clamp(uv, vec2(0.0), uvScale - texelSize * 0.5)).rgb;
+}
+
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main()
+{
+    vec3 rgbNW = fetch(TexCoord + vec2(-1.0, -1.0) * texelSize);
+    vec3 rgbNE = fetch(TexCoord + vec2( 1.0, -1.0) * texelSize);
+    vec3 rgbSW = fetch(TexCoord + vec2(-1.0,  1.0) * texelSize);
+    vec3 rgbSE = fetch(TexCoord + vec2( 1.0,  1.0) * texelSize);
+    vec3 rgbM  = fetch(TexCoord);
+
+    float lumaNW = luma(rgbNW);
+    float lumaNE = luma(rgbNE);
+    float lumaSW = luma(rgbSW);
+    float lumaSE = luma(rgbSE);
+    float lumaM  = luma(rgbM);
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // Blur along the edge, perpendicular to the luma gradient
+    vec2 dir;
+    dir.x = -((lumaNW + lumaNE) - (lumaSW + lumaSE));
+    dir.y =  ((lumaNW + lumaSW) - (lumaNE + lumaSE));
+
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texelSize;
+
+    vec3 rgbA = 0.5 * (fetch(TexCoord + dir * (1.0 / 3.0 - 0.5)) + fetch(TexCoord + dir * (2.0 / 3.0 - 0.5)));
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (fetch(TexCoord - dir * 0.5) + fetch(TexCoord + dir * 0.5));
+
+    float lumaB = luma(rgbB);
+    FragColor = vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, 1.0);
+}
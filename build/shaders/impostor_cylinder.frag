@@ -0,0 +1,44 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 viewPos;
+flat in vec3 start;
+flat in vec3 axis;
+flat in float radius;
+flat in vec4 startColor;
+flat in vec4 endColor;
+
+uniform mat4 projection;
+
+void main()
+{
+    vec3 dir = normalize(viewPos);
+    float len = length(axis);
+    vec3 w = axis / len;
+
+    // Ray against the infinite cylinder, in the plane perpendicular to the axis
+    vec3 d = dir - w * dot(dir, w);
+    vec3 o = -start - w * dot(-start, w);
+    float a = dot(d, d);
+    float b = dot(d, o);
+    float c = dot(o, o) - radius * radius;
+    float disc = b * b - a * c;
+    if (disc < 0.0 || a < 1e-8)
+        discard;
+    float t = (-b - sqrt(disc)) / a;
+    vec3 hit = dir * t;
+    float s = dot(hit - start, w);
+    // No caps, bond ends are hidden inside the atom spheres
+    if (s < 0.0 || s > len)
+        discard;
+    vec3 normal = normalize(hit - start - w * s);
+
+    vec4 clip = projection * vec4(hit, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    vec4 color = s < 0.5 * len ? startColor : endColor;
+    float facing = dot(normal, normalize(-hit));
+    float diffuse = clamp(facing, 0.0, 1.0) + 0.2;
+    float spec = pow(max(facing, 0.0), 60.0) * 0.3;
+    FragColor = vec4(color.rgb * diffuse + vec3(spec), color.a);
+}
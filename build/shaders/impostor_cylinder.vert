@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 aCorner; // box corner, x and y in [-1, 1], z in [0, 1] along the axis
+layout (location = 1) in vec4 aStart; // per instance: first end, radius
+layout (location = 2) in vec3 aEnd; // per instance
+layout (location = 3) in vec4 aStartColor; // per instance, first half
+layout (location = 4) in vec4 aEndColor; // per instance, second half
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 viewPos;
+flat out vec3 start;
+flat out vec3 axis;
+flat out float radius;
+flat out vec4 startColor;
+flat out vec4 endColor;
+
+void main()
+{
+    mat4 modelView = view * model;
+    start = (modelView * vec4(aStart.xyz, 1.0)).xyz;
+    vec3 end = (modelView * vec4(aEnd, 1.0)).xyz;
+    axis = end - start;
+    radius = aStart.w * length(model[0].xyz);
+    startColor = aStartColor;
+    endColor = aEndColor;
+
+    // Box around the cylinder, the fragment shader casts a ray against the exact surface
+    vec3 w = normalize(axis);
+    vec3 u = normalize(cross(w, abs(w.x) < 0.9 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0)));
+    vec3 v = cross(w, u);
+    viewPos = start + axis * aCorner.z + (u * aCorner.x + v * aCorner.y) * radius;
+    gl_Position = projection * vec4(viewPos, 1.0);
+}
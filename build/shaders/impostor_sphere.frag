@@ -0,0 +1,29 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 viewPos;
+flat in vec3 center;
+flat in float radius;
+flat in vec4 color;
+
+uniform mat4 projection;
+
+void main()
+{
+    // Ray from the camera (origin of view space) through the fragment
+    vec3 dir = normalize(viewPos);
+    float b = dot(dir, center);
+    float disc = b * b - dot(center, center) + radius * radius;
+    if (disc < 0.0)
+        discard;
+    vec3 hit = dir * (b - sqrt(disc));
+    vec3 normal = (hit - center) / radius;
+
+    vec4 clip = projection * vec4(hit, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    float facing = dot(normal, normalize(-hit));
+    float diffuse = clamp(facing, 0.0, 1.0) + 0.2;
+    float spec = pow(max(facing, 0.0), 60.0) * 0.3;
+    FragColor = vec4(color.rgb * diffuse + vec3(spec), color.a);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner; // quad corner in [-1, 1]
+layout (location = 1) in vec4 aSphere; // per instance: center, radius
+layout (location = 2) in vec4 aColor; // per instance
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 viewPos;
+flat out vec3 center;
+flat out float radius;
+flat out vec4 color;
+
+void main()
+{
+    vec4 viewCenter = view * model * vec4(aSphere.xyz, 1.0);
+    center = viewCenter.xyz;
+    radius = aSphere.w * length(model[0].xyz);
+    color = aColor;
+    // A quad of the radius in front of the sphere covers its silhouette under perspective
+    viewPos = center + vec3(aCorner * radius, radius);
+    gl_Position = projection * vec4(viewPos, 1.0);
+}
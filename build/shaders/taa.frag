@@ -0,0 +1,50 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D currentTexture;
+uniform sampler2D historyTexture;
+uniform sampler2D depthTexture;
+
+// Maps the current frame's clip space to the previous frame's, both without jitter
+uniform mat4 reprojection;
+uniform vec2 texelSize;
+uniform vec2 uvScale;
+uniform vec2 historyUvScale;
+// Weight of the current frame, 1 discards the history
+uniform float blend;
+
+void main()
+{
+    vec3 current = texture(currentTexture, TexCoord).rgb;
+
+    // Neighborhood bounds used to reject stale history
+    vec3 minColor = current;
+    vec3 maxColor = current;
+    for (int y = -1; y <= 1; ++y)
+    {
+        for (int x = -1; x <= 1; ++x)
+        {
+            vec2 uv = clamp(TexCoord + vec2(x, y) * texelSize, vec2(0.0), uvScale - texelSize * 0.5);
+            vec3 neighbor = texture(currentTexture, uv).rgb;
+            minColor = min(minColor, neighbor);
+            maxColor = max(maxColor, neighbor);
+        }
+    }
+
+    // Reproject through the depth buffer to find where this pixel was last frame
+    vec2 screen = TexCoord / uvScale;
+    float depth = texture(depthTexture, TexCoord).r;
+    vec4 previous = reprojection * vec4(screen * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec2 previousScreen = previous.xy / previous.w * 0.5 + 0.5;
+
+    float weight = blend;
+    if (any(lessThan(previousScreen, vec2(0.0))) || any(greaterThan(previousScreen, vec2(1.0))))
+        weight = 1.0;
+
+    vec3 history = texture(historyTexture, previousScreen * historyUvScale).rgb;
+    history = clamp(history, minColor, maxColor);
+
+    FragColor = vec4(mix(history, current, weight), 1.0);
+}
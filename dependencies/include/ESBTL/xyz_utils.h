@@ -97,7 +97,7 @@ namespace ESBTL{
     typedef boost::zip_iterator<It_tuple>     Zip_iterator;
     double nb=0;
     double sum_sqd=0;
-    for (Zip_iterator it=boost::make_zip_iterator(boost::make_tuple(begin1,begin1));it!=boost::make_zip_iterator(boost::make_tuple(end1,end2));++it){
+    for (Zip_iterator it=boost::make_zip_iterator(boost::make_tuple(begin1,begin2));it!=boost::make_zip_iterator(boost::make_tuple(end1,end2));++it){
       sum_sqd+=squared_distance(boost::get<0>(*it),boost::get<1>(*it));
       nb+=1;
     }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <bitset>
 #include <string>
 #include <cctype>
@@ -7,11 +8,21 @@
 #include <iostream>
 #include <unordered_map>
 #include <memory>
+#include <shared_mutex>
 #include <iomanip>
 
 class AminoAcid {
 private:
-	static std::unordered_map<std::string, std::shared_ptr<const AminoAcid>> dict;
+	/*
+	Custom and overwritten entries. The 20 standard amino acids live in a static
+	perfect-hash table and are only looked up here after one of their keys was
+	overwritten or erased (nullptr entries hide erased standard keys).
+	*/
+	static std::unordered_map<std::string, std::shared_ptr<const AminoAcid>> registry;
+	//Entries replaced or erased from registry, kept so pointers handed out by get() stay valid
+	static std::vector<std::shared_ptr<const AminoAcid>> retired;
+	static std::shared_mutex registryMutex;
+	static std::atomic<bool> standardShadowed;
 	
 	/*
 	0: isPolar
@@ -51,10 +62,17 @@ public:
 
 	/*
 	Returns an AminoAcid pointer for the given name (full or abbreviated).
-	Returns nullptr if no amino acid matches given name
+	Returns nullptr if no amino acid matches given name. The pointer stays valid
+	for the whole program, even after set() or erase() replaces the entry
 	*/
 	static const AminoAcid *get(const std::string &name);
 
+	/*
+	Like get, but registers a placeholder amino acid named name when there is none.
+	added is set to whether this call created it. Safe to call from several threads
+	*/
+	static const AminoAcid *getOrAdd(const std::string &name, bool &added);
+
 	/*
 	Constructs a new amino acid (returned) and adds it to the dictionary of existing
 	amino acids
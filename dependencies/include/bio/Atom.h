@@ -3,7 +3,6 @@
 #include <string>
 #include <glm/detail/type_vec.hpp>
 #include <glm/glm.hpp>
-#include "math/Vec.h"
 
 
 struct Atom {
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Atom.h"
+#include "StringPool.h"
+
+/*
+Columnar store for the atoms of a molecule.
+
+Coordinates are kept in separate x/y/z arrays, atom names, residue names and
+elements as ids into intern pools. Atoms point to a residue table and
+residues to a chain table, so per-residue data is only stored once.
+Consecutive atoms with the same chain and residue number form one residue.
+
+operator[] still returns an Atom for code that wants a whole record, hot
+loops should read the columns directly.
+*/
+class AtomTable {
+private:
+	//Index of every chain identifier in chainIds, -1 if not seen yet
+	std::array<int16_t, 256> chainIndexOf;
+
+	//Full identifiers handed out a code by chainCode(), and the identifier behind every code
+	std::unordered_map<std::string, char> chainCodes;
+	std::array<std::string, 256> chainNamesByCode;
+	std::string lastChainName;
+	char lastChainCode = ' ';
+	bool chainCodesExhausted = false;
+
+	void addResidue(char chain, int residueNum, uint16_t residueNameId);
+
+public:
+	//Per atom
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> bFactors;
+	std::vector<uint16_t> nameIds;
+	std::vector<uint16_t> elementIds;
+	std::vector<uint32_t> residueIndices;
+
+	//Per residue
+	std::vector<int> residueNums;
+	std::vector<uint16_t> residueNameIds;
+	std::vector<uint16_t> residueChainIndices;
+	std::vector<uint32_t> residueAtomStarts; //First atom of each residue
+
+	//Per chain, in order of first appearance
+	std::vector<char> chainIds;
+
+	StringPool names;
+	StringPool residueNames;
+	StringPool elements;
+
+	AtomTable();
+
+	size_t size() const {
+		return x.size();
+	}
+
+	bool empty() const {
+		return x.empty();
+	}
+
+	size_t residueCount() const {
+		return residueNums.size();
+	}
+
+	void reserve(size_t atomCount);
+	void clear();
+
+	void push_back(const Atom &atom);
+	void append(std::string_view name, std::string_view residueName, char chain, int residueNum,
+		const glm::vec3 &coords, std::string_view element, float bFactor = 0.0f);
+	//For loaders that intern whole columns up front
+	void appendInterned(uint16_t nameId, uint16_t residueNameId, char chain, int residueNum,
+		const glm::vec3 &coords, uint16_t elementId, float bFactor = 0.0f);
+
+	//Replaces every coordinate from 3 floats per atom (x, y, z), e.g. a trajectory frame
+	void setCoordinates(const float *xyz);
+
+	Atom operator[](size_t index) const;
+
+	//Range-for support, yields Atom records by value
+	class Iterator {
+	private:
+		const AtomTable *table;
+		size_t index;
+
+	public:
+		Iterator(const AtomTable *table, size_t index) :
+			table(table), index(index) {}
+
+		Atom operator*() const {
+			return (*table)[index];
+		}
+
+		Iterator &operator++() {
+			++index;
+			return *this;
+		}
+
+		bool operator!=(const Iterator &other) const {
+			return index != other.index;
+		}
+	};
+
+	Iterator begin() const {
+		return Iterator(this, 0);
+	}
+
+	Iterator end() const {
+		return Iterator(this, size());
+	}
+
+	glm::vec3 coords(size_t index) const {
+		return glm::vec3(x[index], y[index], z[index]);
+	}
+
+	char chain(size_t index) const {
+		return chainIds[residueChainIndices[residueIndices[index]]];
+	}
+
+	int residueNum(size_t index) const {
+		return residueNums[residueIndices[index]];
+	}
+
+	const std::string &name(size_t index) const {
+		return names[nameIds[index]];
+	}
+
+	const std::string &residueName(size_t index) const {
+		return residueNames[residueNameIds[residueIndices[index]]];
+	}
+
+	const std::string &element(size_t index) const {
+		return elements[elementIds[index]];
+	}
+
+	/*
+	Single character code for a chain identifier of any length, for formats
+	with multi-character identifiers (mmCIF asym ids of large assemblies).
+	Every distinct identifier gets its own code: single characters keep
+	their character while it is free, others get the next unused code.
+	Helices, sheets and bonds of the same file must take their chains from
+	here too. Past 254 chains codes run out and an error is printed.
+	*/
+	char chainCode(std::string_view id);
+
+	//Full identifier of the chain at an index of chainIds
+	std::string chainName(size_t chainIndex) const;
+
+	//Index of a chain identifier in chainIds, -1 if no atom belongs to it
+	int chainIndex(char chain) const {
+		return chainIndexOf[static_cast<unsigned char>(chain)];
+	}
+};
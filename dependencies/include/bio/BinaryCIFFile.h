@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MoleculeData.h"
+#include "Helix.h"
+#include "Sheet.h"
+#include "DisulfideBond.h"
+#include "Atom.h"
+
+/*
+Molecule read from a local BinaryCIF (.bcif) file.
+
+BinaryCIF stores every mmCIF column as a MessagePack blob with a chain of
+codecs (run-length, delta, integer packing, fixed point, string tables). The
+file is memory mapped and only the columns MoleculeData needs are decoded,
+in parallel and straight into typed arrays, so no text is ever produced for
+numeric columns. Compressed (.bcif.gz) files have to be decompressed first.
+Only the first data block and the first model are read, chain identifiers
+longer than one character get a code of their own like in CIFFile.
+*/
+class BinaryCIFFile : public MoleculeData {
+public:
+	explicit BinaryCIFFile(const std::string &path);
+};
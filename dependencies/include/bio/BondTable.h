@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AtomTable.h"
+
+/*
+Covalent bonds in compressed sparse row form. Every bond is stored once, with
+the higher atom index as the partner of the lower one: the partners of atom i
+are partners[offsets[i]..offsets[i + 1]), all greater than i.
+*/
+class BondTable {
+public:
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> partners;
+
+	size_t size() const {
+		return partners.size();
+	}
+
+	bool empty() const {
+		return partners.empty();
+	}
+
+	void clear();
+
+	/*
+	Bonds every pair of atoms closer than the sum of their covalent radii plus
+	tolerance (angstrom). Atoms are binned into a grid sized by the largest radius
+	present, and each worker tests a contiguous range of atoms against the
+	neighboring cells only.
+	*/
+	void perceive(const AtomTable &atoms, float tolerance = 0.45f);
+
+	//Calls fn(first, second) for every bond
+	template <class Function>
+	void forEach(Function fn) const {
+		for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+			for (uint32_t bond = offsets[i]; bond < offsets[i + 1]; ++bond) {
+				fn(static_cast<uint32_t>(i), partners[bond]);
+			}
+		}
+	}
+};
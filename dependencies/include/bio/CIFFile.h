@@ -0,0 +1,31 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "MoleculeData.h"
+#include "Helix.h"
+#include "Sheet.h"
+#include "DisulfideBond.h"
+#include "Atom.h"
+
+/*
+Molecule read from a local mmCIF (PDBx) file.
+
+The file is streamed through a fixed-size buffer, so memory use doesn't depend on
+the file size beyond the parsed atoms themselves. Loop tables are parsed with
+column projection: only the columns of atom_site, struct_conf, struct_sheet_range
+and struct_conn that MoleculeData needs are copied and converted, every other
+value is skipped by the tokenizer.
+Only the first data block and the first model are read. Chain identifiers longer
+than one character get a code of their own from AtomTable::chainCode().
+*/
+class CIFFile : public MoleculeData {
+public:
+	explicit CIFFile(const std::string &path);
+	explicit CIFFile(std::istream &stream);
+
+private:
+	void read(std::istream &stream);
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MoleculeData.h"
+
+/*
+Cartoon representation of protein chains: a Catmull-Rom spline through the
+CA atoms, oriented by the carbonyl oxygens, extruded with a round tube for
+coils, a flat ribbon for helices and an arrow for strands. Profiles blend
+over one residue where the structure changes, so each chain piece is a single
+closed tube.
+
+Every chain becomes one mesh, built in parallel with the other chains.
+Tessellation follows the distance from the camera: update() only rebuilds
+chains whose detail level changed since they were last built, and lowers the
+detail of every chain together when the total would exceed vertexBudget.
+*/
+class Cartoon {
+public:
+	struct ChainMesh {
+		char chain;
+		int segments; //Spline samples per residue the mesh was built with, 0 if not built yet
+		glm::vec3 center;
+		float radius;
+		//Interleaved position and normal, 6 floats per vertex
+		std::vector<float> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	static constexpr int MAX_SEGMENTS = 8;
+
+	std::vector<ChainMesh> chains;
+	size_t vertexBudget = 2000000;
+
+	//Spline samples per residue for a chain seen from this far away
+	static int segmentsForDistance(float distance);
+
+	/*
+	Brings every chain to the detail of its distance from the camera, rebuilding
+	only the chains whose level changed. Returns the number of chains rebuilt.
+	Call clear() after editing atoms or secondary structure.
+	*/
+	size_t update(const MoleculeData &moleculeData, const glm::vec3 &camera);
+	//Builds every chain at the same detail
+	void build(const MoleculeData &moleculeData, int segmentsPerResidue);
+	void clear();
+
+private:
+	//Residues with a CA and an O of every chain, indexed like AtomTable::chainIds
+	std::vector<std::vector<uint32_t>> chainResidues;
+	std::vector<glm::vec3> caPositions; //Per residue
+	std::vector<glm::vec3> oPositions;
+
+	void readTraces(const MoleculeData &moleculeData);
+	void rebuild(const MoleculeData &moleculeData, const std::vector<int> &segments);
+	void buildChain(const std::vector<uint8_t> &structures, size_t chainIndex, int segments);
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AtomTable.h"
+
+/*
+Residue-level level of detail. Every residue collapses into one bead at the
+barycenter of its atoms (the one-bead model of ESBTL's coarse grain creators),
+sized like a uniform sphere with the same radius of gyration.
+
+update() picks a level per chain from the projected size of its nearest point:
+all atoms while an atom still covers pixelThreshold pixels, one bead per
+residue while a bead does, and otherwise a tube through every stride-th bead,
+with stride growing as the chain shrinks on screen.
+*/
+class CoarseGrain {
+public:
+	enum Level : uint8_t {
+		ATOMS,
+		RESIDUES,
+		CHAIN
+	};
+
+	struct Bead {
+		glm::vec3 center;
+		float radius;
+	};
+
+	struct ChainLevel {
+		char chain;
+		Level level;
+		int stride; //Beads skipped between tube joints at CHAIN level, 1 otherwise
+		glm::vec3 center;
+		float radius;
+		float beadRadius; //Mean bead radius, also the tube radius
+		std::vector<uint32_t> residues; //In atom order
+	};
+
+	//Apparent size (angstrom) of an atom when deciding to leave ATOMS level
+	static constexpr float ATOM_SIZE = 1.5f;
+	static constexpr int MAX_STRIDE = 16;
+	//Beads further apart than this per stride step aren't joined by the tube
+	static constexpr float MAX_LINK = 8.0f;
+
+	std::vector<Bead> beads; //Per residue, indexed like AtomTable::residueNums
+	std::vector<ChainLevel> chains; //Indexed like AtomTable::chainIds
+	float pixelThreshold = 3.0f;
+
+	//Pixels covered by one angstrom at distance 1, for a vertical field of view in degrees
+	static float pixelsPerUnit(float fovDegrees, float viewportHeight);
+
+	//Computes the beads and chain bounds, call again after editing atoms
+	void build(const AtomTable &atoms);
+	//Picks the level of every chain, returns the number of chains whose level or stride changed
+	size_t update(const glm::vec3 &camera, float pixelsPerUnit);
+	void clear();
+
+	bool empty() const {
+		return chains.empty();
+	}
+
+	Level atomLevel(const AtomTable &atoms, size_t atom) const {
+		return chains[atoms.residueChainIndices[atoms.residueIndices[atom]]].level;
+	}
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MessagePack.h"
+
+/*
+Typed column decoded from a BinaryCIF encoded column.
+
+Numeric columns end up in integers or reals depending on the last codec,
+string columns as one copy of every distinct string plus an index per row.
+The conversions below let readers ask for the type they need regardless
+of how the writer chose to encode the column.
+*/
+class DecodedColumn {
+public:
+	enum class Type {
+		INTEGER, REAL, STRING
+	};
+
+	Type type = Type::INTEGER;
+	std::vector<int32_t> integers; //Values, or indices into strings for string columns (negative is null)
+	std::vector<float> reals;
+	std::vector<std::string> strings;
+	std::vector<uint8_t> mask; //Empty when every value is present, otherwise 0 = present, 1 = '.', 2 = '?'
+
+	size_t size() const;
+	bool isNull(size_t row) const;
+
+	int integer(size_t row) const;
+	float real(size_t row) const;
+	//Text of string columns, empty for null values and numeric columns
+	std::string_view text(size_t row) const;
+};
+
+/*
+Decodes an encoded column ({data, encoding} map) into out. The codecs of the
+encoding list are undone from last to first: ByteArray, FixedPoint,
+IntervalQuantization, RunLength, Delta, IntegerPacking and StringArray.
+Returns false for unknown codecs or inconsistent data.
+*/
+bool decodeColumn(const MessagePackValue &encodedData, DecodedColumn &out);
+
+//Decodes a {name, data, mask} column entry of a category, including its mask
+bool decodeCategoryColumn(const MessagePackValue &column, DecodedColumn &out);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AtomTable.h"
+
+/*
+Residue-residue contacts in compressed sparse row form: residue i touches
+partners[offsets[i]..offsets[i + 1]), all greater than i, at the minimum
+heavy-atom distance stored alongside in distances.
+
+compute() bins the heavy atoms into a SpatialGrid with cells of cutoff + skin
+and gathers, in parallel over chunks of residues, every residue pair closer
+than that as a candidate. update() is meant for trajectory frames: as long as
+no atom moved more than skin / 2 since the candidates were gathered, no pair
+outside them can have come within the cutoff, so only the candidate pairs are
+measured again. Otherwise it falls back to compute().
+*/
+class ContactMap {
+public:
+	float cutoff = 4.5f;
+	float skin = 2.0f;
+
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> partners;
+	std::vector<float> distances;
+
+	size_t size() const {
+		return partners.size();
+	}
+
+	bool empty() const {
+		return partners.empty();
+	}
+
+	void clear();
+
+	void compute(const AtomTable &atoms);
+	//Contacts for new coordinates of the same atoms, returns true if the candidates had to be gathered again
+	bool update(const AtomTable &atoms);
+
+	//Minimum heavy-atom distance of two residues, or a negative value if they aren't in contact
+	float distance(uint32_t first, uint32_t second) const;
+
+	/*
+	Dense CA-CA distances of the residues [rowBegin, rowEnd) against
+	[columnBegin, columnEnd), row-major into out, computed in parallel tiles.
+	NaN where a residue has no CA.
+	*/
+	static void distanceMatrix(const AtomTable &atoms, size_t rowBegin, size_t rowEnd,
+		size_t columnBegin, size_t columnEnd, float *out);
+
+private:
+	std::vector<uint8_t> heavy; //Per atom, 0 for hydrogens
+	std::vector<uint32_t> candidateOffsets;
+	std::vector<uint32_t> candidatePartners;
+	std::vector<float> candidateDistances;
+	//Coordinates when the candidates were gathered
+	std::vector<float> gatheredX;
+	std::vector<float> gatheredY;
+	std::vector<float> gatheredZ;
+
+	float residueDistance(const AtomTable &atoms, uint32_t first, uint32_t second) const;
+	//Fills offsets, partners and distances with the candidates closer than cutoff
+	void collectContacts();
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+#include "TrajectoryFile.h"
+
+/*
+CHARMM/NAMD trajectory (.dcd) in either byte order. Frames all have the same
+size, so the index is computed from the header without reading the frames.
+Files with fixed atoms, whose first frame differs from the others, aren't
+supported.
+*/
+class DCDFile : public TrajectoryFile {
+private:
+	bool swapped = false; //Byte order differs from this machine's
+	size_t cellRecordSize = 0; //Unit cell record in front of every frame, 0 if absent
+
+	uint32_t readInt(const char *data) const;
+	float readFloat(const char *data) const;
+
+public:
+	explicit DCDFile(const std::string &path);
+
+protected:
+	bool decodeFrame(const char *data, size_t size, float *xyz) const override;
+};
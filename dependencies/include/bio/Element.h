@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*
+Chemical elements by atomic number, named by their symbols. UNKNOWN (0)
+stands for symbols that don't name an element, so per-element tables can be
+indexed without checks.
+*/
+enum class Element : uint8_t {
+	UNKNOWN = 0,
+	H = 1, He, Li, Be, B, C, N, O, F, Ne,
+	Na, Mg, Al, Si, P, S, Cl, Ar, K, Ca,
+	Sc, Ti, V, Cr, Mn, Fe, Co, Ni, Cu, Zn,
+	Ga, Ge, As, Se, Br, Kr, Rb, Sr, Y, Zr,
+	Nb, Mo, Tc, Ru, Rh, Pd, Ag, Cd, In, Sn,
+	Sb, Te, I, Xe, Cs, Ba, La, Ce, Pr, Nd,
+	Pm, Sm, Eu, Gd, Tb, Dy, Ho, Er, Tm, Yb,
+	Lu, Hf, Ta, W, Re, Os, Ir, Pt, Au, Hg,
+	Tl, Pb, Bi, Po, At, Rn, Fr, Ra, Ac, Th,
+	Pa, U, Np, Pu, Am, Cm, Bk, Cf, Es, Fm,
+	Md, No, Lr, Rf, Db, Sg, Bh, Hs, Mt, Ds,
+	Rg, Cn, Nh, Fl, Mc, Lv, Ts, Og,
+	COUNT
+};
+
+constexpr const char *ELEMENT_SYMBOLS[] = {
+	"",
+	"H", "He", "Li", "Be", "B", "C", "N", "O", "F", "Ne",
+	"Na", "Mg", "Al", "Si", "P", "S", "Cl", "Ar", "K", "Ca",
+	"Sc", "Ti", "V", "Cr", "Mn", "Fe", "Co", "Ni", "Cu", "Zn",
+	"Ga", "Ge", "As", "Se", "Br", "Kr", "Rb", "Sr", "Y", "Zr",
+	"Nb", "Mo", "Tc", "Ru", "Rh", "Pd", "Ag", "Cd", "In", "Sn",
+	"Sb", "Te", "I", "Xe", "Cs", "Ba", "La", "Ce", "Pr", "Nd",
+	"Pm", "Sm", "Eu", "Gd", "Tb", "Dy", "Ho", "Er", "Tm", "Yb",
+	"Lu", "Hf", "Ta", "W", "Re", "Os", "Ir", "Pt", "Au", "Hg",
+	"Tl", "Pb", "Bi", "Po", "At", "Rn", "Fr", "Ra", "Ac", "Th",
+	"Pa", "U", "Np", "Pu", "Am", "Cm", "Bk", "Cf", "Es", "Fm",
+	"Md", "No", "Lr", "Rf", "Db", "Sg", "Bh", "Hs", "Mt", "Ds",
+	"Rg", "Cn", "Nh", "Fl", "Mc", "Lv", "Ts", "Og"
+};
+static_assert(sizeof(ELEMENT_SYMBOLS) / sizeof(ELEMENT_SYMBOLS[0]) == static_cast<size_t>(Element::COUNT),
+	"ELEMENT_SYMBOLS must have one entry per element");
+
+constexpr char toUpperAscii(char c) {
+	return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+//Element for a symbol in any letter case ("FE", "Fe"), UNKNOWN if there is none
+constexpr Element elementFromSymbol(std::string_view symbol) {
+	if (symbol.empty() || symbol.size() > 2) {
+		return Element::UNKNOWN;
+	}
+	for (size_t i = 1; i < static_cast<size_t>(Element::COUNT); ++i) {
+		std::string_view candidate = ELEMENT_SYMBOLS[i];
+		if (candidate.size() != symbol.size()) {
+			continue;
+		}
+		bool same = true;
+		for (size_t j = 0; j < symbol.size(); ++j) {
+			same = same && toUpperAscii(candidate[j]) == toUpperAscii(symbol[j]);
+		}
+		if (same) {
+			return static_cast<Element>(i);
+		}
+	}
+	return Element::UNKNOWN;
+}
+
+constexpr std::string_view elementSymbol(Element element) {
+	return ELEMENT_SYMBOLS[static_cast<size_t>(element) < static_cast<size_t>(Element::COUNT) ? static_cast<size_t>(element) : 0];
+}
+
+static_assert(elementFromSymbol("FE") == Element::Fe && elementFromSymbol("c") == Element::C &&
+	elementFromSymbol("X") == Element::UNKNOWN, "elementFromSymbol lookup is broken");
+
+struct ElementRadius {
+	Element element;
+	float radius;
+};
+
+//Single-bond covalent radii in angstrom (Cordero et al. 2008), sp3 carbon
+constexpr ElementRadius COVALENT_RADII[] = {
+	{Element::H, 0.31f}, {Element::B, 0.84f}, {Element::C, 0.76f}, {Element::N, 0.71f}, {Element::O, 0.66f},
+	{Element::F, 0.57f}, {Element::Na, 1.66f}, {Element::Mg, 1.41f}, {Element::Al, 1.21f}, {Element::Si, 1.11f},
+	{Element::P, 1.07f}, {Element::S, 1.05f}, {Element::Cl, 1.02f}, {Element::K, 2.03f}, {Element::Ca, 1.76f},
+	{Element::Mn, 1.39f}, {Element::Fe, 1.32f}, {Element::Co, 1.26f}, {Element::Ni, 1.24f}, {Element::Cu, 1.32f},
+	{Element::Zn, 1.22f}, {Element::Se, 1.20f}, {Element::Br, 1.20f}, {Element::Mo, 1.54f}, {Element::Cd, 1.44f},
+	{Element::I, 1.39f}, {Element::Pt, 1.36f}, {Element::Au, 1.36f}, {Element::Hg, 1.32f}
+};
+
+//Radius used for elements without an entry, including UNKNOWN
+constexpr float DEFAULT_COVALENT_RADIUS = 0.77f;
+
+constexpr float covalentRadius(Element element) {
+	for (const auto &entry : COVALENT_RADII) {
+		if (entry.element == element) {
+			return entry.radius;
+		}
+	}
+	return DEFAULT_COVALENT_RADIUS;
+}
+
+//Van der Waals radii in angstrom (Bondi 1964, metals from Alvarez 2013)
+constexpr ElementRadius VAN_DER_WAALS_RADII[] = {
+	{Element::H, 1.20f}, {Element::C, 1.70f}, {Element::N, 1.55f}, {Element::O, 1.52f}, {Element::F, 1.47f},
+	{Element::Na, 2.27f}, {Element::Mg, 1.73f}, {Element::Si, 2.10f}, {Element::P, 1.80f}, {Element::S, 1.80f},
+	{Element::Cl, 1.75f}, {Element::K, 2.75f}, {Element::Ca, 2.31f}, {Element::Mn, 2.05f}, {Element::Fe, 2.04f},
+	{Element::Co, 2.00f}, {Element::Ni, 1.63f}, {Element::Cu, 1.40f}, {Element::Zn, 1.39f}, {Element::Se, 1.90f},
+	{Element::Br, 1.85f}, {Element::I, 1.98f}
+};
+
+constexpr float DEFAULT_VAN_DER_WAALS_RADIUS = 1.70f;
+
+constexpr float vanDerWaalsRadius(Element element) {
+	for (const auto &entry : VAN_DER_WAALS_RADII) {
+		if (entry.element == element) {
+			return entry.radius;
+		}
+	}
+	return DEFAULT_VAN_DER_WAALS_RADIUS;
+}
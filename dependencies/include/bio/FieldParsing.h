@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+/*
+Allocation-free parsers for the numeric fields of text structure formats.
+Leading and trailing blanks are ignored, malformed input yields the digits
+read so far (0 for empty fields) instead of an error.
+*/
+
+inline std::string_view trimField(std::string_view field) {
+	size_t begin = 0;
+	size_t end = field.size();
+	while (begin < end && (field[begin] == ' ' || field[begin] == '\t')) {
+		++begin;
+	}
+	while (end > begin && (field[end - 1] == ' ' || field[end - 1] == '\t' || field[end - 1] == '\r')) {
+		--end;
+	}
+	return field.substr(begin, end - begin);
+}
+
+//Columns first..last (1-based, inclusive) of a fixed-column record, clipped to the line
+inline std::string_view columns(std::string_view line, size_t first, size_t last) {
+	if (first > line.size()) {
+		return std::string_view();
+	}
+	return line.substr(first - 1, std::min(last, line.size()) - (first - 1));
+}
+
+inline int parseIntField(std::string_view field) {
+	field = trimField(field);
+	size_t i = 0;
+	bool negative = false;
+	if (i < field.size() && (field[i] == '-' || field[i] == '+')) {
+		negative = field[i] == '-';
+		++i;
+	}
+	int value = 0;
+	for (; i < field.size(); ++i) {
+		unsigned int digit = static_cast<unsigned int>(field[i] - '0');
+		if (digit > 9) {
+			break;
+		}
+		value = value * 10 + static_cast<int>(digit);
+	}
+	return negative ? -value : value;
+}
+
+//Decimal numbers with an optional fraction and exponent, as found in PDB/mmCIF coordinates
+inline float parseFloatField(std::string_view field) {
+	static const double POWERS_OF_TEN[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+		1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+	};
+
+	field = trimField(field);
+	size_t i = 0;
+	bool negative = false;
+	if (i < field.size() && (field[i] == '-' || field[i] == '+')) {
+		negative = field[i] == '-';
+		++i;
+	}
+
+	//Accumulate all significant digits as an integer, remember where the point was
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	for (; i < field.size(); ++i) {
+		unsigned int digit = static_cast<unsigned int>(field[i] - '0');
+		if (digit > 9) {
+			break;
+		}
+		if (digits < 18) {
+			mantissa = mantissa * 10 + digit;
+			++digits;
+		}
+		else {
+			++exponent;
+		}
+	}
+	if (i < field.size() && field[i] == '.') {
+		for (++i; i < field.size(); ++i) {
+			unsigned int digit = static_cast<unsigned int>(field[i] - '0');
+			if (digit > 9) {
+				break;
+			}
+			if (digits < 18) {
+				mantissa = mantissa * 10 + digit;
+				++digits;
+				--exponent;
+			}
+		}
+	}
+	if (i < field.size() && (field[i] == 'e' || field[i] == 'E')) {
+		exponent += parseIntField(field.substr(i + 1));
+	}
+
+	double value = static_cast<double>(mantissa);
+	while (exponent < -18) {
+		value /= 1e18;
+		exponent += 18;
+	}
+	while (exponent > 18) {
+		value *= 1e18;
+		exponent -= 18;
+	}
+	value = exponent < 0 ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+	return static_cast<float>(negative ? -value : value);
+}
@@ -0,0 +1,466 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "Hierarchy.h"
+
+/*
+Read-only view of a Hierarchy with the iteration API of ESBTL's
+Molecular_system, so code written against ESBTL (system.models_begin(),
+model.chains_begin(), chain.residues_begin(), residue.atoms_begin(),
+atom.residue_name(), ...) runs on the flat arrays unchanged.
+
+Models, chains, residues and atoms are small handles holding their index and
+the indices of their parents, returned by value. Iterators step through one
+level and move the parent indices along at the level boundaries, so an atom
+reached from a model still knows its residue and chain without a search.
+Lookups by key (get_chain, get_residue, get_atom) are binary searches in the
+sorted ranges. Like ESBTL, they assert that the key exists.
+*/
+class FlatSystem {
+public:
+	class Model;
+	class Chain;
+	class Residue;
+	class Atom;
+
+	//Forward iterator over one level, Handle::advance() moves to the next element
+	template <class Handle>
+	class Iterator {
+	private:
+		Handle handle;
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Handle;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Handle *;
+		using reference = const Handle &;
+
+		explicit Iterator(const Handle &handle) :
+			handle(handle) {}
+
+		reference operator*() const {
+			return handle;
+		}
+
+		pointer operator->() const {
+			return &handle;
+		}
+
+		Iterator &operator++() {
+			handle.advance();
+			return *this;
+		}
+
+		Iterator operator++(int) {
+			Iterator previous = *this;
+			handle.advance();
+			return previous;
+		}
+
+		bool operator==(const Iterator &other) const {
+			return handle.position() == other.handle.position();
+		}
+
+		bool operator!=(const Iterator &other) const {
+			return handle.position() != other.handle.position();
+		}
+	};
+
+	using Models_iterator = Iterator<Model>;
+	using Models_const_iterator = Iterator<Model>;
+
+	class Atom {
+	private:
+		friend class FlatSystem;
+		const FlatSystem *owner;
+		uint32_t atomIndex, residueIndex, chainIndex, modelIndex;
+
+	public:
+		Atom(const FlatSystem *system, uint32_t atom, uint32_t residue, uint32_t chain, uint32_t model) :
+			owner(system), atomIndex(atom), residueIndex(residue), chainIndex(chain), modelIndex(model) {}
+
+		uint32_t position() const {
+			return atomIndex;
+		}
+
+		void advance() {
+			const Hierarchy &h = owner->hierarchy;
+			++atomIndex;
+			while (residueIndex + 1 < h.residueCount() && atomIndex >= h.residueAtomStarts[residueIndex + 1]) {
+				++residueIndex;
+			}
+			while (chainIndex + 1 < h.chainCount() && residueIndex >= h.chainResidueStarts[chainIndex + 1]) {
+				++chainIndex;
+			}
+			while (modelIndex + 1 < h.modelCount() && chainIndex >= h.modelChainStarts[modelIndex + 1]) {
+				++modelIndex;
+			}
+		}
+
+		//Index in the per-atom columns of the hierarchy
+		uint32_t index() const {
+			return atomIndex;
+		}
+
+		double x() const {
+			return owner->hierarchy.x[atomIndex];
+		}
+
+		double y() const {
+			return owner->hierarchy.y[atomIndex];
+		}
+
+		double z() const {
+			return owner->hierarchy.z[atomIndex];
+		}
+
+		bool is_hetatm() const {
+			return owner->hierarchy.hetero[atomIndex] != 0;
+		}
+
+		int atom_serial_number() const {
+			return owner->hierarchy.serials[atomIndex];
+		}
+
+		const std::string &atom_name() const {
+			return owner->hierarchy.names[owner->hierarchy.nameIds[atomIndex]];
+		}
+
+		char alternate_location() const {
+			return owner->hierarchy.altLocs[atomIndex];
+		}
+
+		double occupancy() const {
+			return owner->hierarchy.occupancies[atomIndex];
+		}
+
+		double temperature_factor() const {
+			return owner->hierarchy.bFactors[atomIndex];
+		}
+
+		const std::string &element() const {
+			return owner->hierarchy.elements[owner->hierarchy.elementIds[atomIndex]];
+		}
+
+		int charge() const {
+			return owner->hierarchy.charges[atomIndex];
+		}
+
+		int system_index() const {
+			return owner->index();
+		}
+
+		char chain_identifier() const {
+			return owner->hierarchy.chainIds[chainIndex];
+		}
+
+		Residue residue() const {
+			return Residue(owner, residueIndex, chainIndex, modelIndex);
+		}
+
+		const std::string &residue_name() const {
+			return owner->hierarchy.residueNames[owner->hierarchy.residueNameIds[residueIndex]];
+		}
+
+		int residue_sequence_number() const {
+			return owner->hierarchy.residueNums[residueIndex];
+		}
+
+		char insertion_code() const {
+			return owner->hierarchy.insertionCodes[residueIndex];
+		}
+	};
+
+	class Residue {
+	private:
+		friend class FlatSystem;
+		const FlatSystem *owner;
+		uint32_t residueIndex, chainIndex, modelIndex;
+
+	public:
+		using Atoms_iterator = Iterator<Atom>;
+		using Atoms_const_iterator = Iterator<Atom>;
+
+		Residue(const FlatSystem *system, uint32_t residue, uint32_t chain, uint32_t model) :
+			owner(system), residueIndex(residue), chainIndex(chain), modelIndex(model) {}
+
+		uint32_t position() const {
+			return residueIndex;
+		}
+
+		void advance() {
+			const Hierarchy &h = owner->hierarchy;
+			++residueIndex;
+			while (chainIndex + 1 < h.chainCount() && residueIndex >= h.chainResidueStarts[chainIndex + 1]) {
+				++chainIndex;
+			}
+			while (modelIndex + 1 < h.modelCount() && chainIndex >= h.modelChainStarts[modelIndex + 1]) {
+				++modelIndex;
+			}
+		}
+
+		uint32_t index() const {
+			return residueIndex;
+		}
+
+		const std::string &residue_name() const {
+			return owner->hierarchy.residueNames[owner->hierarchy.residueNameIds[residueIndex]];
+		}
+
+		int residue_sequence_number() const {
+			return owner->hierarchy.residueNums[residueIndex];
+		}
+
+		char insertion_code() const {
+			return owner->hierarchy.insertionCodes[residueIndex];
+		}
+
+		char chain_identifier() const {
+			return owner->hierarchy.chainIds[chainIndex];
+		}
+
+		Chain chain() const {
+			return Chain(owner, chainIndex, modelIndex);
+		}
+
+		size_t number_of_atoms() const {
+			return owner->hierarchy.atoms(residueIndex).size();
+		}
+
+		const Atom get_atom(unsigned serial) const {
+			int atom = owner->hierarchy.findAtom(residueIndex, static_cast<int>(serial));
+			assert(atom >= 0);
+			return Atom(owner, static_cast<uint32_t>(atom), residueIndex, chainIndex, modelIndex);
+		}
+
+		Atoms_const_iterator atoms_begin() const {
+			return Atoms_const_iterator(Atom(owner, owner->hierarchy.residueAtomStarts[residueIndex], residueIndex, chainIndex, modelIndex));
+		}
+
+		Atoms_const_iterator atoms_end() const {
+			return Atoms_const_iterator(Atom(owner, owner->hierarchy.residueAtomStarts[residueIndex + 1], residueIndex, chainIndex, modelIndex));
+		}
+	};
+
+	class Chain {
+	private:
+		friend class FlatSystem;
+		const FlatSystem *owner;
+		uint32_t chainIndex, modelIndex;
+
+	public:
+		using Residues_iterator = Iterator<Residue>;
+		using Residues_const_iterator = Iterator<Residue>;
+		using Atoms_iterator = Iterator<Atom>;
+		using Atoms_const_iterator = Iterator<Atom>;
+
+		Chain(const FlatSystem *system, uint32_t chain, uint32_t model) :
+			owner(system), chainIndex(chain), modelIndex(model) {}
+
+		uint32_t position() const {
+			return chainIndex;
+		}
+
+		void advance() {
+			const Hierarchy &h = owner->hierarchy;
+			++chainIndex;
+			while (modelIndex + 1 < h.modelCount() && chainIndex >= h.modelChainStarts[modelIndex + 1]) {
+				++modelIndex;
+			}
+		}
+
+		uint32_t index() const {
+			return chainIndex;
+		}
+
+		char chain_identifier() const {
+			return owner->hierarchy.chainIds[chainIndex];
+		}
+
+		Model model() const {
+			return Model(owner, modelIndex);
+		}
+
+		size_t number_of_residues() const {
+			return owner->hierarchy.residues(chainIndex).size();
+		}
+
+		size_t number_of_atoms() const {
+			return owner->hierarchy.chainAtoms(chainIndex).size();
+		}
+
+		const Residue get_residue(int residueNum, char insertionCode = ' ') const {
+			int residue = owner->hierarchy.findResidue(chainIndex, residueNum, insertionCode);
+			assert(residue >= 0);
+			return Residue(owner, static_cast<uint32_t>(residue), chainIndex, modelIndex);
+		}
+
+		const Atom get_atom(int residueNum, char insertionCode, unsigned serial) const {
+			return get_residue(residueNum, insertionCode).get_atom(serial);
+		}
+
+		Residues_const_iterator residues_begin() const {
+			return Residues_const_iterator(Residue(owner, owner->hierarchy.chainResidueStarts[chainIndex], chainIndex, modelIndex));
+		}
+
+		Residues_const_iterator residues_end() const {
+			return Residues_const_iterator(Residue(owner, owner->hierarchy.chainResidueStarts[chainIndex + 1], chainIndex, modelIndex));
+		}
+
+		Atoms_const_iterator atoms_begin() const {
+			const Hierarchy &h = owner->hierarchy;
+			uint32_t residue = h.chainResidueStarts[chainIndex];
+			return Atoms_const_iterator(Atom(owner, h.chainAtoms(chainIndex).first, residue, chainIndex, modelIndex));
+		}
+
+		Atoms_const_iterator atoms_end() const {
+			return Atoms_const_iterator(Atom(owner, owner->hierarchy.chainAtoms(chainIndex).last, 0, chainIndex, modelIndex));
+		}
+	};
+
+	class Model {
+	private:
+		friend class FlatSystem;
+		const FlatSystem *owner;
+		uint32_t modelIndex;
+
+	public:
+		using Chains_iterator = Iterator<Chain>;
+		using Chains_const_iterator = Iterator<Chain>;
+		using Residues_iterator = Iterator<Residue>;
+		using Residues_const_iterator = Iterator<Residue>;
+		using Atoms_iterator = Iterator<Atom>;
+		using Atoms_const_iterator = Iterator<Atom>;
+
+		Model(const FlatSystem *system, uint32_t model) :
+			owner(system), modelIndex(model) {}
+
+		uint32_t position() const {
+			return modelIndex;
+		}
+
+		void advance() {
+			++modelIndex;
+		}
+
+		uint32_t index() const {
+			return modelIndex;
+		}
+
+		const FlatSystem &system() const {
+			return *owner;
+		}
+
+		int model_number() const {
+			return owner->hierarchy.modelNumbers[modelIndex];
+		}
+
+		size_t number_of_chains() const {
+			return owner->hierarchy.chains(modelIndex).size();
+		}
+
+		size_t number_of_residues() const {
+			return owner->hierarchy.modelResidues(modelIndex).size();
+		}
+
+		size_t number_of_atoms() const {
+			return owner->hierarchy.modelAtoms(modelIndex).size();
+		}
+
+		const Chain get_chain(char id) const {
+			int chain = owner->hierarchy.findChain(modelIndex, id);
+			assert(chain >= 0);
+			return Chain(owner, static_cast<uint32_t>(chain), modelIndex);
+		}
+
+		const Residue get_residue(char chain, int residueNum, char insertionCode = ' ') const {
+			return get_chain(chain).get_residue(residueNum, insertionCode);
+		}
+
+		const Atom get_atom(char chain, int residueNum, char insertionCode, unsigned serial) const {
+			return get_chain(chain).get_residue(residueNum, insertionCode).get_atom(serial);
+		}
+
+		Chains_const_iterator chains_begin() const {
+			return Chains_const_iterator(Chain(owner, owner->hierarchy.modelChainStarts[modelIndex], modelIndex));
+		}
+
+		Chains_const_iterator chains_end() const {
+			return Chains_const_iterator(Chain(owner, owner->hierarchy.modelChainStarts[modelIndex + 1], modelIndex));
+		}
+
+		Residues_const_iterator residues_begin() const {
+			const Hierarchy &h = owner->hierarchy;
+			return Residues_const_iterator(Residue(owner, h.modelResidues(modelIndex).first, h.modelChainStarts[modelIndex], modelIndex));
+		}
+
+		Residues_const_iterator residues_end() const {
+			return Residues_const_iterator(Residue(owner, owner->hierarchy.modelResidues(modelIndex).last, 0, modelIndex));
+		}
+
+		Atoms_const_iterator atoms_begin() const {
+			const Hierarchy &h = owner->hierarchy;
+			uint32_t chain = h.modelChainStarts[modelIndex];
+			return Atoms_const_iterator(Atom(owner, h.modelAtoms(modelIndex).first, h.chainResidueStarts[chain], chain, modelIndex));
+		}
+
+		Atoms_const_iterator atoms_end() const {
+			return Atoms_const_iterator(Atom(owner, owner->hierarchy.modelAtoms(modelIndex).last, 0, 0, modelIndex));
+		}
+	};
+
+	const Hierarchy &hierarchy;
+
+	FlatSystem(const Hierarchy &hierarchy, int index = 1, std::string name = "no_name", char alternateLocation = ' ') :
+		hierarchy(hierarchy), systemIndex(index), systemName(std::move(name)), alternateLocation(alternateLocation) {}
+
+	int index() const {
+		return systemIndex;
+	}
+
+	const std::string &name() const {
+		return systemName;
+	}
+
+	char alternate_location() const {
+		return alternateLocation;
+	}
+
+	bool has_no_model() const {
+		return hierarchy.modelCount() == 0;
+	}
+
+	bool has_model(int modelNumber) const {
+		return hierarchy.findModel(modelNumber) >= 0;
+	}
+
+	size_t number_of_models() const {
+		return hierarchy.modelCount();
+	}
+
+	const Model get_model(int modelNumber) const {
+		int model = hierarchy.findModel(modelNumber);
+		assert(model >= 0);
+		return Model(this, static_cast<uint32_t>(model));
+	}
+
+	Models_const_iterator models_begin() const {
+		return Models_const_iterator(Model(this, 0));
+	}
+
+	Models_const_iterator models_end() const {
+		return Models_const_iterator(Model(this, static_cast<uint32_t>(hierarchy.modelCount())));
+	}
+
+private:
+	int systemIndex;
+	std::string systemName;
+	char alternateLocation;
+};
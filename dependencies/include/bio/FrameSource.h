@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/*
+Sequence of coordinate sets for a fixed topology: the models of an NMR entry
+or the frames of a trajectory. Atoms come in the order of the AtomTable the
+source was opened against.
+
+readFrame() and readFrames() are called from the prefetch thread of
+TrajectoryPlayer only, so implementations don't need to be thread safe.
+Random-access sources override readFrames() to decode several frames at once.
+*/
+class FrameSource {
+public:
+	virtual ~FrameSource() = default;
+
+	virtual size_t frameCount() const = 0;
+	virtual size_t atomCount() const = 0;
+
+	//Writes 3 floats per atom (x, y, z) of a frame, false if the frame couldn't be read
+	virtual bool readFrame(size_t index, float *xyz) = 0;
+	//Reads frames[i] into outputs[i] and sets results[i] to whether it could be read
+	virtual void readFrames(const size_t *frames, float *const *outputs, bool *results, size_t count);
+};
+
+//Frame source for a trajectory or multi-model file, picked by extension (.xtc, .trr, .dcd, .pdb)
+std::unique_ptr<FrameSource> openFrameSource(const std::string &path);
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "AtomTable.h"
+#include "StringPool.h"
+
+/*
+Model, chain, residue and atom hierarchy in flat arrays, the layout ESBTL's
+Molecular_system keeps in nested std::maps. Every level is one contiguous
+array per field, and every parent holds the start of its children in the
+next level: model m owns chains modelChainStarts[m]..modelChainStarts[m + 1],
+chain c owns residues chainResidueStarts[c]..chainResidueStarts[c + 1] and
+residue r owns atoms residueAtomStarts[r]..residueAtomStarts[r + 1]. The
+starts have one more entry than their level, so the atoms of a whole chain or
+model are one range as well.
+
+Atoms are added in any order and sorted by finish() into the order the maps
+iterate in: model number, chain identifier, residue number and insertion
+code, serial number. finish() is one stable sort of an index array (skipped
+for files already in that order) and a scan for the level boundaries, instead
+of a node allocation and a tree descent per atom.
+*/
+class Hierarchy {
+public:
+	struct Range {
+		uint32_t first;
+		uint32_t last;
+
+		size_t size() const {
+			return last - first;
+		}
+	};
+
+	//Per model
+	std::vector<int> modelNumbers;
+	std::vector<uint32_t> modelChainStarts;
+
+	//Per chain
+	std::vector<char> chainIds;
+	std::vector<uint32_t> chainResidueStarts;
+
+	//Per residue
+	std::vector<int> residueNums;
+	std::vector<char> insertionCodes;
+	std::vector<uint16_t> residueNameIds;
+	std::vector<uint32_t> residueAtomStarts;
+
+	//Per atom
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<int> serials;
+	std::vector<uint16_t> nameIds;
+	std::vector<uint16_t> elementIds;
+	std::vector<char> altLocs;
+	std::vector<float> occupancies;
+	std::vector<float> bFactors;
+	std::vector<int8_t> charges;
+	std::vector<uint8_t> hetero;
+
+	StringPool names;
+	StringPool residueNames;
+	StringPool elements;
+
+	size_t modelCount() const {
+		return modelNumbers.size();
+	}
+
+	size_t chainCount() const {
+		return chainIds.size();
+	}
+
+	size_t residueCount() const {
+		return residueNums.size();
+	}
+
+	size_t size() const {
+		return x.size();
+	}
+
+	bool empty() const {
+		return x.empty();
+	}
+
+	Range chains(size_t model) const {
+		return {modelChainStarts[model], modelChainStarts[model + 1]};
+	}
+
+	Range residues(size_t chain) const {
+		return {chainResidueStarts[chain], chainResidueStarts[chain + 1]};
+	}
+
+	Range atoms(size_t residue) const {
+		return {residueAtomStarts[residue], residueAtomStarts[residue + 1]};
+	}
+
+	Range modelResidues(size_t model) const {
+		return {chainResidueStarts[modelChainStarts[model]], chainResidueStarts[modelChainStarts[model + 1]]};
+	}
+
+	Range chainAtoms(size_t chain) const {
+		return {residueAtomStarts[chainResidueStarts[chain]], residueAtomStarts[chainResidueStarts[chain + 1]]};
+	}
+
+	Range modelAtoms(size_t model) const {
+		Range residues = modelResidues(model);
+		return {residueAtomStarts[residues.first], residueAtomStarts[residues.last]};
+	}
+
+	//Index of the model with this number, -1 if there is none
+	int findModel(int modelNumber) const;
+	//Index of the chain of model, -1 if there is none
+	int findChain(size_t model, char chain) const;
+	//Index of the residue of chain, -1 if there is none
+	int findResidue(size_t chain, int residueNum, char insertionCode = ' ') const;
+	//Index of the first atom of residue with this serial number, -1 if there is none
+	int findAtom(size_t residue, int serial) const;
+
+	void clear();
+	void reserve(size_t atomCount);
+
+	//Stages one atom for finish(), the hierarchy levels only exist after it
+	void add(int modelNumber, char chain, int residueNum, char insertionCode, std::string_view residueName,
+		int serial, std::string_view name, float atomX, float atomY, float atomZ, std::string_view element,
+		char altLoc = ' ', float occupancy = 1.0f, float bFactor = 0.0f, int charge = 0, bool isHetero = false);
+	//Sorts the staged atoms and builds the levels, previously finished atoms are kept
+	void finish();
+
+	//The atoms of a table as one model, with serial numbers from 1 in table order
+	void build(const AtomTable &atoms, int modelNumber = 1);
+
+private:
+	//Staged atoms: sort keys and the index of the atom in the per-atom columns
+	struct Pending {
+		int modelNumber;
+		char chain;
+		char insertionCode;
+		uint16_t residueNameId;
+		int residueNum;
+		int serial;
+		uint32_t atom;
+	};
+
+	std::vector<Pending> pending;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+#include <ESBTL/constants.h>
+#include <ESBTL/PDB.h>
+
+#include "Hierarchy.h"
+
+/*
+Builder for ESBTL's Line_reader (ESBTL::read_a_pdb_file) that fills flat
+Hierarchy objects instead of map-based Molecular_systems, with the same line
+selectors and occupancy policies. Like All_atom_system_builder, systems holds
+one entry per system of the line selector, and lines are staged as they are
+read and sorted once by create_systems() at the end of the file.
+
+	std::vector<Hierarchy> systems;
+	ESBTL::PDB_line_selector selector;
+	HierarchyBuilder builder(systems, selector.max_nb_systems());
+	ESBTL::read_a_pdb_file(path, selector, builder, ESBTL::Accept_none_occupancy_policy<ESBTL::PDB::Line_format<>>());
+	FlatSystem system(systems[0], 1, path, builder.alternateLocation);
+
+Fields missing from a line (coordinates, occupancy or B-factor) are stored as NaN.
+*/
+class HierarchyBuilder {
+private:
+	std::vector<Hierarchy> &systems;
+	int currentModel = 1;
+
+	static float field(double value) {
+		return value == NO_FLOAT ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(value);
+	}
+
+public:
+	//Alternate location kept by the reader, set by create_systems()
+	char alternateLocation = ' ';
+
+	HierarchyBuilder(std::vector<Hierarchy> &systems, unsigned maxSystems) :
+		systems(systems) {
+		systems.resize(std::max<size_t>(systems.size(), maxSystems));
+	}
+
+	template <class Line_format>
+	void interpret_line(const Line_format &lineFormat, const std::string &line, int systemInfo) {
+		if (systemInfo == RMK) {
+			if (lineFormat.record_type() == ESBTL::PDB::MODEL) {
+				currentModel = lineFormat.get_model_number(line);
+			}
+			return;
+		}
+		if (systems.size() < static_cast<size_t>(systemInfo)) {
+			systems.resize(systemInfo);
+		}
+		systems[systemInfo - 1].add(currentModel, lineFormat.get_chain_identifier(line),
+			lineFormat.get_residue_sequence_number(line), lineFormat.get_insertion_code(line),
+			lineFormat.get_residue_name(line), lineFormat.get_atom_serial_number(line), lineFormat.get_atom_name(line),
+			field(lineFormat.get_x(line)), field(lineFormat.get_y(line)), field(lineFormat.get_z(line)),
+			lineFormat.get_element(line), lineFormat.get_alternate_location(line), field(lineFormat.get_occupancy(line)),
+			field(lineFormat.get_temperature_factor(line)), lineFormat.get_charge(line), lineFormat.is_hetatm());
+	}
+
+	void create_systems(char altloc) {
+		alternateLocation = altloc;
+		for (Hierarchy &system : systems) {
+			system.finish();
+		}
+	}
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+Read-only memory mapping of a whole file. The contents stay valid for the
+lifetime of the object and can be read from any thread.
+*/
+class MappedFile {
+private:
+	const char *mapped = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void *fileHandle = nullptr;
+	void *mappingHandle = nullptr;
+#endif
+
+public:
+	explicit MappedFile(const std::string &path);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	//False if the file couldn't be opened or mapped (empty files are valid but unmapped)
+	bool isOpen() const;
+
+	const char *data() const;
+	size_t size() const;
+};
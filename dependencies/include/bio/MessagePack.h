@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*
+Minimal MessagePack reader for binary structure files. Strings and binary blobs
+are views into the input buffer, which must outlive the decoded tree. Extension
+types are read as binary blobs.
+*/
+class MessagePackValue {
+public:
+	enum class Type {
+		NIL, BOOLEAN, INTEGER, FLOAT, STRING, BINARY, ARRAY, MAP
+	};
+
+	Type type = Type::NIL;
+	long long integer = 0;
+	double number = 0.0;
+	std::string_view bytes;
+	//Array elements, or alternating keys and values for maps
+	std::vector<MessagePackValue> items;
+
+	//Decodes one value from data, false if the buffer is truncated or malformed
+	static bool parse(const char *data, size_t size, MessagePackValue &out);
+
+	//Value stored under a string key of a map, nullptr if there is none
+	const MessagePackValue *find(std::string_view key) const;
+
+	//Number of array elements or map entries
+	size_t size() const;
+	const MessagePackValue &operator[](size_t index) const;
+
+	bool isNil() const;
+	//Integer or float value as a number, 0 for other types
+	double asNumber() const;
+	long long asInteger() const;
+	std::string_view asString() const;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AtomTable.h"
+
+/*
+Solvent accessible (SAS) or solvent excluded (SES) surface of a set of atoms,
+triangulated with marching cubes.
+
+The distance field is sampled on a grid split into blocks of BLOCK_SIZE^3
+samples. Only blocks near atoms are allocated, and every block keeps its own
+field and triangles, so update() only recomputes the blocks a change can reach:
+the blocks around moved, added or removed atoms, or every block that isn't
+buried inside the molecule when the probe radius changes. Blocks are
+computed in parallel. Vertices on edges shared by neighboring blocks are
+merged when the blocks are stitched into the output mesh.
+
+The SES field is the distance to the nearest point a probe center can reach,
+taken over points sampled on the exposed part of every atom's accessible
+sphere.
+*/
+class MolecularSurface {
+public:
+	enum Type {
+		SAS, SES
+	};
+
+	static constexpr int BLOCK_SIZE = 8;
+
+	//Interleaved position and normal, 6 floats per vertex
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+
+	MolecularSurface(Type type = SES, float probeRadius = 1.4f, float spacing = 0.5f);
+	~MolecularSurface();
+
+	Type getType() const {
+		return type;
+	}
+
+	float getProbeRadius() const {
+		return probeRadius;
+	}
+
+	float getSpacing() const {
+		return spacing;
+	}
+
+	void setType(Type type);
+	void setProbeRadius(float probeRadius);
+	//Grid spacing in angstrom, changing it recomputes everything
+	void setSpacing(float spacing);
+
+	/*
+	Brings the mesh up to date with the atoms. selection has one flag per atom,
+	nullptr means every atom. Atoms are matched to the previous call by index.
+	*/
+	void update(const AtomTable &atoms, const std::vector<bool> *selection = nullptr);
+	//Drops every block, the next update recomputes everything
+	void clear();
+
+	size_t vertexCount() const {
+		return vertices.size() / 6;
+	}
+
+	size_t triangleCount() const {
+		return indices.size() / 3;
+	}
+
+	//Blocks recomputed by the last update, for profiling
+	size_t recomputedBlocks() const {
+		return lastRecomputed;
+	}
+
+private:
+	struct Block;
+
+	struct Sphere {
+		float x;
+		float y;
+		float z;
+		float radius; //Van der Waals
+		bool selected;
+	};
+
+	Type type;
+	float probeRadius;
+	float spacing;
+	bool parametersChanged = true;
+	size_t lastRecomputed = 0;
+
+	float originX = 0.0f;
+	float originY = 0.0f;
+	float originZ = 0.0f;
+	int blocksX = 0;
+	int blocksY = 0;
+	int blocksZ = 0;
+
+	std::vector<Sphere> spheres; //By atom index, as of the last update
+	std::vector<std::unique_ptr<Block>> blocks; //Dense over the grid, nullptr where no atom reaches
+	std::vector<uint8_t> dirty;
+
+	size_t blockIndex(int x, int y, int z) const {
+		return (static_cast<size_t>(z) * blocksY + y) * blocksX + x;
+	}
+
+	bool fitsGrid(const std::vector<Sphere> &current) const;
+	void resizeGrid(const AtomTable &atoms);
+	//Calls fn(block index) for every block within reach of a sphere around (x, y, z)
+	template <class Function>
+	void forEachBlockNear(float x, float y, float z, float reach, Function fn) const;
+
+	void computeBlocks(const std::vector<size_t> &dirtyBlocks, const std::vector<Sphere> &current);
+	void stitch();
+};
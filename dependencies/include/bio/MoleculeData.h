@@ -9,6 +9,10 @@
 #include "Sheet.h"
 #include "DisulfideBond.h"
 #include "Atom.h"
+#include "AtomTable.h"
+#include "SecondaryStructureIndex.h"
+#include "SecondaryStructureAssigner.h"
+#include "BondTable.h"
 
 class MoleculeData {
 public:
@@ -17,7 +21,7 @@ public:
 	std::vector<Helix> helices;
 	std::vector<Sheet> sheets;
 	std::vector<DisulfideBond> disulfideBonds;
-	std::vector<Atom> atoms;
+	AtomTable atoms;
 
 	void printSequence();
 	void printHelices();
@@ -25,4 +29,26 @@ public:
 	void printDisulfideBonds();
 	void printAtoms();
 	void printChains();
+
+	//Fills sequence and chains from the residues present in atoms, for files without sequence records
+	void buildSequenceFromAtoms();
+
+	//Per-residue secondary structure, built on first use. Call invalidateSecondaryStructure() after editing
+	//atoms, helices or sheets
+	const SecondaryStructureIndex &secondaryStructure() const;
+	void invalidateSecondaryStructure();
+	//Replaces helices and sheets with the ones assigned from the backbone geometry (see SecondaryStructureAssigner).
+	//The assigner and its buffers are kept, so calling it again on every trajectory frame doesn't reallocate
+	void assignSecondaryStructure();
+
+	//Covalent bonds perceived from the atom distances, built on first use. Call invalidateBonds() after editing atoms
+	const BondTable &bonds() const;
+	void invalidateBonds();
+
+private:
+	mutable SecondaryStructureIndex structureIndex;
+	mutable bool structureIndexBuilt = false;
+	SecondaryStructureAssigner structureAssigner;
+	mutable BondTable bondTable;
+	mutable bool bondTableBuilt = false;
 };
@@ -1,21 +1,24 @@
 #pragma once
 
-#include <algorithm>
-#include <sstream>
 #include <string>
 #include <vector>
 
-#include "HTTPConnection.h"
 #include "MoleculeData.h"
 #include "AminoAcid.h"
 #include "Helix.h"
 #include "Sheet.h"
 #include "DisulfideBond.h"
 #include "Atom.h"
-#include "Parser.h"
-#include "math/Vec.h"
 
+/*
+Molecule read from a local PDB file.
+
+The file is memory mapped and split into line-aligned ranges that are parsed
+in parallel. Each range parses the fixed-column ATOM/HETATM/HELIX/SHEET/SSBOND/SEQRES
+records directly, the per-range results are then merged in file order.
+Only the first model of multi-model files is read.
+*/
 class PDBFile : public MoleculeData {
 public:
-	explicit PDBFile(const std::string &url);
+	explicit PDBFile(const std::string &path);
 };
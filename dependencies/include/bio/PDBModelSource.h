@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "FrameSource.h"
+#include "MappedFile.h"
+
+/*
+Frames from the MODEL records of a PDB file, the first model being frame 0.
+A file without MODEL records is a single frame.
+
+The file stays mapped and only the start of every model is indexed when
+opening, coordinates are parsed in parallel on each readFrame().
+*/
+class PDBModelSource : public FrameSource {
+private:
+	MappedFile file;
+	std::vector<size_t> modelStarts; //Byte offsets, plus the end of the last model
+	size_t atoms = 0;
+
+public:
+	explicit PDBModelSource(const std::string &path);
+
+	size_t frameCount() const override;
+	size_t atomCount() const override;
+	bool readFrame(size_t index, float *xyz) override;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+//Number of worker threads used by the parallel loaders and kernels
+inline unsigned int workerCount() {
+	unsigned int count = std::thread::hardware_concurrency();
+	return count ? count : 1;
+}
+
+/*
+Splits [0, count) into contiguous slices and calls fn(begin, end) for each slice
+on its own thread. The calling thread processes the first slice. Blocks until every
+slice is done. Slices are never smaller than minPerThread items.
+*/
+template <class Function>
+void parallelFor(size_t count, Function fn, size_t minPerThread = 1) {
+	if (count == 0) {
+		return;
+	}
+	size_t threads = std::min<size_t>(workerCount(), (count + minPerThread - 1) / std::max<size_t>(minPerThread, 1));
+	threads = std::max<size_t>(threads, 1);
+
+	size_t sliceSize = (count + threads - 1) / threads;
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	for (size_t t = 1; t < threads; ++t) {
+		size_t begin = t * sliceSize;
+		size_t end = std::min(count, begin + sliceSize);
+		if (begin >= end) {
+			break;
+		}
+		workers.emplace_back(fn, begin, end);
+	}
+	fn(0, std::min(count, sliceSize));
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
@@ -10,10 +10,7 @@
 
 #include "AminoAcid.h"
 #include "Atom.h"
-#include "HTTPConnection.h"
 #include "MoleculeData.h"
-#include "graphics/SphereTemplate.h"
-#include "graphics/Model.h"
 
 class Protein {
 public:
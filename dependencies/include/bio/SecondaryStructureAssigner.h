@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AtomTable.h"
+#include "Helix.h"
+#include "Sheet.h"
+#include "SecondaryStructureIndex.h"
+#include "SpatialGrid.h"
+
+/*
+Assigns secondary structure from backbone geometry, following DSSP (Kabsch &
+Sander 1983), for structures without HELIX/SHEET records such as predicted
+models and trajectory frames.
+
+Backbone hydrogen bond energies are computed between residues whose CA atoms
+are within 9 angstrom, found through a spatial grid, keeping the two best
+acceptors of every NH donor. Consecutive n-turns make alpha (n = 4), 3/10
+(n = 3) and pi (n = 5) helices, ladders of at least two bridges make strands.
+Isolated bridges, bulges, turns and bends are not assigned.
+
+Scratch buffers are kept between calls, so one assigner can be reused for
+every frame of a trajectory.
+*/
+class SecondaryStructureAssigner {
+public:
+	//SecondaryStructureIndex::Structure of every residue, indexed like AtomTable::residueNums
+	std::vector<uint8_t> residueStructures;
+
+	void assign(const AtomTable &atoms);
+
+	//Turns the last assignment into helix and sheet ranges, one per run of residues
+	void toRanges(const AtomTable &atoms, std::vector<Helix> &helices, std::vector<Sheet> &sheets) const;
+
+private:
+	struct Backbone {
+		glm::vec3 n;
+		glm::vec3 ca;
+		glm::vec3 c;
+		glm::vec3 o;
+		glm::vec3 h;
+		bool complete; //Has N, CA, C and O
+		bool donor; //Has an amide hydrogen, not proline or a chain start
+	};
+
+	struct HBond {
+		uint32_t acceptor;
+		float energy;
+	};
+
+	enum BridgeType : uint8_t {
+		NO_BRIDGE, PARALLEL, ANTIPARALLEL
+	};
+
+	struct Bridge {
+		uint32_t partner;
+		BridgeType type;
+	};
+
+	static constexpr uint32_t NO_RESIDUE = UINT32_MAX;
+
+	std::vector<Backbone> backbones;
+	std::vector<uint32_t> segments; //Runs of peptide bonded residues, segment of every residue
+	std::vector<uint32_t> segmentStarts; //First residue of every segment, plus the end
+	std::vector<HBond> donorBonds; //Two per residue, best first
+	std::vector<Bridge> bridges; //Two per residue
+	std::vector<uint32_t> gridResidues; //Residue of every point in grid
+	std::vector<float> caX;
+	std::vector<float> caY;
+	std::vector<float> caZ;
+	SpatialGrid grid;
+
+	void readBackbones(const AtomTable &atoms);
+	void computeHBonds(const AtomTable &atoms);
+	void findBridges();
+	void assignHelices(int turn, SecondaryStructureIndex::Structure structure, bool onlyUnassigned);
+
+	bool linked(size_t first, size_t last) const {
+		return segments[first] == segments[last];
+	}
+
+	//Whether the CO of residue acceptor takes a hydrogen bond from the NH of residue donor
+	bool hbond(size_t acceptor, size_t donor) const;
+	bool turn(int n, size_t residue) const;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "AtomTable.h"
+#include "Helix.h"
+#include "Sheet.h"
+
+/*
+Secondary structure of every residue, resolved once from the helix and sheet
+ranges of a molecule instead of scanning all ranges per atom.
+
+Each chain gets a dense table over its residue number range, so looking up
+a (chain, residue number) pair is two array reads. Where ranges overlap,
+helices win over sheets and earlier helices win over later ones, matching
+the order Color::fromStructure used to test them in.
+*/
+class SecondaryStructureIndex {
+public:
+	enum Structure : uint8_t {
+		NONE, HELIX_ALPHA, HELIX_3_10, HELIX_PI, HELIX_OTHER, SHEET, COUNT
+	};
+
+	SecondaryStructureIndex();
+
+	//Structure of each residue of the atom table, indexed like AtomTable::residueNums
+	std::vector<uint8_t> residueStructures;
+
+	void build(const std::vector<Helix> &helices, const std::vector<Sheet> &sheets, const AtomTable &atoms);
+	void clear();
+
+	//NONE for chains or residue numbers without atoms
+	Structure lookup(char chain, int residueNum) const;
+
+	static Structure fromHelixType(int type);
+
+private:
+	struct ChainRange {
+		int firstResidue = 0;
+		std::vector<uint8_t> structures;
+	};
+
+	std::vector<ChainRange> chains; //Indexed like AtomTable::chainIds
+	std::array<int16_t, 256> chainIndexOf;
+};
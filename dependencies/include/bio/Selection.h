@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "AtomTable.h"
+
+//One bit per atom of a table, atom i in bit i % 64 of words[i / 64]. Bits past size are always 0
+struct AtomMask {
+	std::vector<uint64_t> words;
+	size_t size = 0;
+
+	void resize(size_t atomCount);
+
+	bool test(size_t index) const {
+		return (words[index >> 6] >> (index & 63)) & 1;
+	}
+
+	//Number of selected atoms
+	size_t count() const;
+	std::vector<uint32_t> indices() const;
+	//One flag per atom, the selection layout of ImpostorRenderer and MolecularSurface
+	std::vector<bool> flags() const;
+};
+
+/*
+Atom selection expressions compiled to a program of bitmask kernels over the
+columns of an AtomTable, e.g.
+
+	chain A and resname HIS and within 5 of ligand
+	protein and not backbone and bfactor > 40
+	byres (name CA and resid 10-20 30 to 40)
+
+Keywords taking values (chain, resname, resid, name, element, index) accept a
+list of them, matched if any matches. Names accept * and ? wildcards, resid
+and index accept ranges as 10-20, 10:20 or 10 to 20. x, y, z, bfactor, resid
+and index compare with <, <=, >, >=, == and !=. Classes are all, none,
+protein, nucleic, water, ligand (none of the former three), hydrogen,
+backbone and sidechain. within R of S selects atoms closer than R to S (S
+included), byres S and same residue as S extend S to whole residues. These
+and not bind tightest, then and, then or; quote values that read as
+operators ("OR").
+
+Each value test is resolved once per string id, residue or chain into a
+small table and gathered into 64-bit words per atom, the same way
+Color::fromScheme gathers palettes, so the per-atom loops never touch
+strings. and, or and not work a word at a time. within bins the atoms of S
+into a SpatialGrid and only queries atoms inside the bounding box of S grown
+by R. Every kernel runs in parallel over slices of words.
+*/
+class Selection {
+public:
+	Selection() = default;
+	//Compiles expression, check error() for failures
+	explicit Selection(std::string_view expression);
+
+	//Replaces the program, returns false and sets error() if expression doesn't parse. The
+	//previous program is kept then
+	bool compile(std::string_view expression);
+
+	//Empty when the last compile() succeeded
+	const std::string &error() const {
+		return errorMessage;
+	}
+
+	const std::string &expression() const {
+		return source;
+	}
+
+	//True until an expression compiled
+	bool empty() const {
+		return program.empty();
+	}
+
+	//Atoms matching the expression, none if nothing compiled yet
+	AtomMask evaluate(const AtomTable &atoms) const;
+	void evaluate(const AtomTable &atoms, AtomMask &out) const;
+
+	enum class Op : uint8_t {
+		ALL, NONE, CHAIN, RESIDUE_NAME, RESIDUE_NUM, ATOM_NAME, ELEMENT, INDEX, COMPARE,
+		PROTEIN, NUCLEIC, WATER, HYDROGEN, BACKBONE,
+		AND, OR, NOT, WITHIN, BYRES
+	};
+
+	enum class Column : uint8_t {
+		X, Y, Z, B_FACTOR
+	};
+
+	enum class Comparison : uint8_t {
+		LESS, LESS_EQUAL, GREATER, GREATER_EQUAL, EQUAL, NOT_EQUAL
+	};
+
+	/*
+	Postfix program: leaf ops push a mask, NOT, WITHIN and BYRES replace the
+	top one and AND and OR combine the top two
+	*/
+	struct Instruction {
+		Op op;
+		Column column = Column::X;
+		Comparison comparison = Comparison::LESS;
+		float value = 0.0f; //COMPARE threshold, WITHIN radius
+		std::vector<std::string> patterns; //CHAIN, RESIDUE_NAME, ATOM_NAME, ELEMENT
+		std::vector<std::pair<int64_t, int64_t>> ranges; //RESIDUE_NUM, INDEX, inclusive
+	};
+
+	const std::vector<Instruction> &instructions() const {
+		return program;
+	}
+
+private:
+	std::vector<Instruction> program;
+	std::string source;
+	std::string errorMessage;
+};
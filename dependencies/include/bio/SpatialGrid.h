@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Cell list over a point set, built with a counting sort: points are grouped by
+cell in items, cell c holding items[cellStarts[c]..cellStarts[c + 1]), and
+slotX/slotY/slotZ hold their coordinates in the same order. With a cell size
+of at least the search radius, every neighbor of a point lies in the 3x3x3
+block of cells around it.
+
+The cells holding points are surrounded by one layer of empty cells, so that
+block always exists: a query walks nine rows of three cells adjacent in memory,
+each one contiguous range of slots, without bounds checks. Positions outside
+the grid are snapped to its outermost layer of points.
+
+It replaces ESBTL's Grid_of_cubes, which keeps a std::map of heap-allocated
+cubes holding std::lists of iterators: forEachPair() visits the pairs a cube
+and its neighbor_iterator would, and build() takes the same iterator ranges.
+*/
+class SpatialGrid {
+public:
+	float cellSize = 1.0f;
+	float originX = 0.0f;
+	float originY = 0.0f;
+	float originZ = 0.0f;
+	int cellsX = 0;
+	int cellsY = 0;
+	int cellsZ = 0;
+
+	std::vector<uint32_t> cellStarts;
+	std::vector<uint32_t> items;
+	std::vector<uint32_t> cellOfItem; //Cell of every point, by point index
+	std::vector<float> slotX; //Coordinates of items[slot], by slot
+	std::vector<float> slotY;
+	std::vector<float> slotZ;
+
+	/*
+	Bins count points. The cell size may be enlarged so sparse point sets
+	(e.g. two molecules far apart) don't allocate more cells than a few per point
+	*/
+	void build(const float *x, const float *y, const float *z, size_t count, float minimumCellSize);
+	void clear();
+
+	//Bins the objects of [begin, end) by their x(), y() and z(), point i being the i-th object of the range
+	template <class Iterator>
+	void build(Iterator begin, Iterator end, float minimumCellSize) {
+		std::vector<float> x, y, z;
+		for (Iterator object = begin; object != end; ++object) {
+			x.push_back(static_cast<float>(object->x()));
+			y.push_back(static_cast<float>(object->y()));
+			z.push_back(static_cast<float>(object->z()));
+		}
+		build(x.data(), y.data(), z.data(), x.size(), minimumCellSize);
+	}
+
+	size_t cellCount() const {
+		return static_cast<size_t>(cellsX) * cellsY * cellsZ;
+	}
+
+	//Cell along one axis, never in the empty outer layer
+	int cellCoordinate(float value, float origin, int cells) const {
+		int cell = static_cast<int>((value - origin) / cellSize);
+		return std::min(std::max(cell, 1), cells - 2);
+	}
+
+	size_t cellOf(float x, float y, float z) const {
+		size_t cx = static_cast<size_t>(cellCoordinate(x, originX, cellsX));
+		size_t cy = static_cast<size_t>(cellCoordinate(y, originY, cellsY));
+		size_t cz = static_cast<size_t>(cellCoordinate(z, originZ, cellsZ));
+		return (cz * cellsY + cy) * cellsX + cx;
+	}
+
+	//Calls fn(slot) for every slot of items in the 27 cells around (x, y, z)
+	template <class Function>
+	void forEachNearSlot(float x, float y, float z, Function fn) const {
+		if (items.empty()) {
+			return;
+		}
+		size_t center = cellOf(x, y, z);
+		for (ptrdiff_t offset : rowOffsets) {
+			size_t row = center + offset;
+			for (size_t slot = cellStarts[row], last = cellStarts[row + 3]; slot < last; ++slot) {
+				fn(slot);
+			}
+		}
+	}
+
+	//Calls fn(index) for every point in the 27 cells around (x, y, z)
+	template <class Function>
+	void forEachNear(float x, float y, float z, Function fn) const {
+		forEachNearSlot(x, y, z, [&](size_t slot) {
+			fn(items[slot]);
+		});
+	}
+
+	//Whether fn(index) is true for a point in the 27 cells around (x, y, z), stops at the first one
+	template <class Predicate>
+	bool anyNear(float x, float y, float z, Predicate fn) const {
+		if (items.empty()) {
+			return false;
+		}
+		size_t center = cellOf(x, y, z);
+		for (ptrdiff_t offset : rowOffsets) {
+			size_t row = center + offset;
+			for (size_t slot = cellStarts[row], last = cellStarts[row + 3]; slot < last; ++slot) {
+				if (fn(items[slot])) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	//Calls fn(index, squared distance) for every point within radius of (x, y, z), radius at most cellSize
+	template <class Function>
+	void forEachWithin(float x, float y, float z, float radius, Function fn) const {
+		float radius2 = radius * radius;
+		forEachNearSlot(x, y, z, [&](size_t slot) {
+			float dx = slotX[slot] - x, dy = slotY[slot] - y, dz = slotZ[slot] - z;
+			float distance2 = dx * dx + dy * dy + dz * dz;
+			if (distance2 <= radius2) {
+				fn(items[slot], distance2);
+			}
+		});
+	}
+
+	//Whether a point lies within radius of (x, y, z), radius at most cellSize
+	bool anyWithin(float x, float y, float z, float radius) const {
+		if (items.empty()) {
+			return false;
+		}
+		float radius2 = radius * radius;
+		size_t center = cellOf(x, y, z);
+		for (ptrdiff_t offset : rowOffsets) {
+			size_t row = center + offset;
+			for (size_t slot = cellStarts[row], last = cellStarts[row + 3]; slot < last; ++slot) {
+				float dx = slotX[slot] - x, dy = slotY[slot] - y, dz = slotZ[slot] - z;
+				if (dx * dx + dy * dy + dz * dz <= radius2) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	/*
+	Calls fn(i, j, squared distance) once for every pair of points within
+	radius of each other, radius at most cellSize. Each cell is paired with
+	itself and the 13 cells after it: the next cell of its row, the next row
+	and the three rows of the next layer
+	*/
+	template <class Function>
+	void forEachPair(float radius, Function fn) const {
+		float radius2 = radius * radius;
+		auto pairWith = [&](size_t slot, size_t first, size_t last) {
+			float x = slotX[slot], y = slotY[slot], z = slotZ[slot];
+			for (size_t other = first; other < last; ++other) {
+				float dx = slotX[other] - x, dy = slotY[other] - y, dz = slotZ[other] - z;
+				float distance2 = dx * dx + dy * dy + dz * dz;
+				if (distance2 <= radius2) {
+					fn(items[slot], items[other], distance2);
+				}
+			}
+		};
+		size_t layer = static_cast<size_t>(cellsX) * cellsY;
+		for (size_t cell = 0; cell + 1 < cellStarts.size(); ++cell) {
+			size_t first = cellStarts[cell], last = cellStarts[cell + 1];
+			if (first == last) {
+				continue;
+			}
+			//Only cells with points are visited and those have a full layer of cells after them
+			std::array<size_t, 4> rows = {cell + cellsX - 1, cell + layer - cellsX - 1, cell + layer - 1,
+				cell + layer + cellsX - 1};
+			for (size_t slot = first; slot < last; ++slot) {
+				pairWith(slot, slot + 1, cellStarts[cell + 2]);
+				for (size_t row : rows) {
+					pairWith(slot, cellStarts[row], cellStarts[row + 3]);
+				}
+			}
+		}
+	}
+
+private:
+	//Offsets from a cell to the first cell of the nine rows around it
+	std::array<ptrdiff_t, 9> rowOffsets{};
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+Intern table mapping each distinct string to a small integer id. Id 0 is
+always the empty string, ids of other strings follow insertion order.
+Interned strings are never moved, references to them stay valid as long as
+the pool lives.
+*/
+class StringPool {
+private:
+	std::deque<std::string> strings;
+	std::unordered_map<std::string_view, uint16_t> ids;
+
+public:
+	static constexpr size_t MAX_SIZE = UINT16_MAX + 1;
+
+	StringPool();
+	//Copies rebuild the lookup, it refers to the strings of the pool it was built for
+	StringPool(const StringPool &other);
+	StringPool &operator=(const StringPool &other);
+	StringPool(StringPool &&other) = default;
+	StringPool &operator=(StringPool &&other) = default;
+
+	//Id of the string, adding it if needed. Strings past MAX_SIZE map to the empty string
+	uint16_t intern(std::string_view string);
+
+	const std::string &operator[](uint16_t id) const {
+		return strings[id];
+	}
+
+	size_t size() const {
+		return strings.size();
+	}
+
+	void clear();
+
+private:
+	void rebuildIds();
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AtomTable.h"
+#include "FrameSource.h"
+
+//Optimal rigid fit of a coordinate set onto a reference: x' = rotation * (x - mobileCenter) + referenceCenter
+struct Superposition {
+	glm::mat3 rotation = glm::mat3(1.0f);
+	glm::vec3 mobileCenter = glm::vec3(0.0f);
+	glm::vec3 referenceCenter = glm::vec3(0.0f);
+	float rmsd = 0.0f; //Over the fitted atoms, after the fit
+
+	//Transforms count atoms of 3 floats each, in and out may be the same buffer
+	void apply(const float *in, float *out, size_t count) const;
+};
+
+/*
+Least-squares superposition onto a fixed reference with the quaternion
+characteristic polynomial method (Theobald 2005, Liu 2010): the covariance of
+the centered atoms gives the RMSD from the largest root of a quartic, found by
+Newton iteration, and the rotation from the matching eigenvector, without a
+general eigen or SVD solver.
+
+The centered reference is stored as separate x/y/z arrays, and the covariance
+is summed in independent float lanes flushed to double in blocks, which
+compilers vectorize from -O2 on. fit() is thread safe; fitFrames() decodes a
+trajectory in batches and fits the frames of each batch on all threads, for
+RMSD-over-time plots and aligned playback.
+*/
+class Superposer {
+private:
+	std::vector<uint32_t> fitAtoms; //Empty to fit every atom
+	std::vector<float> referenceX;
+	std::vector<float> referenceY;
+	std::vector<float> referenceZ;
+	glm::vec3 referenceCenter;
+	double referenceNorm; //Sum of squared centered reference coordinates
+
+	void setReference(const std::vector<float> &x, const std::vector<float> &y, const std::vector<float> &z);
+
+public:
+	//Reference of 3 floats per atom, fitted on fitAtoms (every atom if empty)
+	Superposer(const float *referenceXyz, size_t atomCount, std::vector<uint32_t> fitAtoms = {});
+	Superposer(const AtomTable &reference, std::vector<uint32_t> fitAtoms = {});
+
+	size_t fittedAtomCount() const {
+		return referenceX.size();
+	}
+
+	//Fit of a coordinate set with the reference's atom order, 3 floats per atom
+	Superposition fit(const float *xyz) const;
+	//Fit of every frame of a source, frames that couldn't be read get a NaN rmsd
+	std::vector<Superposition> fitFrames(FrameSource &source, size_t batchSize = 0) const;
+
+	//RMSD of two coordinate sets of 3 floats per atom as they are, without fitting
+	static float rmsdNoFit(const float *a, const float *b, size_t count);
+};
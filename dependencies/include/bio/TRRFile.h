@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "TrajectoryFile.h"
+
+/*
+GROMACS full-precision trajectory (.trr), single or double precision. Only
+frames that store positions are indexed, velocity or force-only frames are
+skipped. Coordinates are converted from nm to angstrom.
+*/
+class TRRFile : public TrajectoryFile {
+public:
+	explicit TRRFile(const std::string &path);
+
+protected:
+	bool decodeFrame(const char *data, size_t size, float *xyz) const override;
+
+private:
+	void buildIndex();
+};
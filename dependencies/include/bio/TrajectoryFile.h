@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "FrameSource.h"
+#include "MappedFile.h"
+
+//Readers for XDR (XTC, TRR) values, which are big-endian
+inline uint32_t bigEndian32(const char *data) {
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+	return static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 |
+		static_cast<uint32_t>(bytes[2]) << 8 | bytes[3];
+}
+
+inline float bigEndianFloat(const char *data) {
+	uint32_t bits = bigEndian32(data);
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+inline double bigEndianDouble(const char *data) {
+	uint64_t bits = static_cast<uint64_t>(bigEndian32(data)) << 32 | bigEndian32(data + 4);
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/*
+Base of the binary trajectory readers. The file is memory mapped and indexed
+by the byte offset of every frame, so reading a frame is a seek plus a decode
+no matter where it is, and readFrames() decodes several frames in parallel.
+
+Formats that need a pass over the file to find the frames save the index next
+to it (path + ".offsets") and reuse it as long as the file size is unchanged.
+*/
+class TrajectoryFile : public FrameSource {
+protected:
+	MappedFile file;
+	std::vector<uint64_t> frameOffsets; //Start of every frame, plus the end of the last one
+	size_t atoms = 0;
+
+	explicit TrajectoryFile(const std::string &path);
+
+	//Restores frameOffsets and atoms from the saved index, false if there is none for this file
+	bool loadIndex(const std::string &path);
+	void saveIndex(const std::string &path) const;
+
+	//Decodes one frame starting at data, size bytes up to the next frame. Called concurrently
+	virtual bool decodeFrame(const char *data, size_t size, float *xyz) const = 0;
+
+public:
+	size_t frameCount() const override;
+	size_t atomCount() const override;
+	bool readFrame(size_t index, float *xyz) override;
+	void readFrames(const size_t *frames, float *const *outputs, bool *results, size_t count) override;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FrameSource.h"
+
+/*
+Plays the frames of a FrameSource back without stalling the render loop.
+
+A prefetch thread keeps a ring of prefetchCount + 1 coordinate buffers filled
+with the frame last asked for and the ones after it, wrapping around at the
+end for looped playback. All missing frames of that window are requested from
+the source as one batch, which random-access sources decode in parallel.
+Buffers are allocated once, so stepping through a trajectory only costs the
+decoding, which overlaps with rendering.
+
+Frames only carry coordinates: apply them with AtomTable::setCoordinates()
+and ImpostorRenderer::UpdatePositions(), colors and bonds are kept.
+*/
+class TrajectoryPlayer {
+public:
+	explicit TrajectoryPlayer(std::unique_ptr<FrameSource> source, size_t prefetchCount = 4);
+	~TrajectoryPlayer();
+
+	TrajectoryPlayer(const TrajectoryPlayer &) = delete;
+	TrajectoryPlayer &operator=(const TrajectoryPlayer &) = delete;
+
+	size_t frameCount() const;
+	size_t atomCount() const;
+	//Frames decoded ahead of the one last asked for
+	size_t prefetchCount() const;
+
+	/*
+	Coordinates of a frame, 3 floats per atom, valid until the next call of
+	frame() or tryFrame(). Waits if the frame isn't decoded yet and starts
+	prefetching the frames after it. nullptr if the frame couldn't be read.
+	*/
+	const float *frame(size_t index);
+	//Like frame(), but returns nullptr instead of waiting, for playback that drops late frames
+	const float *tryFrame(size_t index);
+
+private:
+	enum SlotState {
+		EMPTY,
+		DECODING,
+		READY,
+		FAILED
+	};
+
+	struct Slot {
+		size_t frame = 0;
+		SlotState state = EMPTY;
+		std::vector<float> xyz;
+	};
+
+	std::unique_ptr<FrameSource> source;
+	std::vector<Slot> slots;
+	size_t current = 0;
+
+	std::mutex mutex;
+	std::condition_variable wake; //Worker waits for a new current frame
+	std::condition_variable decoded; //Callers wait for a frame to finish
+	bool running = true;
+	std::thread worker;
+
+	void prefetchLoop();
+	Slot *findSlot(size_t frame);
+	bool inWindow(size_t frame) const;
+};
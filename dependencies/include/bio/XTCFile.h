@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "TrajectoryFile.h"
+
+/*
+GROMACS compressed trajectory (.xtc). Frames are located by reading only their
+headers, which carry the size of the compressed coordinates, and decompressed
+with the xdrfile integer coding. Coordinates are converted from nm to angstrom.
+*/
+class XTCFile : public TrajectoryFile {
+public:
+	explicit XTCFile(const std::string &path);
+
+protected:
+	bool decodeFrame(const char *data, size_t size, float *xyz) const override;
+
+private:
+	void buildIndex();
+};
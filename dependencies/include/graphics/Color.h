@@ -8,11 +8,17 @@
 #include <utility>
 
 #include "bio/Atom.h"
+#include "bio/Element.h"
 #include "bio/MoleculeData.h"
 
 //struct Atom;
 //class MoleculeData;
 
+//Per-atom coloring schemes of the batch kernel
+enum class ColorScheme {
+    ELEMENT, CHAIN, STRUCTURE, B_FACTOR, HYDROPHOBICITY, COUNT
+};
+
 class Color {
 private:
     static const Color HELIX_COLOR_ALPHA;
@@ -20,8 +26,17 @@ private:
     static const Color HELIX_COLOR_PI;
     static const Color HELIX_COLOR_UNDEFINED;
     static const Color SHEET_COLOR;
+    static const Color UNSTRUCTURED_COLOR;
+
+    static const Color &structureColor(SecondaryStructureIndex::Structure structure);
+    static Color gradient(float t);
+
 
 public:
+    static const char *const SCHEME_NAMES[static_cast<int>(ColorScheme::COUNT)];
+    //Color of elements without a CPK entry
+    static const Color UNKNOWN_ELEMENT_COLOR;
+
     float r = 0.0f;
     float g = 0.0f;
     float b = 0.0f;
@@ -31,8 +46,17 @@ public:
 
     static Color fromByte(unsigned char r, unsigned char g, unsigned char b);
     static Color fromName(const std::string &name);
+    //CPK colors, UNKNOWN_ELEMENT_COLOR for symbols that aren't in the table
     static Color fromElement(const std::string &element);
+    static Color fromElement(Element element);
+    //Kyte-Doolittle hydrophobicity of a residue as a blue (hydrophilic) to red (hydrophobic) gradient
+    static Color fromHydrophobicity(const std::string &residueName);
     static Color fromStructure(const Atom *atom, const MoleculeData *moleculeData);
+    //Colors every atom of the molecule by secondary structure, writing r, g, b floats per atom to rgbOut
+    //(e.g. a mapped vertex buffer), which must hold 3 * atoms.size() floats
+    static void fromStructure(const MoleculeData *moleculeData, float *rgbOut);
+    //Colors every atom with the given scheme, same output layout as the batch fromStructure
+    static void fromScheme(ColorScheme scheme, const MoleculeData *moleculeData, float *rgbOut);
 
     bool operator==(const Color &color) const;
 };
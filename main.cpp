@@ -6,12 +6,20 @@
 #include "imgui/imgui_impl_opengl3.h"
 #include "src/behavior_inspector.h"
 
+#include "src/anti_aliasing.h"
 #include "src/frame_counter.h"
+#include "src/frame_pacer.h"
+#include "src/redraw_scheduler.h"
+#include "src/gpu_timer.h"
+#include "src/render_target.h"
+#include "src/resolution_scaler.h"
 #include "src/shader.h"
+#include "src/shader_watcher.h"
 #include "src/window.h"
 #include "src/camera.h"
 #include "src/drawable_mesh.h"
 #include "src/drawable_model.h"
+#include "src/molecule_view.h"
 
 float crosshair_size;
 constexpr  float crosshair_size_max = 0.01f;
@@ -19,12 +27,18 @@ float crosshair_size_target = crosshair_size_max;
 FrameCounter frame_counter;
 bool fps_mode;
 Camera camera;
+RedrawScheduler redraw_scheduler;
+FramePacer frame_pacer;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos_arg, double ypos_arg);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void toggle_cursor(GLFWwindow* window, int key, int scancode, int action, int mods);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void char_callback(GLFWwindow* window, unsigned int codepoint);
+void window_refresh_callback(GLFWwindow* window);
 void input_processing(GLFWwindow* window);
+void input_event();
 
 Window window_object(1024, 768, framebuffer_size_callback, mouse_callback, scroll_callback, toggle_cursor);
 
@@ -37,9 +51,18 @@ int main()
     io.ConfigWindowsMoveFromTitleBarOnly = true;
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 
+    // Remaining input callbacks only mark the frame dirty, set before ImGui so its callbacks chain to them
+    glfwSetMouseButtonCallback(window_object.window, mouse_button_callback);
+    glfwSetCharCallback(window_object.window, char_callback);
+    glfwSetWindowRefreshCallback(window_object.window, window_refresh_callback);
+
     ImGui_ImplGlfw_InitForOpenGL(window_object.window, true);
     ImGui_ImplOpenGL3_Init();
 
+    // Display refresh period, part of the input-to-photon estimate
+    if (const GLFWvidmode* video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor()))
+        frame_pacer.refresh_interval = 1.0 / video_mode->refreshRate;
+
     Shader basic_shader("shaders/basic.vert", "shaders/basic.frag");
     Shader flat_shader("shaders/tex.vert", "shaders/tex_flat.frag");
     Shader blinn_shader("shaders/tex.vert", "shaders/tex_blinn.frag");
@@ -49,6 +72,14 @@ int main()
 
     std::vector<Shader*> shaders = {&flat_shader, &blinn_shader, &tex_shader, &grad_shader, &dither_shader};
 
+    // Anti-aliasing passes applied to the offscreen scene
+    AntiAliasing anti_aliasing;
+
+    // Rebuilds shaders in the background whenever their source files change
+    ShaderWatcher shader_watcher(window_object.window, {&basic_shader, &flat_shader, &blinn_shader,
+                                                        &tex_shader, &grad_shader, &dither_shader,
+                                                        &anti_aliasing.fxaa_shader, &anti_aliasing.taa_shader});
+
     // Default place holder
     objl::Loader loader;
     loader.LoadFile("resources/ball.obj");
@@ -64,8 +95,25 @@ int main()
     ModelBehaviorInspector model_behavior_inspector;
     ModelBehaviorInspector chat_window;
 
+    // Structure drawn with impostors in place of the mesh once one is loaded, with its trajectory playback
+    MoleculeView molecule_view;
+
+    // GPU timing of the whole frame and of the 3D scene alone
+    GpuTimer frame_timer;
+    GpuTimer scene_timer;
+
+    // Offscreen target for rendering the scene below native resolution
+    RenderTarget scene_target;
+    ResolutionScaler resolution_scaler;
+
     while (!glfwWindowShouldClose(window_object.window))
     {
+        // Keep the GPU queue short and apply the frame limit before any input is looked at
+        frame_pacer.low_latency = model_behavior_inspector.low_latency;
+        frame_pacer.max_frames_ahead = model_behavior_inspector.max_frames_ahead;
+        frame_pacer.frame_limit = model_behavior_inspector.frame_limit;
+        frame_pacer.begin_frame();
+
         // Init a new frame for ImGui library for OpenGL and GLFW
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -74,8 +122,19 @@ int main()
         // Handles user input from keyboard and mouse events
         input_processing(window_object.window);
 
+        // Swap in any shader programs rebuilt since the last frame
+        if (shader_watcher.update())
+            redraw_scheduler.request();
+
         // Display information related to the objects via UI elements
         model_behavior_inspector.render(window_object, camera, models_list);
+        if (molecule_view.render_ui(camera))
+            redraw_scheduler.request();
+
+        // In low latency mode input is sampled as late as possible, right before the camera is updated
+        if (frame_pacer.low_latency)
+            glfwPollEvents();
+        frame_pacer.sample_input();
 
         // Update camera object
         camera.Update(frame_counter.deltaTime);
@@ -83,6 +142,45 @@ int main()
         // Tracking frame timing information
         frame_counter.update(false);
 
+        // Stream the next trajectory frame into the atom table and the impostor instances
+        if (molecule_view.update(frame_counter.deltaTime))
+            redraw_scheduler.request();
+
+        // Keep drawing while something on screen moves by itself, TAA needs a full jitter cycle to converge
+        redraw_scheduler.enabled = model_behavior_inspector.on_demand_redraw;
+        redraw_scheduler.settle_frames = anti_aliasing.mode == AntiAliasingMode::TAA ? 8 : 3;
+        const Shader *current_shader = shaders[model_behavior_inspector.current_shader];
+        bool animated = model_behavior_inspector.rotatable || molecule_view.playing ||
+                        current_shader == &grad_shader || current_shader == &dither_shader;
+        if (animated || !camera.IsSettled())
+            redraw_scheduler.request();
+
+        frame_timer.begin();
+
+        // With dynamic resolution or anti-aliasing the scene goes to an offscreen target,
+        // its resolution is picked from the GPU frame time when dynamic resolution is on
+        anti_aliasing.mode = AntiAliasingMode(model_behavior_inspector.anti_aliasing);
+        int framebuffer_width = window_object.framebuffer_width;
+        int framebuffer_height = window_object.framebuffer_height;
+        bool offscreen = (model_behavior_inspector.dynamic_resolution || anti_aliasing.mode != AntiAliasingMode::OFF)
+                         && framebuffer_width > 0 && framebuffer_height > 0;
+        if (model_behavior_inspector.dynamic_resolution)
+            resolution_scaler.update(frame_timer.milliseconds, model_behavior_inspector.target_fps);
+        else
+            resolution_scaler.scale = 1.0f;
+        int scene_width = framebuffer_width;
+        int scene_height = framebuffer_height;
+        if (offscreen)
+        {
+            scene_target.resize(framebuffer_width, framebuffer_height);
+            scene_width = resolution_scaler.scaled(framebuffer_width);
+            scene_height = resolution_scaler.scaled(framebuffer_height);
+            anti_aliasing.begin_scene(scene_target, scene_width, scene_height);
+        }
+        model_behavior_inspector.render_scale = resolution_scaler.scale;
+
+        scene_timer.begin();
+
         // Retrieves background color from property_inspector
         auto color = model_behavior_inspector.background_color;
 
@@ -127,11 +225,14 @@ int main()
         matrix_model = glm::scale(matrix_model, glm::vec3(scale[0], scale[1], scale[2]));
 
         // Camera Projection Setup - creates a perspective projection matrix
-        glm::mat4 projection = glm::perspective(
+        glm::mat4 unjittered_projection = glm::perspective(
                 glm::radians(camera.Zoom), window_object.get_aspect_ratio(), 0.1f, 1000.0f);
 
+        // TAA shifts the projection by a sub-pixel offset every frame
+        glm::mat4 projection = anti_aliasing.jitter(unjittered_projection, scene_width, scene_height);
+
         // Shader setup and Model rendering
-        Shader this_shader = *shaders[model_behavior_inspector.current_shader]; // Choose the current shader
+        const Shader &this_shader = *shaders[model_behavior_inspector.current_shader]; // Choose the current shader
         this_shader.use(); // Activates the selected shader
 
         // Sets shader uniforms: time, model, view, projection, fps_mode, camPos
@@ -142,8 +243,17 @@ int main()
         const glm::vec3 camPos = fps_mode ? camera.Position : camera.OrbitPosition;
         this_shader.setVec3("camPos", camPos);
 
-        // Renders the current model
-        models_list[model_behavior_inspector.current_model]->Draw();
+        // Renders the loaded molecule, or the current model without one
+        // Chains get the detail of their distance first, from the pixels an angstrom covers in the scene.
+        // Cartoon meshes are drawn with the current shader like the models
+        if (molecule_view.loaded())
+        {
+            float pixels_per_unit = CoarseGrain::pixelsPerUnit(camera.Zoom, float(scene_height));
+            molecule_view.update_level_of_detail(matrix_model, camPos, pixels_per_unit);
+            molecule_view.draw(matrix_model, camera.GetViewMatrix(!fps_mode), projection);
+        }
+        else
+            models_list[model_behavior_inspector.current_model]->Draw();
 
         basic_shader.use(); // Activates the basic shader
 
@@ -160,17 +270,55 @@ int main()
         basic_shader.setMat4("model", matrix_model);
         defaultObject.Draw();
 
+        scene_timer.end();
+
+        // Anti-alias, then upscale the scene to the window.
+        // The UI is drawn on top at native resolution so text stays crisp
+        if (offscreen)
+        {
+            const RenderTarget &final_target = anti_aliasing.resolve(
+                    scene_target, scene_width, scene_height, unjittered_projection * camera.GetViewMatrix(!fps_mode));
+            final_target.blit_to_screen(scene_width, scene_height, framebuffer_width, framebuffer_height);
+        }
+
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
+        frame_timer.end();
+        model_behavior_inspector.gpu_frame_ms = frame_timer.milliseconds;
+        model_behavior_inspector.gpu_scene_ms = scene_timer.milliseconds;
+        model_behavior_inspector.gpu_anti_aliasing_ms = offscreen ? anti_aliasing.timer.milliseconds : 0.0f;
+        model_behavior_inspector.anti_aliasing_cost_ms[model_behavior_inspector.anti_aliasing] =
+                model_behavior_inspector.gpu_scene_ms + model_behavior_inspector.gpu_anti_aliasing_ms;
+
+        redraw_scheduler.frame_rendered();
+
         glfwSwapBuffers(window_object.window);
-        glfwPollEvents();
+        frame_pacer.end_frame();
+        model_behavior_inspector.input_to_photon_ms = frame_pacer.input_to_photon_ms;
+        model_behavior_inspector.throttle_wait_ms = frame_pacer.throttle_wait_ms;
+        model_behavior_inspector.cpu_frame_ms = frame_pacer.cpu_frame_ms;
+
+        if (!frame_pacer.low_latency)
+            glfwPollEvents();
+
+        // In on-demand mode sleep until an event or a background result needs a new frame
+        bool idled = false;
+        while (!redraw_scheduler.needs_redraw() && !shader_watcher.has_pending() &&
+               !glfwWindowShouldClose(window_object.window))
+        {
+            glfwWaitEventsTimeout(redraw_scheduler.idle_timeout);
+            idled = true;
+        }
+        if (idled)
+            frame_counter.resume();
     }
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
+    frame_pacer.release();
     glfwTerminate();
     return 0;
 }
@@ -191,6 +339,7 @@ void unfocus(GLFWwindow* window)
 }
 
 void toggle_cursor(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    input_event();
     if (key == GLFW_KEY_GRAVE_ACCENT && action == GLFW_PRESS) {
         fps_mode = !fps_mode;
         if (fps_mode)
@@ -222,6 +371,11 @@ void input_processing(GLFWwindow* window)
         if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
             dt += 5.0f; // Increase speed if Shift key is held
 
+        // Held movement keys only send sparse repeat events, keep drawing while any is down
+        for (int key : {GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E})
+            if (glfwGetKey(window, key) == GLFW_PRESS)
+                redraw_scheduler.request();
+
         if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
             camera.ProcessKeyboard(FORWARD, dt);
         if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
@@ -241,6 +395,8 @@ float last_X, last_Y;
 
 void mouse_callback(GLFWwindow* window, double xpos_arg, double ypos_arg)
 {
+    input_event();
+
     float x_pos = static_cast<float>(xpos_arg);
     float y_pos = static_cast<float>(ypos_arg);
 
@@ -265,10 +421,35 @@ void mouse_callback(GLFWwindow* window, double xpos_arg, double ypos_arg)
 
 void scroll_callback(GLFWwindow* window, double x_offset, double y_offset)
 {
+    input_event();
     camera.ProcessMouseScroll(y_offset, !fps_mode);
 }
 
+// Every input event needs a redraw and starts the input-to-photon clock
+void input_event()
+{
+    redraw_scheduler.request();
+    frame_pacer.note_input();
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    input_event();
+}
+
+void char_callback(GLFWwindow* window, unsigned int codepoint)
+{
+    input_event();
+}
+
+void window_refresh_callback(GLFWwindow* window)
+{
+    redraw_scheduler.request();
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
+    window_object.on_framebuffer_resize(width, height);
+    redraw_scheduler.request();
     glViewport(0, 0, width, height);
 };
@@ -0,0 +1,167 @@
+#include "anti_aliasing.h"
+
+#include <algorithm>
+
+const char *AntiAliasing::MODE_NAMES = "Off\0MSAA 2x\0MSAA 4x\0MSAA 8x\0FXAA\0TAA\0";
+
+// Low discrepancy sequence for the TAA sub-pixel offsets, in [0, 1)
+static float halton(unsigned int index, unsigned int base)
+{
+    float result = 0.0f;
+    float fraction = 1.0f / float(base);
+    while (index > 0)
+    {
+        result += fraction * float(index % base);
+        index /= base;
+        fraction /= float(base);
+    }
+    return result;
+}
+
+AntiAliasing::AntiAliasing()
+    : fxaa_shader("shaders/fullscreen.vert", "shaders/fxaa.frag"),
+      taa_shader("shaders/fullscreen.vert", "shaders/taa.frag")
+{
+    glGenVertexArrays(1, &empty_vao);
+}
+
+AntiAliasing::~AntiAliasing()
+{
+    glDeleteVertexArrays(1, &empty_vao);
+}
+
+int AntiAliasing::sample_count() const
+{
+    int requested = 0;
+    switch (mode)
+    {
+        case AntiAliasingMode::MSAA_2X: requested = 2; break;
+        case AntiAliasingMode::MSAA_4X: requested = 4; break;
+        case AntiAliasingMode::MSAA_8X: requested = 8; break;
+        default: return 0;
+    }
+
+    GLint max_samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+    return std::min(requested, int(max_samples));
+}
+
+glm::mat4 AntiAliasing::jitter(const glm::mat4 &projection, int width, int height) const
+{
+    if (mode != AntiAliasingMode::TAA)
+        return projection;
+
+    // 8 sample Halton(2, 3) pattern, offsets of up to half a pixel in NDC
+    unsigned int index = frame_index % 8 + 1;
+    float x = (halton(index, 2) - 0.5f) * 2.0f / float(width);
+    float y = (halton(index, 3) - 0.5f) * 2.0f / float(height);
+
+    glm::mat4 jittered = projection;
+    jittered[2][0] += x;
+    jittered[2][1] += y;
+    return jittered;
+}
+
+void AntiAliasing::begin_scene(RenderTarget &scene_target, int width, int height)
+{
+    if (mode != previous_mode)
+    {
+        history_valid = false;
+        previous_mode = mode;
+    }
+
+    int samples = sample_count();
+    if (samples > 0)
+    {
+        msaa_target.resize(scene_target.width, scene_target.height, samples);
+        msaa_target.bind(width, height);
+    }
+    else
+    {
+        scene_target.bind(width, height);
+    }
+}
+
+void AntiAliasing::draw_fullscreen(const Shader &shader, const RenderTarget &source, int width, int height) const
+{
+    shader.use();
+    shader.setVec2("uvScale", float(width) / float(source.width), float(height) / float(source.height));
+    shader.setVec2("texelSize", 1.0f / float(source.width), 1.0f / float(source.height));
+
+    GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(empty_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    if (depth_test)
+        glEnable(GL_DEPTH_TEST);
+}
+
+const RenderTarget &AntiAliasing::resolve(RenderTarget &scene_target, int width, int height,
+                                          const glm::mat4 &view_projection)
+{
+    timer.begin();
+    const RenderTarget *result = &scene_target;
+
+    switch (mode)
+    {
+        case AntiAliasingMode::MSAA_2X:
+        case AntiAliasingMode::MSAA_4X:
+        case AntiAliasingMode::MSAA_8X:
+            msaa_target.resolve_into(scene_target, width, height);
+            break;
+
+        case AntiAliasingMode::FXAA:
+            post_target.resize(scene_target.width, scene_target.height);
+            post_target.bind(width, height);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, scene_target.color_texture);
+            fxaa_shader.use();
+            fxaa_shader.setInt("screenTexture", 0);
+            draw_fullscreen(fxaa_shader, scene_target, width, height);
+            result = &post_target;
+            break;
+
+        case AntiAliasingMode::TAA:
+        {
+            RenderTarget &previous = history[history_index];
+            RenderTarget &next = history[1 - history_index];
+            if (previous.width != scene_target.width || previous.height != scene_target.height)
+                history_valid = false;
+            previous.resize(scene_target.width, scene_target.height);
+            next.resize(scene_target.width, scene_target.height);
+
+            next.bind(width, height);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, scene_target.color_texture);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, previous.color_texture);
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, scene_target.depth_texture);
+            glActiveTexture(GL_TEXTURE0);
+
+            taa_shader.use();
+            taa_shader.setInt("currentTexture", 0);
+            taa_shader.setInt("historyTexture", 1);
+            taa_shader.setInt("depthTexture", 2);
+            taa_shader.setMat4("reprojection", previous_view_projection * glm::inverse(view_projection));
+            taa_shader.setFloat("blend", history_valid ? 0.1f : 1.0f);
+            taa_shader.setVec2("historyUvScale", history_uv_scale.x, history_uv_scale.y);
+            draw_fullscreen(taa_shader, scene_target, width, height);
+
+            history_index = 1 - history_index;
+            history_valid = true;
+            history_uv_scale = glm::vec2(float(width) / float(next.width), float(height) / float(next.height));
+            previous_view_projection = view_projection;
+            result = &next;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    frame_index++;
+    timer.end();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return *result;
+}
@@ -0,0 +1,74 @@
+#ifndef OPENGL_MODEL_VIEWER_ANTI_ALIASING_H
+#define OPENGL_MODEL_VIEWER_ANTI_ALIASING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gpu_timer.h"
+#include "render_target.h"
+#include "shader.h"
+
+enum class AntiAliasingMode {
+    OFF,
+    MSAA_2X,
+    MSAA_4X,
+    MSAA_8X,
+    FXAA,
+    TAA,
+    COUNT
+};
+
+/*
+ * Selectable anti-aliasing for the offscreen scene.
+ * MSAA renders into a multisampled target that is resolved afterwards, FXAA is a single post-process pass
+ * and TAA jitters the projection every frame and accumulates the frames through depth-based reprojection
+ */
+class AntiAliasing {
+public:
+    AntiAliasing();
+    ~AntiAliasing();
+
+    AntiAliasingMode mode = AntiAliasingMode::OFF;
+
+    // Combo box labels, in AntiAliasingMode order
+    static const char *MODE_NAMES;
+
+    // GPU time of the resolve/post-process passes. It runs inside the frame timer, which GpuTimer's timestamp
+    // queries allow (GL_TIME_ELAPSED queries can't nest)
+    GpuTimer timer;
+
+    // Post-processing programs, exposed so they can be hot-reloaded
+    Shader fxaa_shader;
+    Shader taa_shader;
+
+    // Applies this frame's sub-pixel jitter to the projection when TAA is active
+    glm::mat4 jitter(const glm::mat4 &projection, int width, int height) const;
+
+    // Binds the framebuffer the scene has to be drawn into
+    void begin_scene(RenderTarget &scene_target, int width, int height);
+
+    // Runs the anti-aliasing passes over the drawn scene and returns the target holding the result.
+    // view_projection must be unjittered, TAA uses it to reproject its history
+    const RenderTarget &resolve(RenderTarget &scene_target, int width, int height, const glm::mat4 &view_projection);
+
+    // Drops the TAA history, e.g. after a camera cut
+    void reset_history() { history_valid = false; }
+
+private:
+    int sample_count() const;
+    void draw_fullscreen(const Shader &shader, const RenderTarget &source, int width, int height) const;
+
+    unsigned int empty_vao = 0; // Core profile needs a VAO bound even for attribute-less draws
+
+    RenderTarget msaa_target;
+    RenderTarget post_target;
+    RenderTarget history[2];
+    int history_index = 0;
+    bool history_valid = false;
+    glm::vec2 history_uv_scale = glm::vec2(1.0f);
+    glm::mat4 previous_view_projection = glm::mat4(1.0f);
+    unsigned int frame_index = 0;
+    AntiAliasingMode previous_mode = AntiAliasingMode::OFF;
+};
+
+#endif //OPENGL_MODEL_VIEWER_ANTI_ALIASING_H
@@ -4,7 +4,9 @@
 #include "imgui/imgui.h"
 #include "drawable_model.h"
 
-void ModelBehaviorInspector::render(Window windowObj, Camera& camera,
+#include <cstring>
+
+void ModelBehaviorInspector::render(Window &windowObj, Camera& camera,
                                std::vector<DrawableModel*> &models) {
 
     ImGuiIO& io = ImGui::GetIO();
@@ -104,9 +106,15 @@ void ModelBehaviorInspector::render(Window windowObj, Camera& camera,
 
     if (ImGui::BeginPopup("statistics_popup"))
     {
-        ImGui::BulletText("Statistic data 1");
-        ImGui::BulletText("Statistic data 2");
-        ImGui::BulletText("Statistic data 3");
+        ImGui::BulletText("CPU frame: %.2f ms", cpu_frame_ms);
+        ImGui::BulletText("Pacing wait: %.2f ms", throttle_wait_ms);
+        ImGui::BulletText("Input to photon (est.): %.1f ms", input_to_photon_ms);
+        ImGui::BulletText("GPU frame: %.2f ms", gpu_frame_ms);
+        ImGui::BulletText("GPU scene: %.2f ms", gpu_scene_ms);
+        ImGui::BulletText("GPU anti-aliasing: %.2f ms", gpu_anti_aliasing_ms);
+        ImGui::BulletText("Render scale: %.0f%% (%dx%d)", render_scale * 100.0f,
+                          int(windowObj.framebuffer_width * render_scale),
+                          int(windowObj.framebuffer_height * render_scale));
         ImGui::EndPopup();
     }
 
@@ -132,6 +140,37 @@ void ModelBehaviorInspector::render(Window windowObj, Camera& camera,
         ImGui::Checkbox("Animate", &rotatable);
     }
 
+    if (ImGui::CollapsingHeader("Performance"))
+    {
+        if (ImGui::Checkbox("VSync", &vsync))
+            windowObj.set_vsync(vsync);
+
+        ImGui::Checkbox("Redraw On Demand", &on_demand_redraw);
+        ImGui::Checkbox("Low Latency", &low_latency);
+        if (low_latency)
+            ImGui::SliderInt("Max Frames Ahead", &max_frames_ahead, 0, 3);
+        ImGui::SliderInt("Frame Limit", &frame_limit, 0, 240, frame_limit == 0 ? "Off" : "%d FPS");
+        ImGui::Checkbox("Dynamic Resolution", &dynamic_resolution);
+        if (dynamic_resolution)
+        {
+            ImGui::SliderInt("Target FPS", &target_fps, 15, 144);
+            ImGui::Text("Render Scale: %.0f%%", render_scale * 100.0f);
+        }
+        ImGui::Combo("Anti-Aliasing", &anti_aliasing, AntiAliasing::MODE_NAMES);
+
+        ImGui::Text("GPU Frame Time: %.2f ms", gpu_frame_ms);
+        ImGui::Text("Input to Photon (est.): %.1f ms", input_to_photon_ms);
+
+        // Scene + anti-aliasing cost of each mode, as last measured while it was active
+        const char *mode_name = AntiAliasing::MODE_NAMES;
+        for (int i = 0; i < int(AntiAliasingMode::COUNT); ++i)
+        {
+            if (anti_aliasing_cost_ms[i] > 0.0f)
+                ImGui::BulletText("%s: %.2f ms", mode_name, anti_aliasing_cost_ms[i]);
+            mode_name += strlen(mode_name) + 1;
+        }
+    }
+
     ImGui::End();
 
     ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x, 18), 0, ImVec2(1.0f, 0));
@@ -5,6 +5,7 @@
 #include "imgui/imgui.h"
 #include "camera.h"
 #include "drawable_model.h"
+#include "anti_aliasing.h"
 
 /*
  * Hold properties and settings related to visual representation and behavior of models
@@ -25,7 +26,28 @@ struct ModelBehaviorInspector {
     int current_model = 0;
     int current_shader = 0;
 
-    void render(Window windowObj, Camera &camera, std::vector<DrawableModel*> &models);
+    // Performance settings
+    bool vsync = true;
+    bool on_demand_redraw = false; // Only draw when something changed instead of continuously
+    bool low_latency = false; // Late input sampling and a short GPU queue
+    int max_frames_ahead = 1;
+    int frame_limit = 0; // 0 for unlimited
+    bool dynamic_resolution = false; // Render the scene at a resolution that holds target_fps
+    int target_fps = 60;
+    int anti_aliasing = int(AntiAliasingMode::OFF);
+
+    // Frame statistics, filled in by the render loop
+    float render_scale = 1.0f;
+    float gpu_frame_ms = 0.0f;
+    float gpu_scene_ms = 0.0f;
+    float gpu_anti_aliasing_ms = 0.0f;
+    float cpu_frame_ms = 0.0f;
+    float throttle_wait_ms = 0.0f;
+    float input_to_photon_ms = 0.0f; // Estimate
+    // Last measured scene + anti-aliasing cost of every mode, for comparison
+    float anti_aliasing_cost_ms[int(AntiAliasingMode::COUNT)] = {};
+
+    void render(Window &windowObj, Camera &camera, std::vector<DrawableModel*> &models);
 };
 
 
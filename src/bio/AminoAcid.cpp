@@ -1,5 +1,10 @@
 #include "bio/AminoAcid.h"
 
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+
 //These shared pointers won't ever reach a use count of 0
 std::shared_ptr<const AminoAcid> alanine       (new AminoAcid("ALANINE",       "A", "ALA", "C3H7NO2",    "000"));
 std::shared_ptr<const AminoAcid> arginine      (new AminoAcid("ARGININE",      "R", "ARG", "C6H14N4O2",  "110"));
@@ -22,28 +27,112 @@ std::shared_ptr<const AminoAcid> tryptophan    (new AminoAcid("TRYPTOPHAN",    "
 std::shared_ptr<const AminoAcid> tyrosine      (new AminoAcid("TYROSINE",      "Y", "TYR", "C9H11NO3",   "100"));
 std::shared_ptr<const AminoAcid> valine        (new AminoAcid("VALINE",        "V", "VAL", "C5H11NO2",   "000"));
 
-std::unordered_map<std::string, std::shared_ptr<const AminoAcid>> AminoAcid::dict = {
-	{ "ALANINE",       alanine       }, { "ALA", alanine       }, { "A", alanine       },
-	{ "ARGININE",      arginine      }, { "ARG", arginine      }, { "R", arginine      },
-	{ "ASPARAGINE",    asparagine    }, { "ASN", asparagine    }, { "N", asparagine    },
-	{ "ASPARTIC_ACID", asparticAcid  }, { "ASP", asparticAcid  }, { "D", asparticAcid  },
-	{ "CYSTEINE",      cysteine      }, { "CYS", cysteine      }, { "C", cysteine      },
-	{ "GLUTAMINE",     glutamine     }, { "GLN", glutamine     }, { "Q", glutamine     },
-	{ "GLUTAMIC_ACID", glutamicAcid  }, { "GLU", glutamicAcid  }, { "E", glutamicAcid  },
-	{ "GLYCINE",       glycine       }, { "GLY", glycine       }, { "G", glycine       },
-	{ "HISTIDINE",     histidine     }, { "HIS", histidine     }, { "H", histidine     },
-	{ "ISOLEUCINE",    isoleucine    }, { "ILE", isoleucine    }, { "I", isoleucine    },
-	{ "LEUCINE",       leucine       }, { "LEU", leucine       }, { "L", leucine       },
-	{ "LYSINE",        lysine        }, { "LYS", lysine        }, { "K", lysine        },
-	{ "METHIONINE",    methionine    }, { "MET", methionine    }, { "M", methionine    },
-	{ "PHENYLALANINE", phenylalanine }, { "PHE", phenylalanine }, { "F", phenylalanine },
-	{ "PROLINE",       proline       }, { "PRO", proline       }, { "P", proline       },
-	{ "SERINE",        serine        }, { "SER", serine        }, { "S", serine        },
-	{ "THREONINE",     threonine     }, { "THR", threonine     }, { "T", threonine     },
-	{ "TRYPTOPHAN",    tryptophan    }, { "TRP", tryptophan    }, { "W", tryptophan    },
-	{ "TYROSINE",      tyrosine      }, { "TYR", tyrosine      }, { "Y", tyrosine      },
-	{ "VALINE",        valine        }, { "VAL", valine        }, { "V", valine        },
+namespace {
+
+//Standard amino acids in the order of STANDARD_KEYS
+const std::shared_ptr<const AminoAcid> STANDARD_AMINO_ACIDS[] = {
+	alanine, arginine, asparagine, asparticAcid, cysteine, glutamine, glutamicAcid,
+	glycine, histidine, isoleucine, leucine, lysine, methionine, phenylalanine,
+	proline, serine, threonine, tryptophan, tyrosine, valine
+};
+
+//Full name, 1-letter and 3-letter code of each standard amino acid, key i belongs to amino acid i / 3
+constexpr std::string_view STANDARD_KEYS[] = {
+	"ALANINE",       "A", "ALA",
+	"ARGININE",      "R", "ARG",
+	"ASPARAGINE",    "N", "ASN",
+	"ASPARTIC_ACID", "D", "ASP",
+	"CYSTEINE",      "C", "CYS",
+	"GLUTAMINE",     "Q", "GLN",
+	"GLUTAMIC_ACID", "E", "GLU",
+	"GLYCINE",       "G", "GLY",
+	"HISTIDINE",     "H", "HIS",
+	"ISOLEUCINE",    "I", "ILE",
+	"LEUCINE",       "L", "LEU",
+	"LYSINE",        "K", "LYS",
+	"METHIONINE",    "M", "MET",
+	"PHENYLALANINE", "F", "PHE",
+	"PROLINE",       "P", "PRO",
+	"SERINE",        "S", "SER",
+	"THREONINE",     "T", "THR",
+	"TRYPTOPHAN",    "W", "TRP",
+	"TYROSINE",      "Y", "TYR",
+	"VALINE",        "V", "VAL"
 };
+constexpr size_t STANDARD_KEY_COUNT = sizeof(STANDARD_KEYS) / sizeof(STANDARD_KEYS[0]);
+static_assert(STANDARD_KEY_COUNT == 3 * sizeof(STANDARD_AMINO_ACIDS) / sizeof(STANDARD_AMINO_ACIDS[0]),
+	"Every standard amino acid needs a name, 1-letter and 3-letter key");
+
+/*
+Perfect hash over STANDARD_KEYS: seeded FNV-1a into a table 8x larger than
+the key set, with the first seed that maps every key to its own slot found at
+compile time. A lookup is one hash, one slot read and one string compare.
+*/
+constexpr size_t HASH_TABLE_SIZE = 512;
+
+constexpr uint32_t hashKey(std::string_view key, uint32_t seed) {
+	uint32_t hash = 2166136261u ^ seed;
+	for (char c : key) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+	}
+	return hash ^ (hash >> 15);
+}
+
+constexpr bool isPerfect(uint32_t seed) {
+	bool used[HASH_TABLE_SIZE] = {};
+	for (size_t i = 0; i < STANDARD_KEY_COUNT; ++i) {
+		size_t slot = hashKey(STANDARD_KEYS[i], seed) % HASH_TABLE_SIZE;
+		if (used[slot]) {
+			return false;
+		}
+		used[slot] = true;
+	}
+	return true;
+}
+
+constexpr uint32_t findSeed() {
+	for (uint32_t seed = 1; seed < 10000; ++seed) {
+		if (isPerfect(seed)) {
+			return seed;
+		}
+	}
+	return 0;
+}
+
+constexpr uint32_t HASH_SEED = findSeed();
+static_assert(HASH_SEED != 0, "No perfect hash seed for the standard amino acid keys");
+
+//Key index + 1 in every used slot, 0 for empty slots
+constexpr std::array<uint8_t, HASH_TABLE_SIZE> buildHashTable() {
+	std::array<uint8_t, HASH_TABLE_SIZE> table{};
+	for (size_t i = 0; i < STANDARD_KEY_COUNT; ++i) {
+		table[hashKey(STANDARD_KEYS[i], HASH_SEED) % HASH_TABLE_SIZE] = static_cast<uint8_t>(i + 1);
+	}
+	return table;
+}
+
+constexpr std::array<uint8_t, HASH_TABLE_SIZE> HASH_TABLE = buildHashTable();
+
+//Index into STANDARD_KEYS, -1 if the name isn't a standard key
+constexpr int standardKeyIndex(std::string_view name) {
+	uint8_t entry = HASH_TABLE[hashKey(name, HASH_SEED) % HASH_TABLE_SIZE];
+	return entry != 0 && STANDARD_KEYS[entry - 1] == name ? entry - 1 : -1;
+}
+
+static_assert(standardKeyIndex("TRP") == 53 && standardKeyIndex("V") == 58 && standardKeyIndex("HOH") == -1,
+	"Standard amino acid hash table is broken");
+
+const AminoAcid *findStandard(std::string_view name) {
+	int index = standardKeyIndex(name);
+	return index < 0 ? nullptr : STANDARD_AMINO_ACIDS[index / 3].get();
+}
+
+}
+
+std::unordered_map<std::string, std::shared_ptr<const AminoAcid>> AminoAcid::registry;
+std::vector<std::shared_ptr<const AminoAcid>> AminoAcid::retired;
+std::shared_mutex AminoAcid::registryMutex;
+std::atomic<bool> AminoAcid::standardShadowed{false};
 
 void AminoAcid::overwriteWarn(const std::string &name) {
 	if (get(name)) {
@@ -77,12 +166,40 @@ bool AminoAcid::containsSulfur() const {
 }
 
 const AminoAcid *AminoAcid::get(const std::string &name) {
-	const AminoAcid *result = nullptr;
-	try {
-		result = dict.at(name).get();
+	const AminoAcid *standard = findStandard(name);
+	//Registry entries only need to be checked for standard keys once one was overwritten or erased
+	if (standard && !standardShadowed.load(std::memory_order_acquire)) {
+		return standard;
+	}
+
+	std::shared_lock<std::shared_mutex> lock(registryMutex);
+	auto entry = registry.find(name);
+	if (entry != registry.end()) {
+		return entry->second.get();
+	}
+	return standard;
+}
+
+const AminoAcid *AminoAcid::getOrAdd(const std::string &name, bool &added) {
+	added = false;
+	const AminoAcid *aminoAcid = get(name);
+	if (aminoAcid || name.empty()) {
+		return aminoAcid;
 	}
-	catch (...) {}
-	return result;
+
+	std::unique_lock<std::shared_mutex> lock(registryMutex);
+	//Another thread may have added it in between
+	auto entry = registry.find(name);
+	if (entry != registry.end() && entry->second) {
+		return entry->second.get();
+	}
+	std::shared_ptr<const AminoAcid> created(new AminoAcid(name, "", "", "", ""));
+	registry[name] = created;
+	if (findStandard(name)) {
+		standardShadowed.store(true, std::memory_order_release);
+	}
+	added = true;
+	return created.get();
 }
 
 const AminoAcid *AminoAcid::set(
@@ -132,14 +249,18 @@ const AminoAcid *AminoAcid::set(
 			properties
 		)
 	);
-	if (!name.empty()) {
-		dict[name] = aminoAcid;
-	}
-	if (!abbr1.empty()) {
-		dict[abbr1] = aminoAcid;
-	}
-	if (!abbr3.empty()) {
-		dict[abbr3] = aminoAcid;
+	std::unique_lock<std::shared_mutex> lock(registryMutex);
+	for (const std::string *key : {&name, &abbr1, &abbr3}) {
+		if (!key->empty()) {
+			std::shared_ptr<const AminoAcid> &entry = registry[*key];
+			if (entry) {
+				retired.push_back(std::move(entry));
+			}
+			entry = aminoAcid;
+			if (findStandard(*key)) {
+				standardShadowed.store(true, std::memory_order_release);
+			}
+		}
 	}
 	return aminoAcid.get();
 }
@@ -149,33 +270,57 @@ void AminoAcid::erase(const AminoAcid *aminoAcid) {
 	std::string abbr1 = aminoAcid->abbr1;
 	std::string abbr3 = aminoAcid->abbr3;
 
-	if (get(name)) {
-		dict.erase(name);
-	}
-	if (get(abbr1)) {
-		dict.erase(abbr1);
-	}
-	if (get(abbr3)) {
-		dict.erase(abbr3);
-	}
+	erase(name);
+	erase(abbr1);
+	erase(abbr3);
 }
 
 void AminoAcid::erase(const std::string &name) {
-	if (get(name)) {
-		dict.erase(name);
+	if (!get(name)) {
+		return;
+	}
+	std::unique_lock<std::shared_mutex> lock(registryMutex);
+	auto entry = registry.find(name);
+	if (entry != registry.end() && entry->second) {
+		retired.push_back(std::move(entry->second));
+	}
+	if (findStandard(name)) {
+		//Standard entries can't be removed from the static table, hide them behind an empty entry
+		registry[name] = nullptr;
+		standardShadowed.store(true, std::memory_order_release);
+	}
+	else {
+		registry.erase(name);
 	}
 }
 
 void AminoAcid::showDict() {
 	const unsigned int PADDING = 4;
 
+	//Snapshot of every visible key: standard keys that weren't replaced, then the registry
+	std::vector<std::pair<std::string, const AminoAcid*>> entries;
+	{
+		std::shared_lock<std::shared_mutex> lock(registryMutex);
+		for (size_t i = 0; i < STANDARD_KEY_COUNT; ++i) {
+			std::string key(STANDARD_KEYS[i]);
+			if (registry.find(key) == registry.end()) {
+				entries.emplace_back(key, STANDARD_AMINO_ACIDS[i / 3].get());
+			}
+		}
+		for (const auto &pair : registry) {
+			if (pair.second) {
+				entries.emplace_back(pair.first, pair.second.get());
+			}
+		}
+	}
+
 	//Initialize max sizes to sizes of column labels
 	size_t maxKeySize = 3 + PADDING;
 	size_t maxNameSize = 4 + PADDING;
 	size_t maxFormulaSize = 7 + PADDING;
 
 	//Increase sizes to fit largest elements
-	for (const auto &pair : dict) {
+	for (const auto &pair : entries) {
 		if (pair.first.size() + PADDING > maxKeySize) {
 			maxKeySize = pair.first.size() + PADDING;
 		}
@@ -200,7 +345,7 @@ void AminoAcid::showDict() {
 	std::cout << std::left << std::setw(maxFormulaSize) << std::setfill(SEPARATOR) << "formula";
 	std::cout << std::left << std::setw(PROPERTIES_SIZE) << std::setfill(SEPARATOR) << "properties";
 	std::cout << '\n';
-	for (const auto &pair : dict) {
+	for (const auto &pair : entries) {
 		std::cout << std::left << std::setw(maxKeySize) << std::setfill(SEPARATOR) << pair.first;
 		std::cout << std::left << std::setw(maxNameSize) << std::setfill(SEPARATOR) << pair.second->name;
 		std::cout << std::left << std::setw(ABBR_1_SIZE) << std::setfill(SEPARATOR) << pair.second->abbr1;
@@ -0,0 +1,161 @@
+#include "bio/AtomTable.h"
+
+#include <iostream>
+
+#include "bio/Parallel.h"
+
+namespace {
+
+//Codes for multi-character identifiers and taken characters, readable ones first.
+//Upper case comes last as single character chains mostly use it
+const char CHAIN_CODE_ORDER[] = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+}
+
+AtomTable::AtomTable() {
+	chainIndexOf.fill(-1);
+}
+
+void AtomTable::reserve(size_t atomCount) {
+	x.reserve(atomCount);
+	y.reserve(atomCount);
+	z.reserve(atomCount);
+	bFactors.reserve(atomCount);
+	nameIds.reserve(atomCount);
+	elementIds.reserve(atomCount);
+	residueIndices.reserve(atomCount);
+}
+
+void AtomTable::clear() {
+	x.clear();
+	y.clear();
+	z.clear();
+	bFactors.clear();
+	nameIds.clear();
+	elementIds.clear();
+	residueIndices.clear();
+	residueNums.clear();
+	residueNameIds.clear();
+	residueChainIndices.clear();
+	residueAtomStarts.clear();
+	chainIds.clear();
+	chainIndexOf.fill(-1);
+	chainCodes.clear();
+	for (auto &name : chainNamesByCode) {
+		name.clear();
+	}
+	lastChainName.clear();
+	lastChainCode = ' ';
+	chainCodesExhausted = false;
+	names.clear();
+	residueNames.clear();
+	elements.clear();
+}
+
+void AtomTable::addResidue(char chain, int residueNum, uint16_t residueNameId) {
+	int16_t &chainIndex = chainIndexOf[static_cast<unsigned char>(chain)];
+	if (chainIndex < 0) {
+		chainIndex = static_cast<int16_t>(chainIds.size());
+		chainIds.push_back(chain);
+	}
+	residueNums.push_back(residueNum);
+	residueNameIds.push_back(residueNameId);
+	residueChainIndices.push_back(static_cast<uint16_t>(chainIndex));
+	residueAtomStarts.push_back(static_cast<uint32_t>(size()));
+}
+
+void AtomTable::push_back(const Atom &atom) {
+	append(atom.name, atom.residueName, atom.chain, atom.residueNum, atom.coords, atom.element);
+}
+
+void AtomTable::append(std::string_view name, std::string_view residueName, char chain, int residueNum,
+	const glm::vec3 &coords, std::string_view element, float bFactor) {
+	//Only the first atom of a residue needs its residue name interned
+	uint16_t residueNameId = 0;
+	if (residueNums.empty() || residueNums.back() != residueNum || chainIds[residueChainIndices.back()] != chain) {
+		residueNameId = residueNames.intern(residueName);
+	}
+	else {
+		residueNameId = residueNameIds.back();
+	}
+	appendInterned(names.intern(name), residueNameId, chain, residueNum, coords, elements.intern(element), bFactor);
+}
+
+void AtomTable::appendInterned(uint16_t nameId, uint16_t residueNameId, char chain, int residueNum,
+	const glm::vec3 &coords, uint16_t elementId, float bFactor) {
+	if (residueNums.empty() || residueNums.back() != residueNum || chainIds[residueChainIndices.back()] != chain) {
+		addResidue(chain, residueNum, residueNameId);
+	}
+	x.push_back(coords.x);
+	y.push_back(coords.y);
+	z.push_back(coords.z);
+	bFactors.push_back(bFactor);
+	nameIds.push_back(nameId);
+	elementIds.push_back(elementId);
+	residueIndices.push_back(static_cast<uint32_t>(residueNums.size() - 1));
+}
+
+Atom AtomTable::operator[](size_t index) const {
+	return Atom{name(index), residueName(index), chain(index), residueNum(index), coords(index), element(index)};
+}
+
+void AtomTable::setCoordinates(const float *xyz) {
+	parallelFor(size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			x[i] = xyz[3 * i];
+			y[i] = xyz[3 * i + 1];
+			z[i] = xyz[3 * i + 2];
+		}
+	}, 1 << 16);
+}
+
+char AtomTable::chainCode(std::string_view id) {
+	//Rows of one chain come in runs, most calls ask for the previous identifier again
+	if (id == lastChainName && !chainCodes.empty()) {
+		return lastChainCode;
+	}
+	lastChainName.assign(id);
+	auto found = chainCodes.find(lastChainName);
+	if (found != chainCodes.end()) {
+		lastChainCode = found->second;
+		return lastChainCode;
+	}
+
+	auto isFree = [&](char code) {
+		return chainNamesByCode[static_cast<unsigned char>(code)].empty();
+	};
+	char code = id.empty() ? ' ' : id[0];
+	//Single character identifiers keep their character, so multi-character ones never take it first
+	if (id.size() > 1 || !isFree(code)) {
+		bool assigned = false;
+		for (const char *candidate = CHAIN_CODE_ORDER; *candidate && !assigned; ++candidate) {
+			if (isFree(*candidate)) {
+				code = *candidate;
+				assigned = true;
+			}
+		}
+		for (int candidate = 1; candidate < 256 && !assigned; ++candidate) {
+			if (candidate != ' ' && isFree(static_cast<char>(candidate))) {
+				code = static_cast<char>(candidate);
+				assigned = true;
+			}
+		}
+		if (!assigned && !chainCodesExhausted) {
+			std::cerr << "ERROR > Too many chains for single character codes, chain " << lastChainName
+				<< " and the following ones share codes with earlier chains\n\n";
+			chainCodesExhausted = true;
+		}
+	}
+	if (isFree(code)) {
+		chainNamesByCode[static_cast<unsigned char>(code)] = id.empty() ? std::string(" ") : lastChainName;
+	}
+	chainCodes.emplace(lastChainName, code);
+	lastChainCode = code;
+	return code;
+}
+
+std::string AtomTable::chainName(size_t chainIndex) const {
+	char code = chainIds[chainIndex];
+	const std::string &name = chainNamesByCode[static_cast<unsigned char>(code)];
+	return name.empty() ? std::string(1, code) : name;
+}
@@ -0,0 +1,246 @@
+#include "bio/BinaryCIFFile.h"
+
+#include <iostream>
+#include <string_view>
+
+#include "bio/ColumnCodecs.h"
+#include "bio/MappedFile.h"
+#include "bio/MessagePack.h"
+#include "bio/Parallel.h"
+
+namespace {
+
+//The requested columns of one category, nullptr for columns the file doesn't have
+class Category {
+private:
+	std::vector<DecodedColumn> decoded;
+	std::vector<bool> present;
+
+public:
+	size_t rowCount = 0;
+
+	const DecodedColumn *operator[](size_t index) const {
+		return present[index] ? &decoded[index] : nullptr;
+	}
+
+	//Decodes the wanted columns of the named category, false if it is missing or can't be decoded
+	bool read(const MessagePackValue &categories, std::string_view name, const std::vector<std::string_view> &wanted) {
+		decoded.assign(wanted.size(), DecodedColumn());
+		present.assign(wanted.size(), false);
+		rowCount = 0;
+
+		const MessagePackValue *category = nullptr;
+		for (size_t i = 0; i < categories.size(); ++i) {
+			const MessagePackValue *categoryName = categories[i].find("name");
+			if (categoryName && categoryName->asString() == name) {
+				category = &categories[i];
+				break;
+			}
+		}
+		const MessagePackValue *columns = category ? category->find("columns") : nullptr;
+		if (!columns) {
+			return false;
+		}
+		const MessagePackValue *rows = category->find("rowCount");
+		rowCount = rows ? static_cast<size_t>(rows->asInteger()) : 0;
+
+		std::vector<const MessagePackValue *> sources(wanted.size(), nullptr);
+		for (size_t i = 0; i < columns->size(); ++i) {
+			const MessagePackValue *columnName = (*columns)[i].find("name");
+			for (size_t j = 0; columnName && j < wanted.size(); ++j) {
+				if (columnName->asString() == wanted[j]) {
+					sources[j] = &(*columns)[i];
+				}
+			}
+		}
+
+		//Columns are independent, decode them side by side
+		std::vector<char> valid(wanted.size(), 1);
+		parallelFor(wanted.size(), [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				if (sources[i]) {
+					valid[i] = decodeCategoryColumn(*sources[i], decoded[i]) && decoded[i].size() == rowCount;
+				}
+			}
+		});
+
+		for (size_t i = 0; i < wanted.size(); ++i) {
+			if (!valid[i]) {
+				std::cerr << "ERROR > Could not decode column " << name << "." << wanted[i] << "\n\n";
+				return false;
+			}
+			present[i] = sources[i] != nullptr;
+		}
+		return true;
+	}
+};
+
+//Value of the preferred column, or of the fallback where the preferred one is missing or null
+std::string_view textOf(const DecodedColumn *preferred, const DecodedColumn *fallback, size_t row) {
+	if (preferred && !preferred->isNull(row)) {
+		return preferred->text(row);
+	}
+	return fallback ? fallback->text(row) : std::string_view();
+}
+
+int integerOf(const DecodedColumn *preferred, const DecodedColumn *fallback, size_t row) {
+	if (preferred && !preferred->isNull(row)) {
+		return preferred->integer(row);
+	}
+	return fallback ? fallback->integer(row) : 0;
+}
+
+float realOf(const DecodedColumn *column, size_t row) {
+	return column ? column->real(row) : 0.0f;
+}
+
+//Ids in pool of the distinct strings of a column, so rows only need an index lookup
+std::vector<uint16_t> internColumn(const DecodedColumn *column, StringPool &pool) {
+	std::vector<uint16_t> ids;
+	if (column && column->type == DecodedColumn::Type::STRING) {
+		ids.reserve(column->strings.size());
+		for (const auto &string : column->strings) {
+			ids.push_back(pool.intern(string));
+		}
+	}
+	return ids;
+}
+
+uint16_t idOf(const DecodedColumn *column, const std::vector<uint16_t> &ids, size_t row) {
+	return ids.empty() || column->isNull(row) ? 0 : ids[column->integers[row]];
+}
+
+//Interned strings of two alternative columns, like textOf()
+struct InternedColumns {
+	const DecodedColumn *preferred;
+	const DecodedColumn *fallback;
+	std::vector<uint16_t> preferredIds;
+	std::vector<uint16_t> fallbackIds;
+
+	InternedColumns(const DecodedColumn *preferred, const DecodedColumn *fallback, StringPool &pool) :
+		preferred(preferred), fallback(fallback),
+		preferredIds(internColumn(preferred, pool)), fallbackIds(internColumn(fallback, pool)) {}
+
+	uint16_t id(size_t row) const {
+		if (!preferredIds.empty() && !preferred->isNull(row)) {
+			return preferredIds[preferred->integers[row]];
+		}
+		return idOf(fallback, fallbackIds, row);
+	}
+};
+
+}
+
+BinaryCIFFile::BinaryCIFFile(const std::string &path) {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		return;
+	}
+	if (file.size() >= 2 && static_cast<unsigned char>(file.data()[0]) == 0x1f &&
+		static_cast<unsigned char>(file.data()[1]) == 0x8b) {
+		std::cerr << "ERROR > Compressed BinaryCIF files are not supported, decompress first: " << path << "\n\n";
+		return;
+	}
+
+	MessagePackValue root;
+	if (!MessagePackValue::parse(file.data(), file.size(), root)) {
+		std::cerr << "ERROR > Not a valid BinaryCIF file: " << path << "\n\n";
+		return;
+	}
+	const MessagePackValue *blocks = root.find("dataBlocks");
+	if (!blocks || blocks->size() == 0 || !(*blocks)[0].find("categories")) {
+		std::cerr << "ERROR > BinaryCIF file has no data blocks: " << path << "\n\n";
+		return;
+	}
+	const MessagePackValue &categories = *(*blocks)[0].find("categories");
+
+	//atom_site
+	enum { SYMBOL, AUTH_ATOM, LABEL_ATOM, AUTH_COMP, LABEL_COMP, AUTH_ASYM, LABEL_ASYM,
+		AUTH_SEQ, LABEL_SEQ, X, Y, Z, MODEL, B_FACTOR };
+	Category atomSite;
+	if (atomSite.read(categories, "_atom_site", {
+		"type_symbol", "auth_atom_id", "label_atom_id", "auth_comp_id", "label_comp_id",
+		"auth_asym_id", "label_asym_id", "auth_seq_id", "label_seq_id", "Cartn_x", "Cartn_y", "Cartn_z",
+		"pdbx_PDB_model_num", "B_iso_or_equiv"
+	})) {
+		const DecodedColumn *model = atomSite[MODEL];
+		int firstModel = model && atomSite.rowCount > 0 ? model->integer(0) : 0;
+
+		//String columns hold few distinct values, intern those once instead of every row.
+		//Author values masked as missing fall back to the label column row by row
+		InternedColumns nameIds(atomSite[AUTH_ATOM], atomSite[LABEL_ATOM], atoms.names);
+		InternedColumns residueNameIds(atomSite[AUTH_COMP], atomSite[LABEL_COMP], atoms.residueNames);
+		std::vector<uint16_t> elementIds = internColumn(atomSite[SYMBOL], atoms.elements);
+
+		atoms.reserve(atomSite.rowCount);
+		for (size_t row = 0; row < atomSite.rowCount; ++row) {
+			//Models are stored one after the other
+			if (model && model->integer(row) != firstModel) {
+				break;
+			}
+			atoms.appendInterned(
+				nameIds.id(row),
+				residueNameIds.id(row),
+				atoms.chainCode(textOf(atomSite[AUTH_ASYM], atomSite[LABEL_ASYM], row)),
+				integerOf(atomSite[AUTH_SEQ], atomSite[LABEL_SEQ], row),
+				glm::vec3(realOf(atomSite[X], row), realOf(atomSite[Y], row), realOf(atomSite[Z], row)),
+				idOf(atomSite[SYMBOL], elementIds, row),
+				realOf(atomSite[B_FACTOR], row)
+			);
+		}
+	}
+
+	Category structConf;
+	if (structConf.read(categories, "_struct_conf", {
+		"conf_type_id", "beg_auth_asym_id", "beg_auth_seq_id", "end_auth_seq_id", "pdbx_PDB_helix_class",
+		"beg_label_asym_id", "beg_label_seq_id", "end_label_seq_id"
+	})) {
+		for (size_t row = 0; row < structConf.rowCount; ++row) {
+			//Turns and other conformations are listed here too
+			if (textOf(structConf[0], nullptr, row).substr(0, 4) != "HELX") {
+				continue;
+			}
+			int type = integerOf(structConf[4], nullptr, row);
+			helices.push_back(Helix{
+				(type >= 1 && type <= 10) ? type : 1,
+				atoms.chainCode(textOf(structConf[1], structConf[5], row)),
+				integerOf(structConf[2], structConf[6], row),
+				integerOf(structConf[3], structConf[7], row)
+			});
+		}
+	}
+
+	Category structSheetRange;
+	if (structSheetRange.read(categories, "_struct_sheet_range", {
+		"beg_auth_asym_id", "beg_auth_seq_id", "end_auth_seq_id",
+		"beg_label_asym_id", "beg_label_seq_id", "end_label_seq_id"
+	})) {
+		for (size_t row = 0; row < structSheetRange.rowCount; ++row) {
+			sheets.push_back(Sheet{
+				atoms.chainCode(textOf(structSheetRange[0], structSheetRange[3], row)),
+				integerOf(structSheetRange[1], structSheetRange[4], row),
+				integerOf(structSheetRange[2], structSheetRange[5], row)
+			});
+		}
+	}
+
+	Category structConn;
+	if (structConn.read(categories, "_struct_conn", {
+		"conn_type_id", "ptnr1_auth_asym_id", "ptnr1_auth_seq_id", "ptnr2_auth_asym_id", "ptnr2_auth_seq_id",
+		"ptnr1_label_asym_id", "ptnr1_label_seq_id", "ptnr2_label_asym_id", "ptnr2_label_seq_id"
+	})) {
+		for (size_t row = 0; row < structConn.rowCount; ++row) {
+			if (textOf(structConn[0], nullptr, row) != "disulf") {
+				continue;
+			}
+			disulfideBonds.push_back(DisulfideBond{
+				atoms.chainCode(textOf(structConn[1], structConn[5], row)),
+				integerOf(structConn[2], structConn[6], row),
+				atoms.chainCode(textOf(structConn[3], structConn[7], row)),
+				integerOf(structConn[4], structConn[8], row)
+			});
+		}
+	}
+
+	buildSequenceFromAtoms();
+}
@@ -0,0 +1,104 @@
+#include "bio/BondTable.h"
+
+#include <algorithm>
+
+#include "bio/Element.h"
+#include "bio/Parallel.h"
+#include "bio/SpatialGrid.h"
+
+namespace {
+
+//Atoms are perceived in chunks so workers finishing early can be given more
+constexpr size_t CHUNK_SIZE = 1 << 14;
+
+//Atoms that close are alternate locations or broken input, not bonds
+constexpr float MIN_BOND_LENGTH = 0.4f;
+
+}
+
+void BondTable::clear() {
+	offsets.clear();
+	partners.clear();
+}
+
+void BondTable::perceive(const AtomTable &atoms, float tolerance) {
+	clear();
+	size_t count = atoms.size();
+	offsets.assign(count + 1, 0);
+	if (count == 0) {
+		return;
+	}
+
+	//Radius of every distinct element string once, then per atom
+	std::vector<float> elementRadii(atoms.elements.size());
+	float maxRadius = 0.0f;
+	for (size_t id = 0; id < elementRadii.size(); ++id) {
+		elementRadii[id] = covalentRadius(elementFromSymbol(atoms.elements[static_cast<uint16_t>(id)]));
+		maxRadius = std::max(maxRadius, elementRadii[id]);
+	}
+	std::vector<float> radii(count);
+	for (size_t i = 0; i < count; ++i) {
+		radii[i] = elementRadii[atoms.elementIds[i]];
+	}
+
+	SpatialGrid grid;
+	grid.build(atoms.x.data(), atoms.y.data(), atoms.z.data(), count, 2.0f * maxRadius + tolerance);
+
+	//Radii in grid order like the grid's coordinates, so the atoms of neighboring cells are contiguous in memory
+	const std::vector<float> &x = grid.slotX, &y = grid.slotY, &z = grid.slotZ;
+	std::vector<float> r(count);
+	parallelFor(count, [&](size_t first, size_t last) {
+		for (size_t slot = first; slot < last; ++slot) {
+			r[slot] = radii[grid.items[slot]];
+		}
+	}, 1 << 16);
+
+	size_t chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	std::vector<std::vector<uint32_t>> chunkPartners(chunkCount);
+
+	//Chunks are ranges of grid slots. Bond counts go to offsets[atom + 1] so a prefix sum turns them into offsets
+	parallelFor(chunkCount, [&](size_t firstChunk, size_t lastChunk) {
+		for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+			std::vector<uint32_t> &found = chunkPartners[chunk];
+			size_t end = std::min(count, (chunk + 1) * CHUNK_SIZE);
+			for (size_t slot = chunk * CHUNK_SIZE; slot < end; ++slot) {
+				uint32_t atom = grid.items[slot];
+				size_t before = found.size();
+				float xi = x[slot], yi = y[slot], zi = z[slot], ri = r[slot] + tolerance;
+				grid.forEachNearSlot(xi, yi, zi, [&](size_t other) {
+					uint32_t partner = grid.items[other];
+					if (partner <= atom) {
+						return;
+					}
+					float dx = x[other] - xi, dy = y[other] - yi, dz = z[other] - zi;
+					float distance2 = dx * dx + dy * dy + dz * dz;
+					float limit = ri + r[other];
+					if (distance2 < limit * limit && distance2 > MIN_BOND_LENGTH * MIN_BOND_LENGTH) {
+						found.push_back(partner);
+					}
+				});
+				std::sort(found.begin() + before, found.end());
+				offsets[atom + 1] = static_cast<uint32_t>(found.size() - before);
+			}
+		}
+	});
+
+	for (size_t i = 1; i <= count; ++i) {
+		offsets[i] += offsets[i - 1];
+	}
+
+	//Every chunk walks its slots again to scatter each atom's partners to its row
+	partners.resize(offsets[count]);
+	parallelFor(chunkCount, [&](size_t firstChunk, size_t lastChunk) {
+		for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+			const uint32_t *found = chunkPartners[chunk].data();
+			size_t end = std::min(count, (chunk + 1) * CHUNK_SIZE);
+			for (size_t slot = chunk * CHUNK_SIZE; slot < end; ++slot) {
+				uint32_t atom = grid.items[slot];
+				uint32_t bondCount = offsets[atom + 1] - offsets[atom];
+				std::copy(found, found + bondCount, partners.begin() + offsets[atom]);
+				found += bondCount;
+			}
+		}
+	});
+}
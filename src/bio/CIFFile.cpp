@@ -0,0 +1,443 @@
+#include "bio/CIFFile.h"
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string_view>
+
+#include "bio/FieldParsing.h"
+
+namespace {
+
+enum class TokenType {
+	END, DATA, LOOP, TAG, VALUE, TEXT
+};
+
+/*
+Splits a CIF stream into tokens. Tokens are views into the internal buffer and
+stay valid until the next call to next(). The buffer only grows if a single
+token is larger than it.
+*/
+class Tokenizer {
+private:
+	static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+	std::istream &in;
+	std::vector<char> buffer;
+	size_t position = 0;
+	size_t end = 0;
+	bool eof = false;
+	bool lineStart = true;
+
+	//Moves the unread data starting at keep to the front and reads more, false if nothing was added
+	bool fill(size_t &keep) {
+		if (eof) {
+			return false;
+		}
+		size_t remaining = end - keep;
+		if (keep > 0) {
+			std::memmove(buffer.data(), buffer.data() + keep, remaining);
+		}
+		else if (remaining == buffer.size()) {
+			buffer.resize(buffer.size() * 2);
+		}
+		position -= keep;
+		end = remaining;
+		keep = 0;
+
+		in.read(buffer.data() + end, static_cast<std::streamsize>(buffer.size() - end));
+		size_t count = static_cast<size_t>(in.gcount());
+		end += count;
+		if (count == 0) {
+			eof = true;
+		}
+		return count > 0;
+	}
+
+	//Makes sure buffer[position] is readable, keeping data from keep on
+	bool available(size_t &keep) {
+		return position < end || fill(keep);
+	}
+
+	static bool isSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	static bool startsWithNoCase(std::string_view text, const char *prefix) {
+		size_t length = std::strlen(prefix);
+		if (text.size() < length) {
+			return false;
+		}
+		for (size_t i = 0; i < length; ++i) {
+			if (std::tolower(static_cast<unsigned char>(text[i])) != prefix[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//Skips a ';' delimited text field without storing it, these can be arbitrarily long
+	void skipTextField() {
+		size_t keep = position;
+		++position;
+		bool newline = false;
+		while (available(keep)) {
+			char c = buffer[position++];
+			if (newline && c == ';') {
+				break;
+			}
+			newline = c == '\n';
+			keep = position;
+		}
+		lineStart = false;
+	}
+
+public:
+	explicit Tokenizer(std::istream &in) :
+		in(in), buffer(BUFFER_SIZE) {}
+
+	TokenType next(std::string_view &text) {
+		while (true) {
+			//Whitespace and comments
+			size_t keep = position;
+			while (available(keep)) {
+				char c = buffer[position];
+				if (c == '#') {
+					while (available(keep) && buffer[position] != '\n') {
+						keep = ++position;
+					}
+					continue;
+				}
+				if (!isSpace(c)) {
+					break;
+				}
+				lineStart = c == '\n';
+				keep = ++position;
+			}
+			if (!available(keep)) {
+				return TokenType::END;
+			}
+
+			char first = buffer[position];
+			if (first == ';' && lineStart) {
+				skipTextField();
+				text = std::string_view();
+				return TokenType::TEXT;
+			}
+			lineStart = false;
+
+			size_t start = position;
+			if (first == '\'' || first == '"') {
+				//Quoted value, the quote only closes when followed by whitespace
+				++position;
+				while (true) {
+					if (!available(start)) {
+						break;
+					}
+					if (buffer[position] == first) {
+						++position;
+						if (!available(start) || isSpace(buffer[position])) {
+							break;
+						}
+						continue;
+					}
+					++position;
+				}
+				size_t closing = position > start + 1 && buffer[position - 1] == first ? 1 : 0;
+				text = std::string_view(buffer.data() + start + 1, position - start - 1 - closing);
+				return TokenType::VALUE;
+			}
+
+			while (available(start) && !isSpace(buffer[position])) {
+				++position;
+			}
+			text = std::string_view(buffer.data() + start, position - start);
+
+			if (first == '_') {
+				return TokenType::TAG;
+			}
+			if (startsWithNoCase(text, "loop_") && text.size() == 5) {
+				return TokenType::LOOP;
+			}
+			if (startsWithNoCase(text, "data_")) {
+				return TokenType::DATA;
+			}
+			if (startsWithNoCase(text, "save_") || startsWithNoCase(text, "global_") || startsWithNoCase(text, "stop_")) {
+				continue;
+			}
+			return TokenType::VALUE;
+		}
+	}
+};
+
+bool isNull(std::string_view value) {
+	return value.empty() || value == "." || value == "?";
+}
+
+/*
+Reader for one category. Only the requested columns of each row are copied,
+the row callback receives them in request order ("" when absent or null).
+*/
+class CategoryReader {
+private:
+	std::vector<std::string> columnNames;
+	std::function<void(const std::vector<std::string> &)> onRow;
+
+public:
+	std::vector<std::string> values;
+
+	CategoryReader(std::vector<std::string> columnNames, std::function<void(const std::vector<std::string> &)> onRow) :
+		columnNames(std::move(columnNames)), onRow(std::move(onRow)), values(this->columnNames.size()) {}
+
+	//Index of a requested column, -1 for columns that get skipped
+	int column(std::string_view name) const {
+		for (size_t i = 0; i < columnNames.size(); ++i) {
+			if (name.size() == columnNames[i].size() &&
+				std::equal(name.begin(), name.end(), columnNames[i].begin(),
+					[](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); })) {
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	}
+
+	void set(int index, std::string_view value) {
+		if (index >= 0) {
+			values[index].assign(isNull(value) ? std::string_view() : value);
+		}
+	}
+
+	void emit() {
+		onRow(values);
+		for (auto &value : values) {
+			value.clear();
+		}
+	}
+};
+
+//Splits "_category.column" into its two parts
+void splitTag(std::string_view tag, std::string_view &category, std::string_view &column) {
+	size_t dot = tag.find('.');
+	category = tag.substr(1, dot == std::string_view::npos ? std::string_view::npos : dot - 1);
+	column = dot == std::string_view::npos ? std::string_view() : tag.substr(dot + 1);
+}
+
+//First non-empty of two alternative columns (author numbering preferred over label numbering)
+const std::string &either(const std::string &preferred, const std::string &fallback) {
+	return preferred.empty() ? fallback : preferred;
+}
+
+}
+
+CIFFile::CIFFile(const std::string &path) {
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream) {
+		std::cerr << "ERROR > Could not open file: " << path << "\n\n";
+		return;
+	}
+	read(stream);
+}
+
+CIFFile::CIFFile(std::istream &stream) {
+	read(stream);
+}
+
+void CIFFile::read(std::istream &stream) {
+	std::string firstModel;
+
+	//atom_site columns
+	enum { GROUP, SYMBOL, AUTH_ATOM, LABEL_ATOM, AUTH_COMP, LABEL_COMP, AUTH_ASYM, LABEL_ASYM,
+		AUTH_SEQ, LABEL_SEQ, X, Y, Z, MODEL, B_FACTOR };
+	CategoryReader atomSite({
+		"group_PDB", "type_symbol", "auth_atom_id", "label_atom_id", "auth_comp_id", "label_comp_id",
+		"auth_asym_id", "label_asym_id", "auth_seq_id", "label_seq_id", "Cartn_x", "Cartn_y", "Cartn_z",
+		"pdbx_PDB_model_num", "B_iso_or_equiv"
+	}, [&](const std::vector<std::string> &row) {
+		if (firstModel.empty()) {
+			firstModel = row[MODEL].empty() ? "1" : row[MODEL];
+		}
+		if (!row[MODEL].empty() && row[MODEL] != firstModel) {
+			return;
+		}
+		atoms.append(
+			either(row[AUTH_ATOM], row[LABEL_ATOM]),
+			either(row[AUTH_COMP], row[LABEL_COMP]),
+			atoms.chainCode(either(row[AUTH_ASYM], row[LABEL_ASYM])),
+			parseIntField(either(row[AUTH_SEQ], row[LABEL_SEQ])),
+			glm::vec3(parseFloatField(row[X]), parseFloatField(row[Y]), parseFloatField(row[Z])),
+			row[SYMBOL],
+			parseFloatField(row[B_FACTOR])
+		);
+	});
+
+	CategoryReader structConf({
+		"conf_type_id", "beg_auth_asym_id", "beg_auth_seq_id", "end_auth_seq_id", "pdbx_PDB_helix_class",
+		"beg_label_asym_id", "beg_label_seq_id", "end_label_seq_id"
+	}, [&](const std::vector<std::string> &row) {
+		//Turns and other conformations are listed here too
+		if (row[0].compare(0, 4, "HELX") != 0) {
+			return;
+		}
+		int type = parseIntField(row[4]);
+		helices.push_back(Helix{
+			(type >= 1 && type <= 10) ? type : 1,
+			atoms.chainCode(either(row[1], row[5])),
+			parseIntField(either(row[2], row[6])),
+			parseIntField(either(row[3], row[7]))
+		});
+	});
+
+	CategoryReader structSheetRange({
+		"beg_auth_asym_id", "beg_auth_seq_id", "end_auth_seq_id",
+		"beg_label_asym_id", "beg_label_seq_id", "end_label_seq_id"
+	}, [&](const std::vector<std::string> &row) {
+		sheets.push_back(Sheet{
+			atoms.chainCode(either(row[0], row[3])),
+			parseIntField(either(row[1], row[4])),
+			parseIntField(either(row[2], row[5]))
+		});
+	});
+
+	CategoryReader structConn({
+		"conn_type_id", "ptnr1_auth_asym_id", "ptnr1_auth_seq_id", "ptnr2_auth_asym_id", "ptnr2_auth_seq_id",
+		"ptnr1_label_asym_id", "ptnr1_label_seq_id", "ptnr2_label_asym_id", "ptnr2_label_seq_id"
+	}, [&](const std::vector<std::string> &row) {
+		if (row[0] != "disulf") {
+			return;
+		}
+		disulfideBonds.push_back(DisulfideBond{
+			atoms.chainCode(either(row[1], row[5])),
+			parseIntField(either(row[2], row[6])),
+			atoms.chainCode(either(row[3], row[7])),
+			parseIntField(either(row[4], row[8]))
+		});
+	});
+
+	auto readerFor = [&](std::string_view category) -> CategoryReader * {
+		if (category == "atom_site") {
+			return &atomSite;
+		}
+		if (category == "struct_conf") {
+			return &structConf;
+		}
+		if (category == "struct_sheet_range") {
+			return &structSheetRange;
+		}
+		if (category == "struct_conn") {
+			return &structConn;
+		}
+		return nullptr;
+	};
+
+	Tokenizer tokenizer(stream);
+	std::string_view token;
+
+	//Loop state: reader of the loop's category and the projection of its columns
+	bool inLoop = false;
+	bool loopHeader = false;
+	CategoryReader *loopReader = nullptr;
+	std::vector<int> projection;
+	size_t valueIndex = 0;
+
+	//Key-value state: category of the pending single-row table and the tag awaiting its value
+	std::string pendingCategory;
+	CategoryReader *pendingReader = nullptr;
+	int pendingColumn = -1;
+	bool awaitingValue = false;
+	int dataBlocks = 0;
+
+	auto flushPending = [&]() {
+		if (pendingReader) {
+			pendingReader->emit();
+		}
+		pendingReader = nullptr;
+		pendingCategory.clear();
+		awaitingValue = false;
+	};
+	auto endLoop = [&]() {
+		inLoop = false;
+		loopHeader = false;
+		loopReader = nullptr;
+		projection.clear();
+	};
+
+	TokenType type;
+	while ((type = tokenizer.next(token)) != TokenType::END) {
+		switch (type) {
+		case TokenType::DATA:
+			flushPending();
+			endLoop();
+			//Only the first block describes the structure
+			if (++dataBlocks > 1) {
+				type = TokenType::END;
+			}
+			break;
+
+		case TokenType::LOOP:
+			flushPending();
+			endLoop();
+			inLoop = true;
+			loopHeader = true;
+			valueIndex = 0;
+			break;
+
+		case TokenType::TAG: {
+			std::string_view category, column;
+			splitTag(token, category, column);
+			if (inLoop && loopHeader) {
+				if (projection.empty()) {
+					loopReader = readerFor(category);
+				}
+				projection.push_back(loopReader ? loopReader->column(column) : -1);
+				break;
+			}
+			endLoop();
+
+			if (category != pendingCategory) {
+				flushPending();
+				pendingCategory.assign(category);
+				pendingReader = readerFor(category);
+			}
+			pendingColumn = pendingReader ? pendingReader->column(column) : -1;
+			awaitingValue = true;
+			break;
+		}
+
+		case TokenType::VALUE:
+		case TokenType::TEXT:
+			if (inLoop) {
+				loopHeader = false;
+				if (projection.empty()) {
+					break;
+				}
+				size_t column = valueIndex % projection.size();
+				if (loopReader) {
+					loopReader->set(projection[column], token);
+					if (column + 1 == projection.size()) {
+						loopReader->emit();
+					}
+				}
+				++valueIndex;
+			}
+			else if (awaitingValue) {
+				if (pendingReader) {
+					pendingReader->set(pendingColumn, token);
+				}
+				awaitingValue = false;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		if (type == TokenType::END) {
+			break;
+		}
+	}
+	flushPending();
+
+	buildSequenceFromAtoms();
+}
@@ -0,0 +1,338 @@
+#include "bio/Cartoon.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "bio/Parallel.h"
+
+namespace {
+
+struct Profile {
+	float width;
+	float thickness;
+	float exponent; //Superellipse exponent, 2 is an ellipse, higher values are boxier
+};
+
+constexpr Profile COIL_PROFILE = {0.3f, 0.3f, 2.0f};
+constexpr Profile HELIX_PROFILE = {1.3f, 0.25f, 2.0f};
+constexpr Profile SHEET_PROFILE = {1.6f, 0.3f, 6.0f};
+constexpr Profile ARROW_PROFILE = {2.4f, 0.3f, 6.0f};
+
+//Consecutive CA atoms further apart than this aren't bonded, the tube is split there
+constexpr float MAX_CA_GAP = 4.2f;
+
+//Camera distance (angstrom) below which chains get MAX_SEGMENTS, detail halves with every doubling beyond
+constexpr float FULL_DETAIL_DISTANCE = 25.0f;
+
+constexpr float TWO_PI = 6.28318531f;
+
+int ringPoints(int segments) {
+	return 4 + 2 * segments;
+}
+
+glm::vec3 catmullRom(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, float t) {
+	return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t * t +
+		(3.0f * p1 - p0 - 3.0f * p2 + p3) * t * t * t);
+}
+
+glm::vec3 catmullRomTangent(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, float t) {
+	return 0.5f * ((p2 - p0) + 2.0f * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t +
+		3.0f * (3.0f * p1 - p0 - 3.0f * p2 + p3) * t * t);
+}
+
+float signedPower(float value, float exponent) {
+	return std::copysign(std::pow(std::abs(value), exponent), value);
+}
+
+void addTriangle(std::vector<uint32_t> &indices, uint32_t a, uint32_t b, uint32_t c) {
+	indices.push_back(a);
+	indices.push_back(b);
+	indices.push_back(c);
+}
+
+}
+
+int Cartoon::segmentsForDistance(float distance) {
+	if (distance <= FULL_DETAIL_DISTANCE) {
+		return MAX_SEGMENTS;
+	}
+	int segments = static_cast<int>(MAX_SEGMENTS * FULL_DETAIL_DISTANCE / distance + 0.5f);
+	return std::max(1, std::min(MAX_SEGMENTS, segments));
+}
+
+void Cartoon::clear() {
+	chains.clear();
+	chainResidues.clear();
+	caPositions.clear();
+	oPositions.clear();
+}
+
+void Cartoon::readTraces(const MoleculeData &moleculeData) {
+	const AtomTable &atoms = moleculeData.atoms;
+	size_t residueCount = atoms.residueCount();
+
+	//1 for CA, 2 for O, by atom name id
+	std::vector<uint8_t> roles(atoms.names.size(), 0);
+	for (size_t id = 0; id < roles.size(); ++id) {
+		const std::string &name = atoms.names[static_cast<uint16_t>(id)];
+		roles[id] = name == "CA" ? 1 : name == "O" ? 2 : 0;
+	}
+
+	caPositions.assign(residueCount, glm::vec3(0.0f));
+	oPositions.assign(residueCount, glm::vec3(0.0f));
+	chainResidues.assign(atoms.chainIds.size(), {});
+	for (size_t r = 0; r < residueCount; ++r) {
+		size_t atomEnd = r + 1 < residueCount ? atoms.residueAtomStarts[r + 1] : atoms.size();
+		bool hasCA = false, hasO = false;
+		for (size_t a = atoms.residueAtomStarts[r]; a < atomEnd; ++a) {
+			uint8_t role = roles[atoms.nameIds[a]];
+			if (role == 1 && !hasCA) {
+				caPositions[r] = atoms.coords(a);
+				hasCA = true;
+			}
+			else if (role == 2 && !hasO) {
+				oPositions[r] = atoms.coords(a);
+				hasO = true;
+			}
+		}
+		if (hasCA && hasO) {
+			chainResidues[atoms.residueChainIndices[r]].push_back(static_cast<uint32_t>(r));
+		}
+	}
+
+	//Bounding sphere of every chain for the camera distance
+	chains.clear();
+	for (size_t c = 0; c < chainResidues.size(); ++c) {
+		glm::vec3 low(0.0f), high(0.0f);
+		for (size_t k = 0; k < chainResidues[c].size(); ++k) {
+			const glm::vec3 &position = caPositions[chainResidues[c][k]];
+			low = k ? glm::min(low, position) : position;
+			high = k ? glm::max(high, position) : position;
+		}
+		chains.push_back(ChainMesh{atoms.chainIds[c], 0, 0.5f * (low + high), 0.5f * glm::length(high - low), {}, {}});
+	}
+}
+
+size_t Cartoon::update(const MoleculeData &moleculeData, const glm::vec3 &camera) {
+	if (chains.empty()) {
+		readTraces(moleculeData);
+	}
+	std::vector<int> wanted(chains.size());
+	for (size_t c = 0; c < chains.size(); ++c) {
+		float distance = std::max(0.0f, glm::length(chains[c].center - camera) - chains[c].radius);
+		wanted[c] = segmentsForDistance(distance);
+	}
+
+	//Highest detail cap keeping all chains within the vertex budget
+	std::vector<int> segments(chains.size());
+	for (int cap = MAX_SEGMENTS; cap >= 1; --cap) {
+		size_t vertexCount = 0;
+		for (size_t c = 0; c < chains.size(); ++c) {
+			segments[c] = std::min(wanted[c], cap);
+			vertexCount += chainResidues[c].size() * segments[c] * ringPoints(segments[c]);
+		}
+		if (vertexCount <= vertexBudget) {
+			break;
+		}
+	}
+
+	size_t changed = 0;
+	for (size_t c = 0; c < chains.size(); ++c) {
+		changed += segments[c] != chains[c].segments;
+	}
+	if (changed) {
+		rebuild(moleculeData, segments);
+	}
+	return changed;
+}
+
+void Cartoon::build(const MoleculeData &moleculeData, int segmentsPerResidue) {
+	clear();
+	readTraces(moleculeData);
+	rebuild(moleculeData, std::vector<int>(chains.size(), std::max(1, std::min(MAX_SEGMENTS, segmentsPerResidue))));
+}
+
+void Cartoon::rebuild(const MoleculeData &moleculeData, const std::vector<int> &segments) {
+	//Resolved up front, the lazy index isn't safe to build from several threads
+	const std::vector<uint8_t> &structures = moleculeData.secondaryStructure().residueStructures;
+	parallelFor(chains.size(), [&](size_t first, size_t last) {
+		for (size_t c = first; c < last; ++c) {
+			if (segments[c] != chains[c].segments) {
+				buildChain(structures, c, segments[c]);
+			}
+		}
+	});
+}
+
+void Cartoon::buildChain(const std::vector<uint8_t> &structures, size_t chainIndex, int segments) {
+	ChainMesh &mesh = chains[chainIndex];
+	const std::vector<uint32_t> &residues = chainResidues[chainIndex];
+	mesh.segments = segments;
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	int points = ringPoints(segments);
+	std::vector<float> cosines(points), sines(points);
+	for (int k = 0; k < points; ++k) {
+		cosines[k] = std::cos(TWO_PI * k / points);
+		sines[k] = std::sin(TWO_PI * k / points);
+	}
+
+	auto addVertex = [&](const glm::vec3 &position) {
+		mesh.vertices.insert(mesh.vertices.end(), {position.x, position.y, position.z, 0.0f, 0.0f, 0.0f});
+		return static_cast<uint32_t>(mesh.vertices.size() / 6 - 1);
+	};
+
+	size_t pieceStart = 0;
+	for (size_t pieceEnd = 1; pieceEnd <= residues.size(); ++pieceEnd) {
+		if (pieceEnd < residues.size() &&
+			glm::distance(caPositions[residues[pieceEnd - 1]], caPositions[residues[pieceEnd]]) <= MAX_CA_GAP) {
+			continue;
+		}
+		size_t count = pieceEnd - pieceStart;
+		size_t start = pieceStart;
+		pieceStart = pieceEnd;
+		if (count < 2) {
+			continue;
+		}
+
+		std::vector<glm::vec3> controls(count);
+		std::vector<glm::vec3> sides(count);
+		std::vector<Profile> profiles(count);
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t residue = residues[start + i];
+			controls[i] = caPositions[residue];
+			//Carbonyls alternate sides along strands, keep the side vectors turning smoothly
+			sides[i] = oPositions[residue] - caPositions[residue];
+			if (i > 0 && glm::dot(sides[i], sides[i - 1]) < 0.0f) {
+				sides[i] = -sides[i];
+			}
+
+			uint8_t structure = structures[residue];
+			if (structure == SecondaryStructureIndex::SHEET) {
+				bool last = i + 1 == count || structures[residues[start + i + 1]] != SecondaryStructureIndex::SHEET;
+				profiles[i] = last ? ARROW_PROFILE : SHEET_PROFILE;
+			}
+			else if (structure != SecondaryStructureIndex::NONE) {
+				profiles[i] = HELIX_PROFILE;
+			}
+			else {
+				profiles[i] = COIL_PROFILE;
+			}
+		}
+
+		auto control = [&](long i) {
+			if (i < 0) {
+				return 2.0f * controls[0] - controls[1];
+			}
+			if (i >= static_cast<long>(count)) {
+				return 2.0f * controls[count - 1] - controls[count - 2];
+			}
+			return controls[i];
+		};
+
+		uint32_t firstRing = static_cast<uint32_t>(mesh.vertices.size() / 6);
+		size_t samples = (count - 1) * segments + 1;
+		glm::vec3 previousNormal(0.0f);
+		glm::vec3 firstCenter(0.0f), lastCenter(0.0f), firstTangent(0.0f), lastTangent(0.0f);
+		for (size_t sample = 0; sample < samples; ++sample) {
+			size_t interval = std::min<size_t>(sample / segments, count - 2);
+			long i = static_cast<long>(interval);
+			float t = static_cast<float>(sample - interval * segments) / segments;
+
+			glm::vec3 center = catmullRom(control(i - 1), control(i), control(i + 1), control(i + 2), t);
+			glm::vec3 tangent = glm::normalize(catmullRomTangent(control(i - 1), control(i), control(i + 1), control(i + 2), t));
+			glm::vec3 side = glm::mix(sides[i], sides[i + 1], t);
+			glm::vec3 normal = side - tangent * glm::dot(side, tangent);
+			if (glm::dot(normal, normal) < 1e-6f) {
+				//Oxygen along the trace, keep the last frame or pick any perpendicular
+				glm::vec3 axis = std::abs(tangent.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+				normal = glm::dot(previousNormal, previousNormal) > 0.0f ? previousNormal : glm::cross(tangent, axis);
+			}
+			normal = glm::normalize(normal);
+			if (glm::dot(normal, previousNormal) < 0.0f) {
+				normal = -normal;
+			}
+			previousNormal = normal;
+			glm::vec3 binormal = glm::cross(tangent, normal);
+
+			float blend = t * t * (3.0f - 2.0f * t);
+			const Profile &from = profiles[i];
+			const Profile &to = profiles[i + 1];
+			float width = from.width + (to.width - from.width) * blend;
+			float thickness = from.thickness + (to.thickness - from.thickness) * blend;
+			float exponent = 2.0f / (from.exponent + (to.exponent - from.exponent) * blend);
+			for (int k = 0; k < points; ++k) {
+				addVertex(center + normal * (width * signedPower(cosines[k], exponent)) +
+					binormal * (thickness * signedPower(sines[k], exponent)));
+			}
+
+			if (sample == 0) {
+				firstCenter = center;
+				firstTangent = tangent;
+			}
+			lastCenter = center;
+			lastTangent = tangent;
+		}
+
+		//Tube walls, the winding makes every triangle face outward
+		for (size_t ring = 0; ring + 1 < samples; ++ring) {
+			uint32_t base = firstRing + static_cast<uint32_t>(ring * points);
+			for (int k = 0; k < points; ++k) {
+				uint32_t a = base + k;
+				uint32_t b = base + (k + 1) % points;
+				addTriangle(mesh.indices, a, b, a + points);
+				addTriangle(mesh.indices, b, b + points, a + points);
+			}
+		}
+
+		//Caps get their own ring copies so their normals aren't smoothed into the walls
+		for (int end = 0; end < 2; ++end) {
+			uint32_t ring = firstRing + static_cast<uint32_t>(end ? (samples - 1) * points : 0);
+			uint32_t center = addVertex(end ? lastCenter + 0.01f * lastTangent : firstCenter - 0.01f * firstTangent);
+			uint32_t copy = static_cast<uint32_t>(mesh.vertices.size() / 6);
+			for (int k = 0; k < points; ++k) {
+				const float *source = &mesh.vertices[6 * static_cast<size_t>(ring + k)];
+				glm::vec3 position(source[0], source[1], source[2]);
+				addVertex(position);
+			}
+			for (int k = 0; k < points; ++k) {
+				uint32_t a = copy + k;
+				uint32_t b = copy + (k + 1) % points;
+				if (end) {
+					addTriangle(mesh.indices, center, a, b);
+				}
+				else {
+					addTriangle(mesh.indices, center, b, a);
+				}
+			}
+		}
+	}
+
+	//Area weighted vertex normals
+	std::vector<float> &vertices = mesh.vertices;
+	for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+		glm::vec3 p[3];
+		for (int corner = 0; corner < 3; ++corner) {
+			const float *v = &vertices[6 * static_cast<size_t>(mesh.indices[t + corner])];
+			p[corner] = glm::vec3(v[0], v[1], v[2]);
+		}
+		glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+		for (int corner = 0; corner < 3; ++corner) {
+			float *n = &vertices[6 * static_cast<size_t>(mesh.indices[t + corner]) + 3];
+			n[0] += normal.x;
+			n[1] += normal.y;
+			n[2] += normal.z;
+		}
+	}
+	for (size_t v = 0; v < vertices.size(); v += 6) {
+		glm::vec3 normal(vertices[v + 3], vertices[v + 4], vertices[v + 5]);
+		float length = glm::length(normal);
+		if (length > 0.0f) {
+			normal /= length;
+		}
+		vertices[v + 3] = normal.x;
+		vertices[v + 4] = normal.y;
+		vertices[v + 5] = normal.z;
+	}
+}
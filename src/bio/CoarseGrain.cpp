@@ -0,0 +1,102 @@
+#include "bio/CoarseGrain.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "bio/Parallel.h"
+
+namespace {
+
+//Radius of a uniform sphere over its radius of gyration, sqrt(5/3)
+constexpr float GYRATION_TO_RADIUS = 1.29099445f;
+//Beads of single-atom residues (ions, waters) still cover one atom
+constexpr float MIN_BEAD_RADIUS = 1.5f;
+
+}
+
+float CoarseGrain::pixelsPerUnit(float fovDegrees, float viewportHeight) {
+	return viewportHeight / (2.0f * std::tan(glm::radians(fovDegrees) * 0.5f));
+}
+
+void CoarseGrain::build(const AtomTable &atoms) {
+	size_t residueCount = atoms.residueCount();
+	beads.resize(residueCount);
+
+	parallelFor(residueCount, [&](size_t begin, size_t end) {
+		for (size_t r = begin; r < end; ++r) {
+			size_t atomBegin = atoms.residueAtomStarts[r];
+			size_t atomEnd = r + 1 < residueCount ? atoms.residueAtomStarts[r + 1] : atoms.size();
+			glm::vec3 sum(0.0f);
+			for (size_t a = atomBegin; a < atomEnd; ++a) {
+				sum += atoms.coords(a);
+			}
+			glm::vec3 center = sum / static_cast<float>(atomEnd - atomBegin);
+			float squaredSum = 0.0f;
+			for (size_t a = atomBegin; a < atomEnd; ++a) {
+				glm::vec3 offset = atoms.coords(a) - center;
+				squaredSum += glm::dot(offset, offset);
+			}
+			float gyration = std::sqrt(squaredSum / static_cast<float>(atomEnd - atomBegin));
+			beads[r] = Bead{center, std::max(MIN_BEAD_RADIUS, GYRATION_TO_RADIUS * gyration)};
+		}
+	}, 4096);
+
+	chains.clear();
+	chains.resize(atoms.chainIds.size());
+	for (size_t c = 0; c < chains.size(); ++c) {
+		chains[c].chain = atoms.chainIds[c];
+		chains[c].level = ATOMS;
+		chains[c].stride = 1;
+	}
+	for (size_t r = 0; r < residueCount; ++r) {
+		chains[atoms.residueChainIndices[r]].residues.push_back(static_cast<uint32_t>(r));
+	}
+
+	//Bounding sphere around the beads, so the nearest point of the chain is known without visiting atoms
+	for (ChainLevel &chain : chains) {
+		glm::vec3 low(0.0f), high(0.0f);
+		float radiusSum = 0.0f;
+		for (size_t k = 0; k < chain.residues.size(); ++k) {
+			const Bead &bead = beads[chain.residues[k]];
+			low = k ? glm::min(low, bead.center - bead.radius) : bead.center - bead.radius;
+			high = k ? glm::max(high, bead.center + bead.radius) : bead.center + bead.radius;
+			radiusSum += bead.radius;
+		}
+		chain.center = 0.5f * (low + high);
+		chain.radius = 0.5f * glm::length(high - low);
+		chain.beadRadius = chain.residues.empty() ? MIN_BEAD_RADIUS : radiusSum / chain.residues.size();
+	}
+}
+
+size_t CoarseGrain::update(const glm::vec3 &camera, float pixelsPerUnit) {
+	size_t changed = 0;
+	for (ChainLevel &chain : chains) {
+		float distance = std::max(1.0f, glm::length(chain.center - camera) - chain.radius);
+		float atomPixels = ATOM_SIZE * pixelsPerUnit / distance;
+		float beadPixels = 2.0f * chain.beadRadius * pixelsPerUnit / distance;
+
+		Level level = CHAIN;
+		int stride = 1;
+		if (atomPixels >= pixelThreshold) {
+			level = ATOMS;
+		}
+		else if (beadPixels >= pixelThreshold) {
+			level = RESIDUES;
+		}
+		else {
+			stride = std::min(MAX_STRIDE, static_cast<int>(std::ceil(pixelThreshold / beadPixels)));
+		}
+
+		if (level != chain.level || stride != chain.stride) {
+			chain.level = level;
+			chain.stride = stride;
+			++changed;
+		}
+	}
+	return changed;
+}
+
+void CoarseGrain::clear() {
+	beads.clear();
+	chains.clear();
+}
@@ -0,0 +1,387 @@
+#include "bio/ColumnCodecs.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+//ByteArray element types
+enum ByteArrayType {
+	INT8 = 1, INT16 = 2, INT32 = 3, UINT8 = 4, UINT16 = 5, UINT32 = 6, FLOAT32 = 32, FLOAT64 = 33
+};
+
+//Intermediate result while undoing the codecs of a column
+struct Stage {
+	enum class Kind {
+		BYTES, INTEGERS, REALS, STRINGS
+	};
+
+	Kind kind = Kind::BYTES;
+	std::string_view bytes;
+	std::vector<int32_t> integers;
+	std::vector<float> reals;
+	std::vector<std::string> strings;
+};
+
+/*
+The kernels below are plain loops over contiguous arrays without aliasing or
+early exits, so the compiler turns them into SIMD code. Encoded data is
+little-endian like every platform the viewer runs on; the memcpy loads are
+compiled to unaligned vector loads.
+*/
+
+template <class T, class Out>
+void widen(const char *bytes, size_t count, Out *out) {
+	for (size_t i = 0; i < count; ++i) {
+		T value;
+		std::memcpy(&value, bytes + i * sizeof(T), sizeof(T));
+		out[i] = static_cast<Out>(value);
+	}
+}
+
+bool decodeByteArray(const MessagePackValue &encoding, Stage &stage) {
+	if (stage.kind != Stage::Kind::BYTES) {
+		return false;
+	}
+	const char *bytes = stage.bytes.data();
+	int type = static_cast<int>(encoding.find("type") ? encoding.find("type")->asInteger() : 0);
+
+	size_t width;
+	switch (type) {
+	case INT8: case UINT8: width = 1; break;
+	case INT16: case UINT16: width = 2; break;
+	case INT32: case UINT32: case FLOAT32: width = 4; break;
+	case FLOAT64: width = 8; break;
+	default: return false;
+	}
+	size_t count = stage.bytes.size() / width;
+
+	if (type == FLOAT32 || type == FLOAT64) {
+		stage.reals.resize(count);
+		if (type == FLOAT32) {
+			widen<float>(bytes, count, stage.reals.data());
+		}
+		else {
+			widen<double>(bytes, count, stage.reals.data());
+		}
+		stage.kind = Stage::Kind::REALS;
+		return true;
+	}
+
+	stage.integers.resize(count);
+	int32_t *out = stage.integers.data();
+	switch (type) {
+	case INT8: widen<int8_t>(bytes, count, out); break;
+	case UINT8: widen<uint8_t>(bytes, count, out); break;
+	case INT16: widen<int16_t>(bytes, count, out); break;
+	case UINT16: widen<uint16_t>(bytes, count, out); break;
+	default: widen<int32_t>(bytes, count, out); break;
+	}
+	stage.kind = Stage::Kind::INTEGERS;
+	return true;
+}
+
+bool decodeFixedPoint(const MessagePackValue &encoding, Stage &stage) {
+	const MessagePackValue *factor = encoding.find("factor");
+	if (stage.kind != Stage::Kind::INTEGERS || !factor || factor->asNumber() == 0.0) {
+		return false;
+	}
+	float divisor = static_cast<float>(factor->asNumber());
+	size_t count = stage.integers.size();
+	stage.reals.resize(count);
+	const int32_t *in = stage.integers.data();
+	float *out = stage.reals.data();
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = static_cast<float>(in[i]) / divisor;
+	}
+	stage.kind = Stage::Kind::REALS;
+	return true;
+}
+
+bool decodeIntervalQuantization(const MessagePackValue &encoding, Stage &stage) {
+	const MessagePackValue *min = encoding.find("min");
+	const MessagePackValue *max = encoding.find("max");
+	const MessagePackValue *steps = encoding.find("numSteps");
+	if (stage.kind != Stage::Kind::INTEGERS || !min || !max || !steps || steps->asInteger() < 2) {
+		return false;
+	}
+	float start = static_cast<float>(min->asNumber());
+	float step = static_cast<float>((max->asNumber() - min->asNumber()) / static_cast<double>(steps->asInteger() - 1));
+	size_t count = stage.integers.size();
+	stage.reals.resize(count);
+	const int32_t *in = stage.integers.data();
+	float *out = stage.reals.data();
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = start + step * static_cast<float>(in[i]);
+	}
+	stage.kind = Stage::Kind::REALS;
+	return true;
+}
+
+bool decodeRunLength(const MessagePackValue &encoding, Stage &stage) {
+	const MessagePackValue *srcSize = encoding.find("srcSize");
+	if (stage.kind != Stage::Kind::INTEGERS || !srcSize || stage.integers.size() % 2 != 0) {
+		return false;
+	}
+	size_t size = static_cast<size_t>(srcSize->asInteger());
+	std::vector<int32_t> decoded(size);
+	size_t position = 0;
+	for (size_t i = 0; i < stage.integers.size(); i += 2) {
+		int32_t value = stage.integers[i];
+		size_t run = static_cast<size_t>(std::max(stage.integers[i + 1], 0));
+		if (run > size - position) {
+			return false;
+		}
+		std::fill_n(decoded.data() + position, run, value);
+		position += run;
+	}
+	if (position != size) {
+		return false;
+	}
+	stage.integers.swap(decoded);
+	return true;
+}
+
+bool decodeDelta(const MessagePackValue &encoding, Stage &stage) {
+	const MessagePackValue *origin = encoding.find("origin");
+	if (stage.kind != Stage::Kind::INTEGERS || stage.integers.empty()) {
+		return stage.kind == Stage::Kind::INTEGERS;
+	}
+	//A prefix sum carries a dependency from element to element, keep it scalar and tight
+	int32_t *values = stage.integers.data();
+	size_t count = stage.integers.size();
+	int32_t sum = static_cast<int32_t>(origin ? origin->asInteger() : 0);
+	for (size_t i = 0; i < count; ++i) {
+		sum += values[i];
+		values[i] = sum;
+	}
+	return true;
+}
+
+bool decodeIntegerPacking(const MessagePackValue &encoding, Stage &stage) {
+	const MessagePackValue *byteCount = encoding.find("byteCount");
+	const MessagePackValue *isUnsigned = encoding.find("isUnsigned");
+	const MessagePackValue *srcSize = encoding.find("srcSize");
+	if (stage.kind != Stage::Kind::INTEGERS || !byteCount || !srcSize) {
+		return false;
+	}
+	bool unsignedValues = isUnsigned && isUnsigned->asInteger() != 0;
+	int32_t upper = byteCount->asInteger() == 1 ? (unsignedValues ? 0xFF : 0x7F) : (unsignedValues ? 0xFFFF : 0x7FFF);
+	//Unsigned packing only continues on the upper limit
+	int32_t lowerLimit = unsignedValues ? upper : -upper - 1;
+
+	const int32_t *in = stage.integers.data();
+	size_t count = stage.integers.size();
+	size_t size = static_cast<size_t>(srcSize->asInteger());
+
+	//Packed values only differ from the originals where a value overflowed the packed width
+	size_t saturated = 0;
+	for (size_t i = 0; i < count; ++i) {
+		saturated += (in[i] == upper) | (in[i] == lowerLimit);
+	}
+	if (saturated == 0) {
+		return count == size;
+	}
+
+	//Branch-free, the write position only advances once a value is complete
+	std::vector<int32_t> decoded(count + 1);
+	int32_t *out = decoded.data();
+	size_t position = 0;
+	int32_t sum = 0;
+	for (size_t i = 0; i < count; ++i) {
+		int32_t value = in[i];
+		sum += value;
+		bool continues = (value == upper) | (value == lowerLimit);
+		out[position] = sum;
+		position += !continues;
+		sum = continues ? sum : 0;
+	}
+	if (position != size) {
+		return false;
+	}
+	decoded.resize(size);
+	stage.integers.swap(decoded);
+	return true;
+}
+
+bool decodeChain(const MessagePackValue *encodings, Stage &stage);
+
+bool decodeStringArray(const MessagePackValue &encoding, Stage &stage) {
+	const MessagePackValue *dataEncoding = encoding.find("dataEncoding");
+	const MessagePackValue *stringData = encoding.find("stringData");
+	const MessagePackValue *offsetEncoding = encoding.find("offsetEncoding");
+	const MessagePackValue *offsets = encoding.find("offsets");
+	if (stage.kind != Stage::Kind::BYTES || !stringData || !offsets) {
+		return false;
+	}
+
+	Stage offsetStage;
+	offsetStage.bytes = offsets->bytes;
+	if (!decodeChain(offsetEncoding, offsetStage) || offsetStage.kind != Stage::Kind::INTEGERS ||
+		offsetStage.integers.empty()) {
+		return false;
+	}
+	if (!decodeChain(dataEncoding, stage) || stage.kind != Stage::Kind::INTEGERS) {
+		return false;
+	}
+
+	std::string_view text = stringData->asString();
+	const std::vector<int32_t> &bounds = offsetStage.integers;
+	stage.strings.clear();
+	stage.strings.reserve(bounds.size() - 1);
+	for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+		size_t begin = static_cast<size_t>(bounds[i]);
+		size_t end = static_cast<size_t>(bounds[i + 1]);
+		if (begin > end || end > text.size()) {
+			return false;
+		}
+		stage.strings.emplace_back(text.substr(begin, end - begin));
+	}
+	for (int32_t index : stage.integers) {
+		if (index >= static_cast<int32_t>(stage.strings.size())) {
+			return false;
+		}
+	}
+	stage.kind = Stage::Kind::STRINGS;
+	return true;
+}
+
+bool decodeChain(const MessagePackValue *encodings, Stage &stage) {
+	if (!encodings || encodings->type != MessagePackValue::Type::ARRAY) {
+		return false;
+	}
+	for (size_t i = encodings->size(); i-- > 0;) {
+		const MessagePackValue &encoding = (*encodings)[i];
+		const MessagePackValue *kind = encoding.find("kind");
+		std::string_view name = kind ? kind->asString() : std::string_view();
+
+		bool decoded;
+		if (name == "ByteArray") {
+			decoded = decodeByteArray(encoding, stage);
+		}
+		else if (name == "FixedPoint") {
+			decoded = decodeFixedPoint(encoding, stage);
+		}
+		else if (name == "IntervalQuantization") {
+			decoded = decodeIntervalQuantization(encoding, stage);
+		}
+		else if (name == "RunLength") {
+			decoded = decodeRunLength(encoding, stage);
+		}
+		else if (name == "Delta") {
+			decoded = decodeDelta(encoding, stage);
+		}
+		else if (name == "IntegerPacking") {
+			decoded = decodeIntegerPacking(encoding, stage);
+		}
+		else if (name == "StringArray") {
+			decoded = decodeStringArray(encoding, stage);
+		}
+		else {
+			std::cerr << "ERROR > Unsupported BinaryCIF encoding: " << name << "\n\n";
+			return false;
+		}
+		if (!decoded) {
+			return false;
+		}
+	}
+	return stage.kind != Stage::Kind::BYTES;
+}
+
+}
+
+size_t DecodedColumn::size() const {
+	return type == Type::REAL ? reals.size() : integers.size();
+}
+
+bool DecodedColumn::isNull(size_t row) const {
+	if (!mask.empty() && mask[row] != 0) {
+		return true;
+	}
+	return type == Type::STRING && integers[row] < 0;
+}
+
+int DecodedColumn::integer(size_t row) const {
+	if (isNull(row)) {
+		return 0;
+	}
+	switch (type) {
+	case Type::INTEGER:
+		return integers[row];
+	case Type::REAL:
+		return static_cast<int>(reals[row]);
+	default:
+		return std::atoi(strings[integers[row]].c_str());
+	}
+}
+
+float DecodedColumn::real(size_t row) const {
+	if (isNull(row)) {
+		return 0.0f;
+	}
+	switch (type) {
+	case Type::INTEGER:
+		return static_cast<float>(integers[row]);
+	case Type::REAL:
+		return reals[row];
+	default:
+		return static_cast<float>(std::atof(strings[integers[row]].c_str()));
+	}
+}
+
+std::string_view DecodedColumn::text(size_t row) const {
+	if (type != Type::STRING || isNull(row)) {
+		return std::string_view();
+	}
+	return strings[integers[row]];
+}
+
+bool decodeColumn(const MessagePackValue &encodedData, DecodedColumn &out) {
+	const MessagePackValue *data = encodedData.find("data");
+	if (!data) {
+		return false;
+	}
+	Stage stage;
+	stage.bytes = data->bytes;
+	if (!decodeChain(encodedData.find("encoding"), stage)) {
+		return false;
+	}
+
+	switch (stage.kind) {
+	case Stage::Kind::INTEGERS:
+		out.type = DecodedColumn::Type::INTEGER;
+		break;
+	case Stage::Kind::REALS:
+		out.type = DecodedColumn::Type::REAL;
+		break;
+	default:
+		out.type = DecodedColumn::Type::STRING;
+		break;
+	}
+	out.integers.swap(stage.integers);
+	out.reals.swap(stage.reals);
+	out.strings.swap(stage.strings);
+	return true;
+}
+
+bool decodeCategoryColumn(const MessagePackValue &column, DecodedColumn &out) {
+	const MessagePackValue *data = column.find("data");
+	if (!data || !decodeColumn(*data, out)) {
+		return false;
+	}
+
+	const MessagePackValue *mask = column.find("mask");
+	if (!mask || mask->isNil()) {
+		out.mask.clear();
+		return true;
+	}
+	DecodedColumn decodedMask;
+	if (!decodeColumn(*mask, decodedMask) || decodedMask.type != DecodedColumn::Type::INTEGER ||
+		decodedMask.integers.size() != out.size()) {
+		return false;
+	}
+	out.mask.assign(decodedMask.integers.begin(), decodedMask.integers.end());
+	return true;
+}
@@ -0,0 +1,253 @@
+#include "bio/ContactMap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include "bio/Parallel.h"
+#include "bio/SpatialGrid.h"
+
+namespace {
+
+//Residues are searched in chunks so workers finishing early can be given more
+constexpr size_t CHUNK_SIZE = 256;
+//Rows of the distance matrix per task
+constexpr size_t TILE_ROWS = 32;
+
+size_t residueEnd(const AtomTable &atoms, size_t residue) {
+	return residue + 1 < atoms.residueCount() ? atoms.residueAtomStarts[residue + 1] : atoms.size();
+}
+
+}
+
+void ContactMap::clear() {
+	offsets.clear();
+	partners.clear();
+	distances.clear();
+	heavy.clear();
+	candidateOffsets.clear();
+	candidatePartners.clear();
+	candidateDistances.clear();
+	gatheredX.clear();
+	gatheredY.clear();
+	gatheredZ.clear();
+}
+
+void ContactMap::compute(const AtomTable &atoms) {
+	clear();
+	size_t residueCount = atoms.residueCount();
+	candidateOffsets.assign(residueCount + 1, 0);
+
+	std::vector<uint8_t> heavyElements(atoms.elements.size());
+	for (size_t id = 0; id < heavyElements.size(); ++id) {
+		const std::string &element = atoms.elements[static_cast<uint16_t>(id)];
+		heavyElements[id] = element != "H" && element != "D";
+	}
+	heavy.resize(atoms.size());
+	std::vector<uint32_t> heavyAtoms;
+	std::vector<float> x, y, z;
+	for (size_t i = 0; i < atoms.size(); ++i) {
+		heavy[i] = heavyElements[atoms.elementIds[i]];
+		if (heavy[i]) {
+			heavyAtoms.push_back(static_cast<uint32_t>(i));
+			x.push_back(atoms.x[i]);
+			y.push_back(atoms.y[i]);
+			z.push_back(atoms.z[i]);
+		}
+	}
+	gatheredX = atoms.x;
+	gatheredY = atoms.y;
+	gatheredZ = atoms.z;
+	if (heavyAtoms.empty()) {
+		offsets.assign(residueCount + 1, 0);
+		return;
+	}
+
+	float reach = cutoff + skin;
+	SpatialGrid grid;
+	grid.build(x.data(), y.data(), z.data(), heavyAtoms.size(), reach);
+
+	size_t chunkCount = (residueCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	std::vector<std::vector<uint32_t>> chunkPartners(chunkCount);
+	std::vector<std::vector<float>> chunkDistances(chunkCount);
+
+	//Candidate counts go to candidateOffsets[residue + 1] so a prefix sum turns them into offsets
+	parallelFor(chunkCount, [&](size_t firstChunk, size_t lastChunk) {
+		//Closest squared distance to every residue met so far, reset after each residue
+		std::vector<float> nearest(residueCount, std::numeric_limits<float>::max());
+		std::vector<uint32_t> touched;
+		for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+			size_t end = std::min(residueCount, (chunk + 1) * CHUNK_SIZE);
+			for (size_t residue = chunk * CHUNK_SIZE; residue < end; ++residue) {
+				for (size_t atom = atoms.residueAtomStarts[residue]; atom < residueEnd(atoms, residue); ++atom) {
+					if (!heavy[atom]) {
+						continue;
+					}
+					float xi = atoms.x[atom], yi = atoms.y[atom], zi = atoms.z[atom];
+					grid.forEachNearSlot(xi, yi, zi, [&](size_t slot) {
+						uint32_t otherResidue = atoms.residueIndices[heavyAtoms[grid.items[slot]]];
+						if (otherResidue <= residue) {
+							return;
+						}
+						float dx = grid.slotX[slot] - xi, dy = grid.slotY[slot] - yi, dz = grid.slotZ[slot] - zi;
+						float distance2 = dx * dx + dy * dy + dz * dz;
+						if (distance2 < reach * reach && distance2 < nearest[otherResidue]) {
+							if (nearest[otherResidue] == std::numeric_limits<float>::max()) {
+								touched.push_back(otherResidue);
+							}
+							nearest[otherResidue] = distance2;
+						}
+					});
+				}
+				std::sort(touched.begin(), touched.end());
+				for (uint32_t otherResidue : touched) {
+					chunkPartners[chunk].push_back(otherResidue);
+					chunkDistances[chunk].push_back(std::sqrt(nearest[otherResidue]));
+					nearest[otherResidue] = std::numeric_limits<float>::max();
+				}
+				candidateOffsets[residue + 1] = static_cast<uint32_t>(touched.size());
+				touched.clear();
+			}
+		}
+	});
+
+	for (size_t i = 1; i <= residueCount; ++i) {
+		candidateOffsets[i] += candidateOffsets[i - 1];
+	}
+	//Chunks hold consecutive residues, so their lists concatenate in residue order
+	candidatePartners.reserve(candidateOffsets[residueCount]);
+	candidateDistances.reserve(candidateOffsets[residueCount]);
+	for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+		candidatePartners.insert(candidatePartners.end(), chunkPartners[chunk].begin(), chunkPartners[chunk].end());
+		candidateDistances.insert(candidateDistances.end(), chunkDistances[chunk].begin(), chunkDistances[chunk].end());
+	}
+	collectContacts();
+}
+
+bool ContactMap::update(const AtomTable &atoms) {
+	//An empty table matches the empty buffers of a map never computed, so check the candidates too
+	if (candidateOffsets.empty() || gatheredX.size() != atoms.size() || heavy.size() != atoms.size()) {
+		compute(atoms);
+		return true;
+	}
+
+	float limit = 0.5f * skin;
+	std::atomic<bool> moved(false);
+	parallelFor(atoms.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end && !moved.load(std::memory_order_relaxed); ++i) {
+			float dx = atoms.x[i] - gatheredX[i], dy = atoms.y[i] - gatheredY[i], dz = atoms.z[i] - gatheredZ[i];
+			if (heavy[i] && dx * dx + dy * dy + dz * dz > limit * limit) {
+				moved = true;
+			}
+		}
+	}, 1 << 16);
+	if (moved) {
+		compute(atoms);
+		return true;
+	}
+
+	size_t residueCount = candidateOffsets.size() - 1;
+	parallelFor(residueCount, [&](size_t begin, size_t end) {
+		for (size_t residue = begin; residue < end; ++residue) {
+			for (uint32_t k = candidateOffsets[residue]; k < candidateOffsets[residue + 1]; ++k) {
+				candidateDistances[k] = residueDistance(atoms, static_cast<uint32_t>(residue), candidatePartners[k]);
+			}
+		}
+	}, 64);
+	collectContacts();
+	return false;
+}
+
+float ContactMap::distance(uint32_t first, uint32_t second) const {
+	if (first > second) {
+		std::swap(first, second);
+	}
+	if (first + 1 >= offsets.size()) {
+		return -1.0f;
+	}
+	auto begin = partners.begin() + offsets[first];
+	auto end = partners.begin() + offsets[first + 1];
+	auto found = std::lower_bound(begin, end, second);
+	return found != end && *found == second ? distances[found - partners.begin()] : -1.0f;
+}
+
+void ContactMap::distanceMatrix(const AtomTable &atoms, size_t rowBegin, size_t rowEnd,
+	size_t columnBegin, size_t columnEnd, float *out) {
+	std::vector<uint8_t> isCA(atoms.names.size());
+	for (size_t id = 0; id < isCA.size(); ++id) {
+		isCA[id] = atoms.names[static_cast<uint16_t>(id)] == "CA";
+	}
+	auto caPositions = [&](size_t begin, size_t end, std::vector<float> &x, std::vector<float> &y, std::vector<float> &z) {
+		x.assign(end - begin, std::numeric_limits<float>::quiet_NaN());
+		y.assign(end - begin, std::numeric_limits<float>::quiet_NaN());
+		z.assign(end - begin, std::numeric_limits<float>::quiet_NaN());
+		for (size_t residue = begin; residue < end; ++residue) {
+			for (size_t atom = atoms.residueAtomStarts[residue]; atom < residueEnd(atoms, residue); ++atom) {
+				if (isCA[atoms.nameIds[atom]]) {
+					x[residue - begin] = atoms.x[atom];
+					y[residue - begin] = atoms.y[atom];
+					z[residue - begin] = atoms.z[atom];
+					break;
+				}
+			}
+		}
+	};
+
+	std::vector<float> rowX, rowY, rowZ, columnX, columnY, columnZ;
+	caPositions(rowBegin, rowEnd, rowX, rowY, rowZ);
+	caPositions(columnBegin, columnEnd, columnX, columnY, columnZ);
+	size_t columns = columnEnd - columnBegin;
+	size_t tiles = (rowEnd - rowBegin + TILE_ROWS - 1) / TILE_ROWS;
+
+	parallelFor(tiles, [&](size_t firstTile, size_t lastTile) {
+		for (size_t row = firstTile * TILE_ROWS; row < std::min(rowEnd - rowBegin, lastTile * TILE_ROWS); ++row) {
+			float xi = rowX[row], yi = rowY[row], zi = rowZ[row];
+			float *line = out + row * columns;
+			for (size_t column = 0; column < columns; ++column) {
+				float dx = columnX[column] - xi, dy = columnY[column] - yi, dz = columnZ[column] - zi;
+				line[column] = std::sqrt(dx * dx + dy * dy + dz * dz);
+			}
+		}
+	});
+}
+
+float ContactMap::residueDistance(const AtomTable &atoms, uint32_t first, uint32_t second) const {
+	float nearest = std::numeric_limits<float>::max();
+	size_t secondBegin = atoms.residueAtomStarts[second], secondEnd = residueEnd(atoms, second);
+	for (size_t a = atoms.residueAtomStarts[first]; a < residueEnd(atoms, first); ++a) {
+		if (!heavy[a]) {
+			continue;
+		}
+		for (size_t b = secondBegin; b < secondEnd; ++b) {
+			float dx = atoms.x[b] - atoms.x[a], dy = atoms.y[b] - atoms.y[a], dz = atoms.z[b] - atoms.z[a];
+			float distance2 = dx * dx + dy * dy + dz * dz;
+			if (heavy[b] && distance2 < nearest) {
+				nearest = distance2;
+			}
+		}
+	}
+	return std::sqrt(nearest);
+}
+
+void ContactMap::collectContacts() {
+	if (candidateOffsets.empty()) {
+		offsets.assign(1, 0);
+		partners.clear();
+		distances.clear();
+		return;
+	}
+	size_t residueCount = candidateOffsets.size() - 1;
+	offsets.assign(residueCount + 1, 0);
+	partners.clear();
+	distances.clear();
+	for (size_t residue = 0; residue < residueCount; ++residue) {
+		for (uint32_t k = candidateOffsets[residue]; k < candidateOffsets[residue + 1]; ++k) {
+			if (candidateDistances[k] < cutoff) {
+				partners.push_back(candidatePartners[k]);
+				distances.push_back(candidateDistances[k]);
+			}
+		}
+		offsets[residue + 1] = static_cast<uint32_t>(partners.size());
+	}
+}
@@ -0,0 +1,105 @@
+#include "bio/DCDFile.h"
+
+#include <iostream>
+
+namespace {
+
+//Length of the first record, "CORD" and 20 control ints
+constexpr uint32_t HEADER_RECORD = 84;
+
+//Control ints after "CORD"
+constexpr size_t FIXED_ATOMS = 8;
+constexpr size_t HAS_UNIT_CELL = 10;
+constexpr size_t HAS_FOURTH_DIMENSION = 11;
+constexpr size_t CHARMM_VERSION = 19;
+
+uint32_t byteSwap(uint32_t value) {
+	return value >> 24 | (value >> 8 & 0xFF00) | (value << 8 & 0xFF0000) | value << 24;
+}
+
+}
+
+uint32_t DCDFile::readInt(const char *data) const {
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return swapped ? byteSwap(value) : value;
+}
+
+float DCDFile::readFloat(const char *data) const {
+	uint32_t bits = readInt(data);
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+DCDFile::DCDFile(const std::string &path) :
+	TrajectoryFile(path) {
+	if (!file.isOpen()) {
+		return;
+	}
+	const char *data = file.data();
+	size_t size = file.size();
+
+	uint32_t marker = 0;
+	if (size >= HEADER_RECORD + 8) {
+		std::memcpy(&marker, data, sizeof(marker));
+	}
+	if ((marker != HEADER_RECORD && byteSwap(marker) != HEADER_RECORD) || std::memcmp(data + 4, "CORD", 4) != 0) {
+		std::cerr << "ERROR > Not a DCD file: " << path << "\n\n";
+		return;
+	}
+	swapped = marker != HEADER_RECORD;
+
+	const char *control = data + 8;
+	bool charmm = readInt(control + 4 * CHARMM_VERSION) != 0;
+	if (readInt(control + 4 * FIXED_ATOMS) != 0) {
+		std::cerr << "ERROR > DCD files with fixed atoms aren't supported: " << path << "\n\n";
+		return;
+	}
+	bool unitCell = charmm && readInt(control + 4 * HAS_UNIT_CELL) != 0;
+	bool fourthDimension = charmm && readInt(control + 4 * HAS_FOURTH_DIMENSION) != 0;
+
+	//Title record, then the atom count record
+	size_t position = HEADER_RECORD + 8;
+	if (position + 4 > size) {
+		return;
+	}
+	position += readInt(data + position) + 8;
+	if (position + 12 > size || readInt(data + position) != 4) {
+		std::cerr << "ERROR > Malformed DCD header: " << path << "\n\n";
+		return;
+	}
+	atoms = readInt(data + position + 4);
+	position += 12;
+
+	size_t coordinateRecord = 4 * atoms + 8;
+	if (unitCell && position + 4 <= size) {
+		cellRecordSize = readInt(data + position) + 8;
+	}
+	size_t frameSize = cellRecordSize + (fourthDimension ? 4 : 3) * coordinateRecord;
+
+	//Every frame has the same size, a partly written last frame is left out
+	size_t frames = (size - position) / frameSize;
+	frameOffsets.resize(frames + 1);
+	for (size_t i = 0; i <= frames; ++i) {
+		frameOffsets[i] = position + i * frameSize;
+	}
+}
+
+bool DCDFile::decodeFrame(const char *data, size_t size, float *xyz) const {
+	size_t coordinateRecord = 4 * atoms + 8;
+	if (size < cellRecordSize + 3 * coordinateRecord) {
+		return false;
+	}
+	//X, Y and Z are separate records, interleave them
+	for (size_t axis = 0; axis < 3; ++axis) {
+		const char *record = data + cellRecordSize + axis * coordinateRecord;
+		if (readInt(record) != 4 * atoms) {
+			return false;
+		}
+		for (size_t i = 0; i < atoms; ++i) {
+			xyz[3 * i + axis] = readFloat(record + 4 + 4 * i);
+		}
+	}
+	return true;
+}
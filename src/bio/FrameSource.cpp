@@ -0,0 +1,39 @@
+#include "bio/FrameSource.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+#include "bio/DCDFile.h"
+#include "bio/PDBModelSource.h"
+#include "bio/TRRFile.h"
+#include "bio/XTCFile.h"
+
+void FrameSource::readFrames(const size_t *frames, float *const *outputs, bool *results, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = readFrame(frames[i], outputs[i]);
+	}
+}
+
+std::unique_ptr<FrameSource> openFrameSource(const std::string &path) {
+	size_t dot = path.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+		return static_cast<char>(std::tolower(c));
+	});
+
+	if (extension == "xtc") {
+		return std::make_unique<XTCFile>(path);
+	}
+	if (extension == "trr") {
+		return std::make_unique<TRRFile>(path);
+	}
+	if (extension == "dcd") {
+		return std::make_unique<DCDFile>(path);
+	}
+	if (extension == "pdb" || extension == "ent") {
+		return std::make_unique<PDBModelSource>(path);
+	}
+	std::cerr << "ERROR > Unknown trajectory format: " << path << "\n\n";
+	return nullptr;
+}
@@ -0,0 +1,239 @@
+#include "bio/Hierarchy.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+template <class T>
+void permute(std::vector<T> &column, const std::vector<uint32_t> &order) {
+	std::vector<T> sorted(order.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		sorted[i] = column[order[i]];
+	}
+	column.swap(sorted);
+}
+
+}
+
+int Hierarchy::findModel(int modelNumber) const {
+	auto found = std::lower_bound(modelNumbers.begin(), modelNumbers.end(), modelNumber);
+	return found != modelNumbers.end() && *found == modelNumber ? static_cast<int>(found - modelNumbers.begin()) : -1;
+}
+
+int Hierarchy::findChain(size_t model, char chain) const {
+	Range range = chains(model);
+	auto begin = chainIds.begin() + range.first, end = chainIds.begin() + range.last;
+	auto found = std::lower_bound(begin, end, chain);
+	return found != end && *found == chain ? static_cast<int>(found - chainIds.begin()) : -1;
+}
+
+int Hierarchy::findResidue(size_t chain, int residueNum, char insertionCode) const {
+	Range range = residues(chain);
+	uint32_t first = range.first, count = range.last - range.first;
+	//Residues are sorted by number, then insertion code
+	while (count > 0) {
+		uint32_t half = count / 2, middle = first + half;
+		if (residueNums[middle] < residueNum ||
+			(residueNums[middle] == residueNum && insertionCodes[middle] < insertionCode)) {
+			first = middle + 1;
+			count -= half + 1;
+		} else {
+			count = half;
+		}
+	}
+	if (first < range.last && residueNums[first] == residueNum && insertionCodes[first] == insertionCode) {
+		return static_cast<int>(first);
+	}
+	return -1;
+}
+
+int Hierarchy::findAtom(size_t residue, int serial) const {
+	Range range = atoms(residue);
+	auto begin = serials.begin() + range.first, end = serials.begin() + range.last;
+	auto found = std::lower_bound(begin, end, serial);
+	return found != end && *found == serial ? static_cast<int>(found - serials.begin()) : -1;
+}
+
+void Hierarchy::clear() {
+	modelNumbers.clear();
+	modelChainStarts.clear();
+	chainIds.clear();
+	chainResidueStarts.clear();
+	residueNums.clear();
+	insertionCodes.clear();
+	residueNameIds.clear();
+	residueAtomStarts.clear();
+	x.clear();
+	y.clear();
+	z.clear();
+	serials.clear();
+	nameIds.clear();
+	elementIds.clear();
+	altLocs.clear();
+	occupancies.clear();
+	bFactors.clear();
+	charges.clear();
+	hetero.clear();
+	names.clear();
+	residueNames.clear();
+	elements.clear();
+	pending.clear();
+}
+
+void Hierarchy::reserve(size_t atomCount) {
+	x.reserve(atomCount);
+	y.reserve(atomCount);
+	z.reserve(atomCount);
+	serials.reserve(atomCount);
+	nameIds.reserve(atomCount);
+	elementIds.reserve(atomCount);
+	altLocs.reserve(atomCount);
+	occupancies.reserve(atomCount);
+	bFactors.reserve(atomCount);
+	charges.reserve(atomCount);
+	hetero.reserve(atomCount);
+	pending.reserve(atomCount);
+}
+
+void Hierarchy::add(int modelNumber, char chain, int residueNum, char insertionCode, std::string_view residueName,
+	int serial, std::string_view name, float atomX, float atomY, float atomZ, std::string_view element,
+	char altLoc, float occupancy, float bFactor, int charge, bool isHetero) {
+	pending.push_back({modelNumber, chain, insertionCode, residueNames.intern(residueName), residueNum, serial,
+		static_cast<uint32_t>(x.size())});
+	x.push_back(atomX);
+	y.push_back(atomY);
+	z.push_back(atomZ);
+	serials.push_back(serial);
+	nameIds.push_back(names.intern(name));
+	elementIds.push_back(elements.intern(element));
+	altLocs.push_back(altLoc);
+	occupancies.push_back(occupancy);
+	bFactors.push_back(bFactor);
+	charges.push_back(static_cast<int8_t>(charge));
+	hetero.push_back(isHetero);
+}
+
+void Hierarchy::finish() {
+	if (pending.empty()) {
+		return;
+	}
+
+	//Atoms of an earlier finish() are staged again, in front since they come first in the columns
+	std::vector<Pending> keys;
+	keys.reserve(size());
+	for (size_t model = 0; model < modelCount(); ++model) {
+		for (uint32_t chain = modelChainStarts[model]; chain < modelChainStarts[model + 1]; ++chain) {
+			for (uint32_t residue = chainResidueStarts[chain]; residue < chainResidueStarts[chain + 1]; ++residue) {
+				for (uint32_t atom = residueAtomStarts[residue]; atom < residueAtomStarts[residue + 1]; ++atom) {
+					keys.push_back({modelNumbers[model], chainIds[chain], insertionCodes[residue],
+						residueNameIds[residue], residueNums[residue], serials[atom], atom});
+				}
+			}
+		}
+	}
+	keys.insert(keys.end(), pending.begin(), pending.end());
+	pending.clear();
+	pending.shrink_to_fit();
+
+	auto before = [](const Pending &a, const Pending &b) {
+		if (a.modelNumber != b.modelNumber) {
+			return a.modelNumber < b.modelNumber;
+		}
+		if (a.chain != b.chain) {
+			return a.chain < b.chain;
+		}
+		if (a.residueNum != b.residueNum) {
+			return a.residueNum < b.residueNum;
+		}
+		if (a.insertionCode != b.insertionCode) {
+			return a.insertionCode < b.insertionCode;
+		}
+		return a.serial < b.serial;
+	};
+	if (!std::is_sorted(keys.begin(), keys.end(), before)) {
+		std::stable_sort(keys.begin(), keys.end(), before);
+	}
+
+	std::vector<uint32_t> order(keys.size());
+	bool inOrder = true;
+	for (size_t i = 0; i < keys.size(); ++i) {
+		order[i] = keys[i].atom;
+		inOrder = inOrder && order[i] == i;
+	}
+	if (!inOrder) {
+		permute(x, order);
+		permute(y, order);
+		permute(z, order);
+		permute(serials, order);
+		permute(nameIds, order);
+		permute(elementIds, order);
+		permute(altLocs, order);
+		permute(occupancies, order);
+		permute(bFactors, order);
+		permute(charges, order);
+		permute(hetero, order);
+	}
+
+	modelNumbers.clear();
+	modelChainStarts.clear();
+	chainIds.clear();
+	chainResidueStarts.clear();
+	residueNums.clear();
+	insertionCodes.clear();
+	residueNameIds.clear();
+	residueAtomStarts.clear();
+	for (size_t i = 0; i < keys.size(); ++i) {
+		const Pending &key = keys[i];
+		bool newModel = i == 0 || key.modelNumber != keys[i - 1].modelNumber;
+		bool newChain = newModel || key.chain != keys[i - 1].chain;
+		bool newResidue = newChain || key.residueNum != keys[i - 1].residueNum ||
+			key.insertionCode != keys[i - 1].insertionCode;
+		if (newModel) {
+			modelNumbers.push_back(key.modelNumber);
+			modelChainStarts.push_back(static_cast<uint32_t>(chainIds.size()));
+		}
+		if (newChain) {
+			chainIds.push_back(key.chain);
+			chainResidueStarts.push_back(static_cast<uint32_t>(residueNums.size()));
+		}
+		if (newResidue) {
+			residueNums.push_back(key.residueNum);
+			insertionCodes.push_back(key.insertionCode);
+			residueNameIds.push_back(key.residueNameId);
+			residueAtomStarts.push_back(static_cast<uint32_t>(i));
+		}
+	}
+	modelChainStarts.push_back(static_cast<uint32_t>(chainIds.size()));
+	chainResidueStarts.push_back(static_cast<uint32_t>(residueNums.size()));
+	residueAtomStarts.push_back(static_cast<uint32_t>(keys.size()));
+}
+
+void Hierarchy::build(const AtomTable &atoms, int modelNumber) {
+	clear();
+	names = atoms.names;
+	residueNames = atoms.residueNames;
+	elements = atoms.elements;
+
+	size_t count = atoms.size();
+	x = atoms.x;
+	y = atoms.y;
+	z = atoms.z;
+	bFactors = atoms.bFactors;
+	nameIds = atoms.nameIds;
+	elementIds = atoms.elementIds;
+	serials.resize(count);
+	std::iota(serials.begin(), serials.end(), 1);
+	altLocs.assign(count, ' ');
+	occupancies.assign(count, 1.0f);
+	charges.assign(count, 0);
+	hetero.assign(count, 0);
+
+	pending.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		uint32_t residue = atoms.residueIndices[i];
+		pending[i] = {modelNumber, atoms.chainIds[atoms.residueChainIndices[residue]], ' ',
+			atoms.residueNameIds[residue], atoms.residueNums[residue], serials[i], static_cast<uint32_t>(i)};
+	}
+	finish();
+}
@@ -0,0 +1,114 @@
+#include "bio/MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char EMPTY_FILE[1] = {'\0'};
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path) {
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		std::cerr << "ERROR > Could not open file: " << path << "\n\n";
+		return;
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		std::cerr << "ERROR > Could not read size of file: " << path << "\n\n";
+		return;
+	}
+	length = static_cast<size_t>(fileSize.QuadPart);
+	if (length == 0) {
+		mapped = EMPTY_FILE;
+		return;
+	}
+
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle) {
+		mapped = static_cast<const char *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!mapped) {
+		std::cerr << "ERROR > Could not map file: " << path << "\n\n";
+		length = 0;
+	}
+}
+
+MappedFile::~MappedFile() {
+	if (mapped && mapped != EMPTY_FILE) {
+		UnmapViewOfFile(mapped);
+	}
+	if (mappingHandle) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle) {
+		CloseHandle(fileHandle);
+	}
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "ERROR > Could not open file: " << path << "\n\n";
+		return;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		std::cerr << "ERROR > Could not read size of file: " << path << "\n\n";
+		close(fd);
+		return;
+	}
+	length = static_cast<size_t>(info.st_size);
+	if (length == 0) {
+		mapped = EMPTY_FILE;
+		close(fd);
+		return;
+	}
+
+	void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	//The mapping keeps its own reference to the file
+	close(fd);
+	if (address == MAP_FAILED) {
+		std::cerr << "ERROR > Could not map file: " << path << "\n\n";
+		length = 0;
+		return;
+	}
+	//Files are read front to back by each worker
+	madvise(address, length, MADV_SEQUENTIAL);
+	mapped = static_cast<const char *>(address);
+}
+
+MappedFile::~MappedFile() {
+	if (mapped && mapped != EMPTY_FILE) {
+		munmap(const_cast<char *>(mapped), length);
+	}
+}
+
+#endif
+
+bool MappedFile::isOpen() const {
+	return mapped != nullptr;
+}
+
+const char *MappedFile::data() const {
+	return mapped;
+}
+
+size_t MappedFile::size() const {
+	return length;
+}
@@ -0,0 +1,248 @@
+#include "bio/MessagePack.h"
+
+#include <cstring>
+
+namespace {
+
+//Deepest nesting of arrays and maps accepted, BinaryCIF needs less than ten levels
+constexpr int MAX_DEPTH = 64;
+
+class Reader {
+private:
+	const unsigned char *cursor;
+	const unsigned char *end;
+	int depth = 0;
+
+public:
+	Reader(const char *data, size_t size) :
+		cursor(reinterpret_cast<const unsigned char *>(data)),
+		end(reinterpret_cast<const unsigned char *>(data) + size) {}
+
+	bool has(size_t count) const {
+		return static_cast<size_t>(end - cursor) >= count;
+	}
+
+	//Big-endian unsigned integer of the given width
+	bool readUnsigned(size_t width, unsigned long long &value) {
+		if (!has(width)) {
+			return false;
+		}
+		value = 0;
+		for (size_t i = 0; i < width; ++i) {
+			value = (value << 8) | cursor[i];
+		}
+		cursor += width;
+		return true;
+	}
+
+	bool readBytes(size_t count, std::string_view &bytes) {
+		if (!has(count)) {
+			return false;
+		}
+		bytes = std::string_view(reinterpret_cast<const char *>(cursor), count);
+		cursor += count;
+		return true;
+	}
+
+	bool readSized(size_t lengthWidth, std::string_view &bytes) {
+		unsigned long long length;
+		return readUnsigned(lengthWidth, length) && readBytes(static_cast<size_t>(length), bytes);
+	}
+
+	bool readItems(size_t count, MessagePackValue &out) {
+		//Every item takes at least one byte, reject counts the buffer can't hold before allocating
+		if (!has(count)) {
+			return false;
+		}
+		//Malformed input could otherwise nest deep enough to overflow the stack
+		if (depth == MAX_DEPTH) {
+			return false;
+		}
+		++depth;
+		out.items.resize(count);
+		for (auto &item : out.items) {
+			if (!read(item)) {
+				return false;
+			}
+		}
+		--depth;
+		return true;
+	}
+
+	bool read(MessagePackValue &out) {
+		if (!has(1)) {
+			return false;
+		}
+		unsigned char marker = *cursor++;
+		unsigned long long value;
+
+		if (marker <= 0x7f) {
+			out.type = MessagePackValue::Type::INTEGER;
+			out.integer = marker;
+			return true;
+		}
+		if (marker >= 0xe0) {
+			out.type = MessagePackValue::Type::INTEGER;
+			out.integer = static_cast<signed char>(marker);
+			return true;
+		}
+		if ((marker & 0xf0) == 0x80) {
+			out.type = MessagePackValue::Type::MAP;
+			return readItems((marker & 0x0f) * 2, out);
+		}
+		if ((marker & 0xf0) == 0x90) {
+			out.type = MessagePackValue::Type::ARRAY;
+			return readItems(marker & 0x0f, out);
+		}
+		if ((marker & 0xe0) == 0xa0) {
+			out.type = MessagePackValue::Type::STRING;
+			return readBytes(marker & 0x1f, out.bytes);
+		}
+
+		switch (marker) {
+		case 0xc0:
+			out.type = MessagePackValue::Type::NIL;
+			return true;
+		case 0xc2:
+		case 0xc3:
+			out.type = MessagePackValue::Type::BOOLEAN;
+			out.integer = marker == 0xc3;
+			return true;
+		case 0xc4:
+		case 0xc5:
+		case 0xc6:
+			out.type = MessagePackValue::Type::BINARY;
+			return readSized(size_t(1) << (marker - 0xc4), out.bytes);
+		case 0xc7:
+		case 0xc8:
+		case 0xc9: {
+			//Extension: length, type byte, payload
+			unsigned long long length;
+			out.type = MessagePackValue::Type::BINARY;
+			return readUnsigned(size_t(1) << (marker - 0xc7), length) && readUnsigned(1, value) &&
+				readBytes(static_cast<size_t>(length), out.bytes);
+		}
+		case 0xca: {
+			float number;
+			uint32_t bits;
+			if (!readUnsigned(4, value)) {
+				return false;
+			}
+			bits = static_cast<uint32_t>(value);
+			std::memcpy(&number, &bits, sizeof(number));
+			out.type = MessagePackValue::Type::FLOAT;
+			out.number = number;
+			return true;
+		}
+		case 0xcb: {
+			if (!readUnsigned(8, value)) {
+				return false;
+			}
+			std::memcpy(&out.number, &value, sizeof(out.number));
+			out.type = MessagePackValue::Type::FLOAT;
+			return true;
+		}
+		case 0xcc:
+		case 0xcd:
+		case 0xce:
+		case 0xcf:
+			if (!readUnsigned(size_t(1) << (marker - 0xcc), value)) {
+				return false;
+			}
+			out.type = MessagePackValue::Type::INTEGER;
+			out.integer = static_cast<long long>(value);
+			return true;
+		case 0xd0:
+		case 0xd1:
+		case 0xd2:
+		case 0xd3: {
+			size_t width = size_t(1) << (marker - 0xd0);
+			if (!readUnsigned(width, value)) {
+				return false;
+			}
+			//Sign-extend from the encoded width
+			unsigned int shift = static_cast<unsigned int>(64 - width * 8);
+			out.type = MessagePackValue::Type::INTEGER;
+			out.integer = static_cast<long long>(value << shift) >> shift;
+			return true;
+		}
+		case 0xd4:
+		case 0xd5:
+		case 0xd6:
+		case 0xd7:
+		case 0xd8:
+			out.type = MessagePackValue::Type::BINARY;
+			return readUnsigned(1, value) && readBytes(size_t(1) << (marker - 0xd4), out.bytes);
+		case 0xd9:
+		case 0xda:
+		case 0xdb:
+			out.type = MessagePackValue::Type::STRING;
+			return readSized(size_t(1) << (marker - 0xd9), out.bytes);
+		case 0xdc:
+		case 0xdd:
+			if (!readUnsigned(marker == 0xdc ? 2 : 4, value)) {
+				return false;
+			}
+			out.type = MessagePackValue::Type::ARRAY;
+			return readItems(static_cast<size_t>(value), out);
+		case 0xde:
+		case 0xdf:
+			if (!readUnsigned(marker == 0xde ? 2 : 4, value)) {
+				return false;
+			}
+			out.type = MessagePackValue::Type::MAP;
+			return readItems(static_cast<size_t>(value) * 2, out);
+		default:
+			return false;
+		}
+	}
+};
+
+}
+
+bool MessagePackValue::parse(const char *data, size_t size, MessagePackValue &out) {
+	Reader reader(data, size);
+	return reader.read(out);
+}
+
+const MessagePackValue *MessagePackValue::find(std::string_view key) const {
+	if (type != Type::MAP) {
+		return nullptr;
+	}
+	for (size_t i = 0; i + 1 < items.size(); i += 2) {
+		if (items[i].type == Type::STRING && items[i].bytes == key) {
+			return &items[i + 1];
+		}
+	}
+	return nullptr;
+}
+
+size_t MessagePackValue::size() const {
+	return type == Type::MAP ? items.size() / 2 : items.size();
+}
+
+const MessagePackValue &MessagePackValue::operator[](size_t index) const {
+	return items[index];
+}
+
+bool MessagePackValue::isNil() const {
+	return type == Type::NIL;
+}
+
+double MessagePackValue::asNumber() const {
+	if (type == Type::FLOAT) {
+		return number;
+	}
+	return type == Type::INTEGER ? static_cast<double>(integer) : 0.0;
+}
+
+long long MessagePackValue::asInteger() const {
+	if (type == Type::INTEGER || type == Type::BOOLEAN) {
+		return integer;
+	}
+	return type == Type::FLOAT ? static_cast<long long>(number) : 0;
+}
+
+std::string_view MessagePackValue::asString() const {
+	return type == Type::STRING ? bytes : std::string_view();
+}
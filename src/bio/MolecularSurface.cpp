@@ -0,0 +1,727 @@
+#include "bio/MolecularSurface.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "bio/Element.h"
+#include "bio/Parallel.h"
+#include "bio/SpatialGrid.h"
+
+namespace {
+
+constexpr int BLOCK_SIZE = MolecularSurface::BLOCK_SIZE;
+//Samples per block and axis, the last layer is the first one of the next block
+constexpr int BLOCK_SAMPLES = BLOCK_SIZE + 1;
+constexpr uint32_t NOT_OWNED = UINT32_MAX;
+constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+//Room left around the atoms when the grid is sized, so moving atoms don't regrow it every frame
+constexpr float GRID_SLACK = 4.0f;
+
+constexpr float GOLDEN_ANGLE = 2.39996323f;
+constexpr float PI = 3.14159265f;
+
+/*
+Corner c of a cube sits at (c & 1, c >> 1 & 1, c >> 2 & 1). Edge e runs along
+axis e / 4 from corner EDGE_CORNERS[e].
+*/
+constexpr int EDGE_CORNERS[12] = {0, 2, 4, 6, 0, 1, 4, 5, 0, 1, 2, 3};
+
+int edgeBetween(int first, int second) {
+	int bit = first ^ second;
+	int axis = bit == 1 ? 0 : bit == 2 ? 1 : 2;
+	int low = std::min(first, second);
+	for (int edge = axis * 4; edge < axis * 4 + 4; ++edge) {
+		if (EDGE_CORNERS[edge] == low) {
+			return edge;
+		}
+	}
+	return -1;
+}
+
+//Bit axis * 2 + side for each of the two cube faces the edge lies on
+int edgeFaces(int edge) {
+	int axis = edge / 4;
+	int faces = 0;
+	for (int other = 0; other < 3; ++other) {
+		if (other != axis) {
+			faces |= 1 << (other * 2 + (EDGE_CORNERS[edge] >> other & 1));
+		}
+	}
+	return faces;
+}
+
+struct CubeCase {
+	int triangleCount;
+	int8_t edges[30];
+};
+
+/*
+Marching cubes triangles for the 256 inside/outside corner combinations.
+Instead of a hand written table, every face of the cube contributes segments
+that cut its inside corners off, oriented counterclockwise seen from outside,
+and the segments are chained into loops which are fanned into triangles.
+A face's segments only depend on its own corners and ambiguous faces always
+separate the inside corners, so neighboring cubes agree on their shared face
+and the surface has no cracks. Loops are fanned from a vertex whose diagonals
+never join two edges of one face, which the neighbor could repeat.
+*/
+std::array<CubeCase, 256> buildCubeCases() {
+	std::array<CubeCase, 256> cases{};
+	for (int index = 0; index < 256; ++index) {
+		auto inside = [&](int corner) {
+			return (index >> corner & 1) != 0;
+		};
+
+		int next[12];
+		std::fill(next, next + 12, -1);
+		for (int axis = 0; axis < 3; ++axis) {
+			int u = axis == 0 ? 1 : 0;
+			int v = axis == 2 ? 1 : 2;
+			for (int side = 0; side < 2; ++side) {
+				int base = side << axis;
+				int cycle[4] = {base, base | 1 << u, base | 1 << u | 1 << v, base | 1 << v};
+				//The cycle turns counterclockwise around +x and +z but around -y
+				if ((axis != 1) != (side == 1)) {
+					std::swap(cycle[1], cycle[3]);
+				}
+				for (int t = 0; t < 4; ++t) {
+					int previous = cycle[(t + 3) % 4];
+					if (!inside(cycle[t]) || inside(previous)) {
+						continue;
+					}
+					int last = t;
+					while (inside(cycle[(last + 1) % 4])) {
+						last = (last + 1) % 4;
+					}
+					next[edgeBetween(previous, cycle[t])] = edgeBetween(cycle[last], cycle[(last + 1) % 4]);
+				}
+			}
+		}
+
+		CubeCase &cubeCase = cases[index];
+		bool used[12] = {};
+		for (int start = 0; start < 12; ++start) {
+			if (next[start] < 0 || used[start]) {
+				continue;
+			}
+			int loop[12];
+			int length = 0;
+			for (int edge = start; !used[edge]; edge = next[edge]) {
+				used[edge] = true;
+				loop[length++] = edge;
+			}
+			int fan = 0;
+			for (int candidate = 0; candidate < length; ++candidate) {
+				bool clean = true;
+				for (int k = 2; k + 1 < length; ++k) {
+					clean = clean && !(edgeFaces(loop[candidate]) & edgeFaces(loop[(candidate + k) % length]));
+				}
+				if (clean) {
+					fan = candidate;
+					break;
+				}
+			}
+			for (int k = 1; k + 1 < length; ++k) {
+				int8_t *triangle = cubeCase.edges + 3 * cubeCase.triangleCount++;
+				triangle[0] = static_cast<int8_t>(loop[fan]);
+				triangle[1] = static_cast<int8_t>(loop[(fan + k) % length]);
+				triangle[2] = static_cast<int8_t>(loop[(fan + k + 1) % length]);
+			}
+		}
+	}
+	return cases;
+}
+
+const std::array<CubeCase, 256> &cubeCases() {
+	static const std::array<CubeCase, 256> cases = buildCubeCases();
+	return cases;
+}
+
+//Squared distance from a point to an axis aligned box
+float boxDistance2(float x, float y, float z, const float *low, const float *high) {
+	float dx = std::max({low[0] - x, 0.0f, x - high[0]});
+	float dy = std::max({low[1] - y, 0.0f, y - high[1]});
+	float dz = std::max({low[2] - z, 0.0f, z - high[2]});
+	return dx * dx + dy * dy + dz * dz;
+}
+
+}
+
+struct MolecularSurface::Block {
+	//Per local vertex
+	std::vector<float> positions;
+	std::vector<uint64_t> edges;
+	std::vector<uint32_t> ownedRanks; //Rank in ownedEdges, NOT_OWNED for edges of the next blocks
+
+	std::vector<uint32_t> triangles; //Local vertex indices
+	std::vector<uint64_t> ownedEdges; //Sorted edges starting at a sample of this block
+	bool buried = false; //Every sample deep inside an atom, whatever the probe
+
+	//Stitching state
+	uint32_t firstVertex = 0;
+	uint32_t extraCount = 0;
+	std::vector<uint32_t> remoteBlocks;
+	std::vector<uint32_t> remoteRanks;
+};
+
+MolecularSurface::MolecularSurface(Type type, float probeRadius, float spacing) :
+	type(type), probeRadius(probeRadius), spacing(spacing) {}
+
+MolecularSurface::~MolecularSurface() = default;
+
+void MolecularSurface::setType(Type type) {
+	if (type != this->type) {
+		this->type = type;
+		parametersChanged = true;
+	}
+}
+
+void MolecularSurface::setProbeRadius(float probeRadius) {
+	if (probeRadius != this->probeRadius) {
+		this->probeRadius = probeRadius;
+		parametersChanged = true;
+	}
+}
+
+void MolecularSurface::setSpacing(float spacing) {
+	if (spacing != this->spacing) {
+		this->spacing = spacing;
+		clear();
+	}
+}
+
+void MolecularSurface::clear() {
+	blocks.clear();
+	dirty.clear();
+	spheres.clear();
+	blocksX = blocksY = blocksZ = 0;
+	vertices.clear();
+	indices.clear();
+	parametersChanged = true;
+}
+
+template <class Function>
+void MolecularSurface::forEachBlockNear(float x, float y, float z, float reach, Function fn) const {
+	float blockLength = BLOCK_SIZE * spacing;
+	int low[3], high[3];
+	float center[3] = {x - originX, y - originY, z - originZ};
+	int counts[3] = {blocksX, blocksY, blocksZ};
+	for (int axis = 0; axis < 3; ++axis) {
+		//Blocks share their boundary samples, a point on a boundary belongs to both
+		low[axis] = std::max(static_cast<int>(std::floor((center[axis] - reach) / blockLength - 1e-3f)), 0);
+		high[axis] = std::min(static_cast<int>(std::floor((center[axis] + reach) / blockLength)), counts[axis] - 1);
+	}
+	for (int k = low[2]; k <= high[2]; ++k) {
+		for (int j = low[1]; j <= high[1]; ++j) {
+			for (int i = low[0]; i <= high[0]; ++i) {
+				fn(blockIndex(i, j, k));
+			}
+		}
+	}
+}
+
+bool MolecularSurface::fitsGrid(const std::vector<Sphere> &current) const {
+	float blockLength = BLOCK_SIZE * spacing;
+	float clampDistance = 2.0f * spacing;
+	for (const Sphere &sphere : current) {
+		if (!sphere.selected) {
+			continue;
+		}
+		float reach = sphere.radius + probeRadius + clampDistance + spacing;
+		if (sphere.x - reach < originX || sphere.x + reach > originX + blocksX * blockLength ||
+			sphere.y - reach < originY || sphere.y + reach > originY + blocksY * blockLength ||
+			sphere.z - reach < originZ || sphere.z + reach > originZ + blocksZ * blockLength) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void MolecularSurface::resizeGrid(const AtomTable &atoms) {
+	blocks.clear();
+	blocksX = blocksY = blocksZ = 0;
+	if (atoms.empty()) {
+		dirty.clear();
+		return;
+	}
+
+	float low[3] = {atoms.x[0], atoms.y[0], atoms.z[0]};
+	float high[3] = {atoms.x[0], atoms.y[0], atoms.z[0]};
+	for (size_t i = 1; i < atoms.size(); ++i) {
+		float point[3] = {atoms.x[i], atoms.y[i], atoms.z[i]};
+		for (int axis = 0; axis < 3; ++axis) {
+			low[axis] = std::min(low[axis], point[axis]);
+			high[axis] = std::max(high[axis], point[axis]);
+		}
+	}
+	float maxRadius = 0.0f;
+	for (const Sphere &sphere : spheres) {
+		maxRadius = std::max(maxRadius, sphere.radius);
+	}
+
+	float margin = maxRadius + probeRadius + 3.0f * spacing + GRID_SLACK;
+	float blockLength = BLOCK_SIZE * spacing;
+	int counts[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		counts[axis] = static_cast<int>(std::ceil((high[axis] - low[axis] + 2.0f * margin) / blockLength));
+	}
+	originX = low[0] - margin;
+	originY = low[1] - margin;
+	originZ = low[2] - margin;
+	blocksX = counts[0];
+	blocksY = counts[1];
+	blocksZ = counts[2];
+	blocks.resize(static_cast<size_t>(blocksX) * blocksY * blocksZ);
+	dirty.assign(blocks.size(), 0);
+}
+
+void MolecularSurface::update(const AtomTable &atoms, const std::vector<bool> *selection) {
+	size_t count = atoms.size();
+	std::vector<float> elementRadii(atoms.elements.size());
+	for (size_t id = 0; id < elementRadii.size(); ++id) {
+		elementRadii[id] = vanDerWaalsRadius(elementFromSymbol(atoms.elements[static_cast<uint16_t>(id)]));
+	}
+	std::vector<Sphere> current(count);
+	for (size_t i = 0; i < count; ++i) {
+		bool selected = !selection || (i < selection->size() && (*selection)[i]);
+		current[i] = Sphere{atoms.x[i], atoms.y[i], atoms.z[i], elementRadii[atoms.elementIds[i]], selected};
+	}
+
+	float clampDistance = 2.0f * spacing;
+	//Field values of samples further than this from a sphere's surface don't depend on the sphere
+	float accessibleReach = probeRadius + clampDistance + spacing;
+	float changeReach = (type == SES ? 2.0f * probeRadius : probeRadius) + clampDistance + spacing;
+
+	bool rebuild = blocks.empty() || current.size() != spheres.size() || !fitsGrid(current);
+	if (rebuild) {
+		spheres = current;
+		resizeGrid(atoms);
+	}
+
+	std::vector<uint8_t> candidate(blocks.size(), 0);
+	for (const Sphere &sphere : current) {
+		if (sphere.selected) {
+			forEachBlockNear(sphere.x, sphere.y, sphere.z, sphere.radius + accessibleReach, [&](size_t block) {
+				candidate[block] = 1;
+			});
+		}
+	}
+
+	std::fill(dirty.begin(), dirty.end(), 0);
+	if (rebuild) {
+		dirty = candidate;
+	}
+	else {
+		if (parametersChanged) {
+			//Buried blocks are inside any surface, their field doesn't depend on the probe
+			for (size_t block = 0; block < blocks.size(); ++block) {
+				dirty[block] = candidate[block] && !(blocks[block] && blocks[block]->buried);
+			}
+		}
+		//Also with new parameters: buried blocks near moved atoms may not be buried anymore
+		for (size_t i = 0; i < count; ++i) {
+			const Sphere &before = spheres[i];
+			const Sphere &after = current[i];
+			if (before.selected == after.selected && before.x == after.x && before.y == after.y &&
+				before.z == after.z && before.radius == after.radius) {
+				continue;
+			}
+			for (const Sphere *sphere : {&before, &after}) {
+				if (sphere->selected) {
+					forEachBlockNear(sphere->x, sphere->y, sphere->z, sphere->radius + changeReach, [&](size_t block) {
+						dirty[block] = 1;
+					});
+				}
+			}
+		}
+	}
+
+	std::vector<size_t> dirtyBlocks;
+	for (size_t block = 0; block < blocks.size(); ++block) {
+		if (!candidate[block]) {
+			blocks[block].reset();
+			dirty[block] = 0;
+			continue;
+		}
+		if (!blocks[block]) {
+			dirty[block] = 1;
+		}
+		if (dirty[block]) {
+			dirtyBlocks.push_back(block);
+		}
+	}
+
+	spheres.swap(current);
+	parametersChanged = false;
+	lastRecomputed = dirtyBlocks.size();
+	if (!dirtyBlocks.empty()) {
+		computeBlocks(dirtyBlocks, spheres);
+	}
+	stitch();
+}
+
+void MolecularSurface::computeBlocks(const std::vector<size_t> &dirtyBlocks, const std::vector<Sphere> &current) {
+	float clampDistance = 2.0f * spacing;
+	float blockLength = BLOCK_SIZE * spacing;
+	float halfDiagonal = 0.5f * std::sqrt(3.0f) * blockLength;
+	//Without a probe the excluded surface is the van der Waals surface, which the accessible field gives directly
+	bool excluded = type == SES && probeRadius > 0.0f;
+	float seedReach = probeRadius + clampDistance;
+
+	std::vector<uint32_t> selected;
+	float maxRadius = 0.0f;
+	for (size_t i = 0; i < current.size(); ++i) {
+		if (current[i].selected) {
+			selected.push_back(static_cast<uint32_t>(i));
+			maxRadius = std::max(maxRadius, current[i].radius);
+		}
+	}
+	float maxAccessible = maxRadius + probeRadius;
+	std::vector<float> atomX(selected.size()), atomY(selected.size()), atomZ(selected.size());
+	for (size_t i = 0; i < selected.size(); ++i) {
+		atomX[i] = current[selected[i]].x;
+		atomY[i] = current[selected[i]].y;
+		atomZ[i] = current[selected[i]].z;
+	}
+	SpatialGrid atomGrid;
+	atomGrid.build(atomX.data(), atomY.data(), atomZ.data(), selected.size(),
+		std::max(halfDiagonal + maxAccessible + clampDistance, 2.0f * maxAccessible));
+
+	//Points on the exposed part of the accessible spheres whose samples can reach a dirty block
+	std::vector<float> seedX, seedY, seedZ;
+	SpatialGrid seedGrid;
+	if (excluded) {
+		float seedSpacing = 2.0f * spacing;
+		std::vector<std::vector<float>> chunkSeeds(workerCount());
+		size_t chunkSize = (selected.size() + chunkSeeds.size() - 1) / chunkSeeds.size();
+		parallelFor(chunkSeeds.size(), [&](size_t firstChunk, size_t lastChunk) {
+			std::vector<uint32_t> neighbors;
+			for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+				std::vector<float> &seeds = chunkSeeds[chunk];
+				size_t end = std::min(selected.size(), (chunk + 1) * chunkSize);
+				for (size_t a = chunk * chunkSize; a < end; ++a) {
+					float radius = current[selected[a]].radius + probeRadius;
+					bool needed = false;
+					forEachBlockNear(atomX[a], atomY[a], atomZ[a], radius + seedReach + spacing, [&](size_t block) {
+						needed = needed || dirty[block];
+					});
+					if (!needed) {
+						continue;
+					}
+
+					neighbors.clear();
+					atomGrid.forEachNear(atomX[a], atomY[a], atomZ[a], [&](uint32_t b) {
+						float dx = atomX[b] - atomX[a], dy = atomY[b] - atomY[a], dz = atomZ[b] - atomZ[a];
+						float reach = radius + current[selected[b]].radius + probeRadius;
+						if (b != a && dx * dx + dy * dy + dz * dz < reach * reach) {
+							neighbors.push_back(b);
+						}
+					});
+
+					int seedCount = std::max(8, static_cast<int>(4.0f * PI * radius * radius / (seedSpacing * seedSpacing)));
+					for (int k = 0; k < seedCount; ++k) {
+						float z = 1.0f - (2.0f * k + 1.0f) / seedCount;
+						float ring = std::sqrt(1.0f - z * z);
+						float sx = atomX[a] + radius * ring * std::cos(GOLDEN_ANGLE * k);
+						float sy = atomY[a] + radius * ring * std::sin(GOLDEN_ANGLE * k);
+						float sz = atomZ[a] + radius * z;
+						bool exposed = true;
+						for (uint32_t b : neighbors) {
+							float dx = atomX[b] - sx, dy = atomY[b] - sy, dz = atomZ[b] - sz;
+							float reach = current[selected[b]].radius + probeRadius;
+							if (dx * dx + dy * dy + dz * dz < reach * reach) {
+								exposed = false;
+								break;
+							}
+						}
+						if (exposed) {
+							seeds.insert(seeds.end(), {sx, sy, sz});
+						}
+					}
+				}
+			}
+		});
+		for (const auto &seeds : chunkSeeds) {
+			for (size_t s = 0; s < seeds.size(); s += 3) {
+				seedX.push_back(seeds[s]);
+				seedY.push_back(seeds[s + 1]);
+				seedZ.push_back(seeds[s + 2]);
+			}
+		}
+		seedGrid.build(seedX.data(), seedY.data(), seedZ.data(), seedX.size(), halfDiagonal + seedReach);
+	}
+
+	size_t samplesX = static_cast<size_t>(blocksX) * BLOCK_SIZE + 1;
+	size_t samplesY = static_cast<size_t>(blocksY) * BLOCK_SIZE + 1;
+	const auto &cases = cubeCases();
+
+	for (size_t block : dirtyBlocks) {
+		if (!blocks[block]) {
+			blocks[block].reset(new Block());
+		}
+	}
+
+	parallelFor(dirtyBlocks.size(), [&](size_t first, size_t last) {
+		std::vector<uint32_t> nearAtoms, nearSeeds;
+		std::vector<float> field(BLOCK_SAMPLES * BLOCK_SAMPLES * BLOCK_SAMPLES);
+		std::vector<int32_t> localVertices(field.size() * 3);
+		for (size_t d = first; d < last; ++d) {
+			size_t index = dirtyBlocks[d];
+			Block &block = *blocks[index];
+			int bx = static_cast<int>(index % blocksX);
+			int by = static_cast<int>(index / blocksX % blocksY);
+			int bz = static_cast<int>(index / blocksX / blocksY);
+			float low[3] = {originX + bx * blockLength, originY + by * blockLength, originZ + bz * blockLength};
+			float high[3] = {low[0] + blockLength, low[1] + blockLength, low[2] + blockLength};
+			float center[3] = {low[0] + 0.5f * blockLength, low[1] + 0.5f * blockLength, low[2] + 0.5f * blockLength};
+
+			nearAtoms.clear();
+			atomGrid.forEachNear(center[0], center[1], center[2], [&](uint32_t a) {
+				float reach = current[selected[a]].radius + probeRadius + clampDistance;
+				if (boxDistance2(atomX[a], atomY[a], atomZ[a], low, high) < reach * reach) {
+					nearAtoms.push_back(a);
+				}
+			});
+			nearSeeds.clear();
+			if (excluded) {
+				seedGrid.forEachNear(center[0], center[1], center[2], [&](uint32_t s) {
+					if (boxDistance2(seedX[s], seedY[s], seedZ[s], low, high) < seedReach * seedReach) {
+						nearSeeds.push_back(s);
+					}
+				});
+			}
+
+			//Sample the field, negative inside, clamped to +-clampDistance
+			bool buried = true;
+			bool anyInside = false, anyOutside = false;
+			for (int k = 0; k < BLOCK_SAMPLES; ++k) {
+				for (int j = 0; j < BLOCK_SAMPLES; ++j) {
+					for (int i = 0; i < BLOCK_SAMPLES; ++i) {
+						float px = low[0] + i * spacing, py = low[1] + j * spacing, pz = low[2] + k * spacing;
+						float accessible = clampDistance;
+						float vanDerWaals = clampDistance;
+						for (uint32_t a : nearAtoms) {
+							float dx = atomX[a] - px, dy = atomY[a] - py, dz = atomZ[a] - pz;
+							float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+							float radius = current[selected[a]].radius;
+							vanDerWaals = std::min(vanDerWaals, distance - radius);
+							accessible = std::min(accessible, distance - radius - probeRadius);
+						}
+						buried = buried && vanDerWaals <= -clampDistance;
+
+						float value;
+						if (!excluded) {
+							value = accessible;
+						}
+						else if (accessible >= 0.0f) {
+							value = probeRadius;
+						}
+						else if (-accessible >= seedReach) {
+							//Deeper than the probe inside the accessible surface
+							value = -clampDistance;
+						}
+						else {
+							float nearest2 = seedReach * seedReach;
+							for (uint32_t s : nearSeeds) {
+								float dx = seedX[s] - px, dy = seedY[s] - py, dz = seedZ[s] - pz;
+								nearest2 = std::min(nearest2, dx * dx + dy * dy + dz * dz);
+							}
+							value = probeRadius - std::sqrt(nearest2);
+						}
+						value = std::min(std::max(value, -clampDistance), clampDistance);
+						field[(k * BLOCK_SAMPLES + j) * BLOCK_SAMPLES + i] = value;
+						anyInside = anyInside || value < 0.0f;
+						anyOutside = anyOutside || value >= 0.0f;
+					}
+				}
+			}
+
+			block.buried = buried;
+			block.positions.clear();
+			block.edges.clear();
+			block.ownedRanks.clear();
+			block.triangles.clear();
+			block.ownedEdges.clear();
+			if (!anyInside || !anyOutside) {
+				continue;
+			}
+
+			std::fill(localVertices.begin(), localVertices.end(), -1);
+			for (int k = 0; k < BLOCK_SIZE; ++k) {
+				for (int j = 0; j < BLOCK_SIZE; ++j) {
+					for (int i = 0; i < BLOCK_SIZE; ++i) {
+						int caseIndex = 0;
+						for (int corner = 0; corner < 8; ++corner) {
+							int sample = ((k + (corner >> 2 & 1)) * BLOCK_SAMPLES + j + (corner >> 1 & 1)) * BLOCK_SAMPLES + i + (corner & 1);
+							caseIndex |= (field[sample] < 0.0f) << corner;
+						}
+						const CubeCase &cubeCase = cases[caseIndex];
+						for (int t = 0; t < 3 * cubeCase.triangleCount; ++t) {
+							int edge = cubeCase.edges[t];
+							int corner = EDGE_CORNERS[edge];
+							int axis = edge / 4;
+							int local[3] = {i + (corner & 1), j + (corner >> 1 & 1), k + (corner >> 2 & 1)};
+							int sample = (local[2] * BLOCK_SAMPLES + local[1]) * BLOCK_SAMPLES + local[0];
+							int32_t &vertex = localVertices[sample * 3 + axis];
+							if (vertex < 0) {
+								vertex = static_cast<int32_t>(block.edges.size());
+								int step = axis == 0 ? 1 : axis == 1 ? BLOCK_SAMPLES : BLOCK_SAMPLES * BLOCK_SAMPLES;
+								float from = field[sample], to = field[sample + step];
+								float position[3] = {
+									low[0] + local[0] * spacing, low[1] + local[1] * spacing, low[2] + local[2] * spacing
+								};
+								position[axis] += spacing * from / (from - to);
+								block.positions.insert(block.positions.end(), position, position + 3);
+
+								size_t globalSample = ((static_cast<size_t>(bz) * BLOCK_SIZE + local[2]) * samplesY +
+									static_cast<size_t>(by) * BLOCK_SIZE + local[1]) * samplesX + static_cast<size_t>(bx) * BLOCK_SIZE + local[0];
+								block.edges.push_back(globalSample * 3 + axis);
+								bool owned = local[0] < BLOCK_SIZE && local[1] < BLOCK_SIZE && local[2] < BLOCK_SIZE;
+								block.ownedRanks.push_back(owned ? 0 : NOT_OWNED);
+								if (owned) {
+									block.ownedEdges.push_back(block.edges.back());
+								}
+							}
+							block.triangles.push_back(static_cast<uint32_t>(vertex));
+						}
+					}
+				}
+			}
+
+			std::sort(block.ownedEdges.begin(), block.ownedEdges.end());
+			for (size_t v = 0; v < block.edges.size(); ++v) {
+				if (block.ownedRanks[v] != NOT_OWNED) {
+					block.ownedRanks[v] = static_cast<uint32_t>(
+						std::lower_bound(block.ownedEdges.begin(), block.ownedEdges.end(), block.edges[v]) - block.ownedEdges.begin());
+				}
+			}
+		}
+	}, 4);
+}
+
+void MolecularSurface::stitch() {
+	vertices.clear();
+	indices.clear();
+
+	std::vector<size_t> active;
+	for (size_t block = 0; block < blocks.size(); ++block) {
+		if (blocks[block] && !blocks[block]->triangles.empty()) {
+			active.push_back(block);
+		}
+	}
+	if (active.empty()) {
+		return;
+	}
+
+	size_t samplesX = static_cast<size_t>(blocksX) * BLOCK_SIZE + 1;
+	size_t samplesY = static_cast<size_t>(blocksY) * BLOCK_SIZE + 1;
+
+	//Vertices on the far faces of a block belong to the next block, find them there
+	parallelFor(active.size(), [&](size_t first, size_t last) {
+		for (size_t a = first; a < last; ++a) {
+			Block &block = *blocks[active[a]];
+			size_t vertexCount = block.edges.size();
+			block.remoteBlocks.assign(vertexCount, NO_BLOCK);
+			block.remoteRanks.assign(vertexCount, 0);
+			block.extraCount = 0;
+			for (size_t v = 0; v < vertexCount; ++v) {
+				if (block.ownedRanks[v] != NOT_OWNED) {
+					continue;
+				}
+				size_t sample = block.edges[v] / 3;
+				int owner[3] = {
+					static_cast<int>(sample % samplesX / BLOCK_SIZE),
+					static_cast<int>(sample / samplesX % samplesY / BLOCK_SIZE),
+					static_cast<int>(sample / samplesX / samplesY / BLOCK_SIZE)
+				};
+				bool found = false;
+				if (owner[0] < blocksX && owner[1] < blocksY && owner[2] < blocksZ) {
+					size_t ownerIndex = blockIndex(owner[0], owner[1], owner[2]);
+					const Block *ownerBlock = blocks[ownerIndex].get();
+					if (ownerBlock) {
+						auto match = std::lower_bound(ownerBlock->ownedEdges.begin(), ownerBlock->ownedEdges.end(), block.edges[v]);
+						if (match != ownerBlock->ownedEdges.end() && *match == block.edges[v]) {
+							block.remoteBlocks[v] = static_cast<uint32_t>(ownerIndex);
+							block.remoteRanks[v] = static_cast<uint32_t>(match - ownerBlock->ownedEdges.begin());
+							found = true;
+						}
+					}
+				}
+				//Only at the grid border or after a failed update, keep the vertex unshared
+				if (!found) {
+					block.remoteRanks[v] = block.extraCount++;
+				}
+			}
+		}
+	}, 16);
+
+	std::vector<size_t> firstIndices(active.size() + 1, 0);
+	uint32_t vertexCount = 0;
+	for (size_t a = 0; a < active.size(); ++a) {
+		Block &block = *blocks[active[a]];
+		block.firstVertex = vertexCount;
+		vertexCount += static_cast<uint32_t>(block.ownedEdges.size()) + block.extraCount;
+		firstIndices[a + 1] = firstIndices[a] + block.triangles.size();
+	}
+	vertices.assign(static_cast<size_t>(vertexCount) * 6, 0.0f);
+	indices.resize(firstIndices.back());
+
+	parallelFor(active.size(), [&](size_t first, size_t last) {
+		std::vector<uint32_t> globalVertices;
+		for (size_t a = first; a < last; ++a) {
+			const Block &block = *blocks[active[a]];
+			globalVertices.resize(block.edges.size());
+			for (size_t v = 0; v < block.edges.size(); ++v) {
+				uint32_t global;
+				bool writes = true;
+				if (block.ownedRanks[v] != NOT_OWNED) {
+					global = block.firstVertex + block.ownedRanks[v];
+				}
+				else if (block.remoteBlocks[v] == NO_BLOCK) {
+					global = block.firstVertex + static_cast<uint32_t>(block.ownedEdges.size()) + block.remoteRanks[v];
+				}
+				else {
+					global = blocks[block.remoteBlocks[v]]->firstVertex + block.remoteRanks[v];
+					writes = false;
+				}
+				globalVertices[v] = global;
+				if (writes) {
+					std::copy(block.positions.begin() + 3 * v, block.positions.begin() + 3 * v + 3, vertices.begin() + 6 * static_cast<size_t>(global));
+				}
+			}
+			uint32_t *out = indices.data() + firstIndices[a];
+			for (uint32_t local : block.triangles) {
+				*out++ = globalVertices[local];
+			}
+		}
+	}, 16);
+
+	//Area weighted normals, summed over the triangles around every vertex
+	for (size_t t = 0; t < indices.size(); t += 3) {
+		const float *p0 = &vertices[6 * static_cast<size_t>(indices[t])];
+		const float *p1 = &vertices[6 * static_cast<size_t>(indices[t + 1])];
+		const float *p2 = &vertices[6 * static_cast<size_t>(indices[t + 2])];
+		float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+		float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+		float normal[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+		for (int corner = 0; corner < 3; ++corner) {
+			float *n = &vertices[6 * static_cast<size_t>(indices[t + corner]) + 3];
+			n[0] += normal[0];
+			n[1] += normal[1];
+			n[2] += normal[2];
+		}
+	}
+	parallelFor(vertexCount, [&](size_t first, size_t last) {
+		for (size_t v = first; v < last; ++v) {
+			float *n = &vertices[6 * v + 3];
+			float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length > 0.0f) {
+				n[0] /= length;
+				n[1] /= length;
+				n[2] /= length;
+			}
+		}
+	}, 1 << 16);
+}
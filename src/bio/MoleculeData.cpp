@@ -60,9 +60,9 @@ void MoleculeData::printAtoms() {
 	}
 	else {
 		for (size_t i = 0; i < atoms.size(); ++i) {
-			std::cout << i + 1 << ") " << atoms[i].name << "\tr=" <<
-				atoms[i].residueNum << " (" << atoms[i].residueName <<
-				")\te=" << atoms[i].element << "\tc=" << atoms[i].chain << "\n";
+			std::cout << i + 1 << ") " << atoms.name(i) << "\tr=" <<
+				atoms.residueNum(i) << " (" << atoms.residueName(i) <<
+				")\te=" << atoms.element(i) << "\tc=" << atoms.chain(i) << "\n";
 		}
 		std::cout << "\n";
 	}
@@ -80,3 +80,54 @@ void MoleculeData::printChains() {
 		std::cout << "\n";
 	}
 }
+
+void MoleculeData::buildSequenceFromAtoms() {
+	//The atom table already groups atoms into residues
+	std::vector<size_t> residueCounts(atoms.chainIds.size(), 0);
+	for (size_t i = 0; i < atoms.residueCount(); ++i) {
+		uint16_t chainIndex = atoms.residueChainIndices[i];
+		sequence.push_back(Residue{atoms.residueNames[atoms.residueNameIds[i]], atoms.residueNums[i], atoms.chainIds[chainIndex]});
+		residueCounts[chainIndex]++;
+	}
+
+	//Chains in order of first appearance
+	for (size_t i = 0; i < atoms.chainIds.size(); ++i) {
+		chains.push_back(Chain{atoms.chainIds[i], residueCounts[i]});
+	}
+}
+
+const SecondaryStructureIndex &MoleculeData::secondaryStructure() const {
+	if (!structureIndexBuilt) {
+		structureIndex.build(helices, sheets, atoms);
+		structureIndexBuilt = true;
+	}
+	return structureIndex;
+}
+
+void MoleculeData::invalidateSecondaryStructure() {
+	structureIndexBuilt = false;
+}
+
+void MoleculeData::assignSecondaryStructure() {
+	structureAssigner.assign(atoms);
+
+	//Swapped in, the const members of Helix and Sheet rule out assigning the vectors
+	std::vector<Helix> assignedHelices;
+	std::vector<Sheet> assignedSheets;
+	structureAssigner.toRanges(atoms, assignedHelices, assignedSheets);
+	helices.swap(assignedHelices);
+	sheets.swap(assignedSheets);
+	invalidateSecondaryStructure();
+}
+
+const BondTable &MoleculeData::bonds() const {
+	if (!bondTableBuilt) {
+		bondTable.perceive(atoms);
+		bondTableBuilt = true;
+	}
+	return bondTable;
+}
+
+void MoleculeData::invalidateBonds() {
+	bondTableBuilt = false;
+}
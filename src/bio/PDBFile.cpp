@@ -0,0 +1,237 @@
+#include "bio/PDBFile.h"
+
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+#include "bio/FieldParsing.h"
+#include "bio/MappedFile.h"
+#include "bio/Parallel.h"
+
+namespace {
+
+struct SeqresRecord {
+	char chain;
+	int residueCount;
+	std::vector<std::string> names;
+};
+
+//Coordinate record, the strings point into the mapped file
+struct AtomRecord {
+	std::string_view name;
+	std::string_view residueName;
+	char chain;
+	int residueNum;
+	glm::vec3 coords;
+	std::string_view element;
+	float bFactor;
+};
+
+//Records of one line-aligned range of the file, in file order
+struct ParsedRange {
+	std::vector<AtomRecord> atoms;
+	std::vector<Helix> helices;
+	std::vector<Sheet> sheets;
+	std::vector<DisulfideBond> disulfideBonds;
+	std::vector<SeqresRecord> seqres;
+};
+
+bool isRecord(std::string_view line, const char *name) {
+	return line.size() >= 6 && std::memcmp(line.data(), name, 6) == 0;
+}
+
+char chainField(std::string_view line, size_t column) {
+	return column <= line.size() ? line[column - 1] : ' ';
+}
+
+//Element from columns 77-78, or guessed from the atom name for files that leave it out
+std::string_view elementOf(std::string_view line, bool hetero) {
+	std::string_view element = trimField(columns(line, 77, 78));
+	if (!element.empty()) {
+		return element;
+	}
+
+	//The letters of the two element columns of the name, e.g. " C", "1H" or "FE"
+	std::string_view name = columns(line, 13, 14);
+	while (!name.empty() && !std::isalpha(static_cast<unsigned char>(name.front()))) {
+		name.remove_prefix(1);
+	}
+	while (!name.empty() && !std::isalpha(static_cast<unsigned char>(name.back()))) {
+		name.remove_suffix(1);
+	}
+	//Standard residues only contain one-letter elements, "CA" there is an alpha carbon
+	if (!hetero && name.size() > 1) {
+		name = name.substr(0, 1);
+	}
+	return name;
+}
+
+void parseAtom(std::string_view line, bool hetero, ParsedRange &out) {
+	out.atoms.push_back(AtomRecord{
+		trimField(columns(line, 13, 16)),
+		trimField(columns(line, 18, 20)),
+		chainField(line, 22),
+		parseIntField(columns(line, 23, 26)),
+		glm::vec3(
+			parseFloatField(columns(line, 31, 38)),
+			parseFloatField(columns(line, 39, 46)),
+			parseFloatField(columns(line, 47, 54))
+		),
+		elementOf(line, hetero),
+		parseFloatField(columns(line, 61, 66))
+	});
+}
+
+void parseHelix(std::string_view line, ParsedRange &out) {
+	int type = parseIntField(columns(line, 39, 40));
+	out.helices.push_back(Helix{
+		(type >= 1 && type <= 10) ? type : 1,
+		chainField(line, 20),
+		parseIntField(columns(line, 22, 25)),
+		parseIntField(columns(line, 34, 37))
+	});
+}
+
+void parseSheet(std::string_view line, ParsedRange &out) {
+	out.sheets.push_back(Sheet{
+		chainField(line, 22),
+		parseIntField(columns(line, 23, 26)),
+		parseIntField(columns(line, 34, 37))
+	});
+}
+
+void parseDisulfideBond(std::string_view line, ParsedRange &out) {
+	out.disulfideBonds.push_back(DisulfideBond{
+		chainField(line, 16),
+		parseIntField(columns(line, 18, 21)),
+		chainField(line, 30),
+		parseIntField(columns(line, 32, 35))
+	});
+}
+
+void parseSeqres(std::string_view line, ParsedRange &out) {
+	SeqresRecord record{chainField(line, 12), parseIntField(columns(line, 14, 17)), {}};
+	//Up to 13 residue names per record, in columns 20-22, 24-26, ...
+	for (size_t column = 20; column <= 68; column += 4) {
+		std::string_view name = trimField(columns(line, column, column + 2));
+		if (!name.empty()) {
+			record.names.emplace_back(name);
+		}
+	}
+	out.seqres.push_back(std::move(record));
+}
+
+void parseRange(const char *begin, const char *end, ParsedRange &out) {
+	//Coordinate records are 81 bytes with the newline, most of a file is made of them
+	out.atoms.reserve((end - begin) / 81 + 1);
+
+	const char *cursor = begin;
+	while (cursor < end) {
+		const char *newline = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+		const char *lineEnd = newline ? newline : end;
+		std::string_view line(cursor, lineEnd - cursor);
+		if (!line.empty() && line.back() == '\r') {
+			line.remove_suffix(1);
+		}
+		cursor = lineEnd + 1;
+
+		if (isRecord(line, "ATOM  ")) {
+			parseAtom(line, false, out);
+		}
+		else if (isRecord(line, "HETATM")) {
+			parseAtom(line, true, out);
+		}
+		else if (isRecord(line, "HELIX ")) {
+			parseHelix(line, out);
+		}
+		else if (isRecord(line, "SHEET ")) {
+			parseSheet(line, out);
+		}
+		else if (isRecord(line, "SSBOND")) {
+			parseDisulfideBond(line, out);
+		}
+		else if (isRecord(line, "SEQRES")) {
+			parseSeqres(line, out);
+		}
+	}
+}
+
+//End of the first model, records of later models belong to the trajectory, not the topology
+size_t firstModelEnd(std::string_view text) {
+	size_t position = text.compare(0, 6, "ENDMDL") == 0 ? 0 : text.find("\nENDMDL");
+	return position == std::string_view::npos ? text.size() : position;
+}
+
+//Advances to the start of the next line
+size_t lineStart(std::string_view text, size_t position) {
+	if (position == 0 || position >= text.size()) {
+		return std::min(position, text.size());
+	}
+	size_t newline = text.find('\n', position - 1);
+	return newline == std::string_view::npos ? text.size() : newline + 1;
+}
+
+}
+
+PDBFile::PDBFile(const std::string &path) {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		return;
+	}
+	std::string_view text(file.data(), file.size());
+	text = text.substr(0, firstModelEnd(text));
+
+	//More ranges than threads so uneven record mixes still balance out
+	size_t rangeCount = std::max<size_t>(1, std::min<size_t>(workerCount() * 4, text.size() / (1 << 16)));
+	std::vector<size_t> boundaries(rangeCount + 1);
+	for (size_t i = 0; i <= rangeCount; ++i) {
+		boundaries[i] = lineStart(text, text.size() * i / rangeCount);
+	}
+
+	std::vector<ParsedRange> ranges(rangeCount);
+	parallelFor(rangeCount, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			parseRange(text.data() + boundaries[i], text.data() + boundaries[i + 1], ranges[i]);
+		}
+	});
+
+	//Merge in file order
+	size_t atomCount = 0;
+	for (const auto &range : ranges) {
+		atomCount += range.atoms.size();
+	}
+	atoms.reserve(atomCount);
+
+	std::unordered_map<char, int> seqresPositions;
+	for (const auto &range : ranges) {
+		for (const auto &atom : range.atoms) {
+			atoms.append(atom.name, atom.residueName, atom.chain, atom.residueNum, atom.coords, atom.element, atom.bFactor);
+		}
+		for (const auto &helix : range.helices) {
+			helices.push_back(helix);
+		}
+		for (const auto &sheet : range.sheets) {
+			sheets.push_back(sheet);
+		}
+		for (const auto &bond : range.disulfideBonds) {
+			disulfideBonds.push_back(bond);
+		}
+		for (const auto &record : range.seqres) {
+			auto position = seqresPositions.find(record.chain);
+			if (position == seqresPositions.end()) {
+				position = seqresPositions.emplace(record.chain, 0).first;
+				chains.push_back(Chain{record.chain, static_cast<size_t>(record.residueCount)});
+			}
+			for (const auto &name : record.names) {
+				sequence.push_back(Residue{name, ++position->second, record.chain});
+			}
+		}
+	}
+
+	//Files without SEQRES: take the sequence and chains from the residues that have coordinates
+	if (sequence.empty()) {
+		buildSequenceFromAtoms();
+	}
+}
@@ -0,0 +1,114 @@
+#include "bio/PDBModelSource.h"
+
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+#include "bio/FieldParsing.h"
+#include "bio/Parallel.h"
+
+namespace {
+
+bool isCoordinateRecord(const char *line, size_t length) {
+	return length >= 6 && (std::memcmp(line, "ATOM  ", 6) == 0 || std::memcmp(line, "HETATM", 6) == 0);
+}
+
+//Calls fn(line) for every coordinate record in [begin, end), which must start at a line start
+template <class Function>
+void forEachCoordinateRecord(const char *begin, const char *end, Function fn) {
+	const char *cursor = begin;
+	while (cursor < end) {
+		const char *newline = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+		const char *lineEnd = newline ? newline : end;
+		if (isCoordinateRecord(cursor, lineEnd - cursor)) {
+			fn(std::string_view(cursor, lineEnd - cursor));
+		}
+		cursor = lineEnd + 1;
+	}
+}
+
+//Advances to the start of the next line
+size_t lineStart(std::string_view text, size_t position) {
+	if (position == 0 || position >= text.size()) {
+		return std::min(position, text.size());
+	}
+	size_t newline = text.find('\n', position - 1);
+	return newline == std::string_view::npos ? text.size() : newline + 1;
+}
+
+}
+
+PDBModelSource::PDBModelSource(const std::string &path) :
+	file(path) {
+	if (!file.isOpen()) {
+		return;
+	}
+	std::string_view text(file.data(), file.size());
+
+	size_t position = text.compare(0, 6, "MODEL ") == 0 ? 0 : text.find("\nMODEL ");
+	while (position != std::string_view::npos) {
+		if (text[position] == '\n') {
+			++position;
+		}
+		modelStarts.push_back(position);
+		position = text.find("\nMODEL ", position);
+	}
+	if (modelStarts.empty()) {
+		modelStarts.push_back(0);
+	}
+	modelStarts.push_back(text.size());
+
+	//The first model defines the atoms, as in PDBFile
+	forEachCoordinateRecord(text.data() + modelStarts[0], text.data() + modelStarts[1], [&](std::string_view) {
+		++atoms;
+	});
+}
+
+size_t PDBModelSource::frameCount() const {
+	return modelStarts.empty() ? 0 : modelStarts.size() - 1;
+}
+
+size_t PDBModelSource::atomCount() const {
+	return atoms;
+}
+
+bool PDBModelSource::readFrame(size_t index, float *xyz) {
+	if (index >= frameCount()) {
+		return false;
+	}
+	std::string_view text(file.data() + modelStarts[index], modelStarts[index + 1] - modelStarts[index]);
+
+	//Count the records of every range first, so each range knows where its atoms go
+	size_t rangeCount = std::max<size_t>(1, std::min<size_t>(workerCount() * 4, text.size() / (1 << 16)));
+	std::vector<size_t> boundaries(rangeCount + 1);
+	for (size_t i = 0; i <= rangeCount; ++i) {
+		boundaries[i] = lineStart(text, text.size() * i / rangeCount);
+	}
+	std::vector<size_t> firstAtoms(rangeCount + 1, 0);
+	parallelFor(rangeCount, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			forEachCoordinateRecord(text.data() + boundaries[i], text.data() + boundaries[i + 1], [&](std::string_view) {
+				++firstAtoms[i + 1];
+			});
+		}
+	});
+	for (size_t i = 0; i < rangeCount; ++i) {
+		firstAtoms[i + 1] += firstAtoms[i];
+	}
+	if (firstAtoms[rangeCount] != atoms) {
+		std::cerr << "ERROR > Model " << index + 1 << " has " << firstAtoms[rangeCount] << " atoms, expected " << atoms << "\n\n";
+		return false;
+	}
+
+	parallelFor(rangeCount, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			float *out = xyz + 3 * firstAtoms[i];
+			forEachCoordinateRecord(text.data() + boundaries[i], text.data() + boundaries[i + 1], [&](std::string_view line) {
+				*out++ = parseFloatField(columns(line, 31, 38));
+				*out++ = parseFloatField(columns(line, 39, 46));
+				*out++ = parseFloatField(columns(line, 47, 54));
+			});
+		}
+	});
+	return true;
+}
@@ -6,17 +6,14 @@ Protein::Protein(std::string sequence) {
 	std::stringstream sequenceStream(sequence);
 	std::string abbr;
 	while (sequenceStream >> abbr) {
-		const AminoAcid *aminoAcid = AminoAcid::get(abbr);
-		if (aminoAcid) {
-			this->sequence.push_back(aminoAcid);
-		}
-		else {
+		bool added;
+		const AminoAcid *aminoAcid = AminoAcid::getOrAdd(abbr, added);
+		if (added) {
 			std::cout << "INFO > Adding amino acid \"" << abbr << "\" to dictionary. " <<
 				"Consider creating a dictionary entry yourself.\n\n";
-			const AminoAcid *newAminoAcid = AminoAcid::set(abbr, "", "", "", "");
-			if (newAminoAcid) {
-				this->sequence.push_back(newAminoAcid);
-			}
+		}
+		if (aminoAcid) {
+			this->sequence.push_back(aminoAcid);
 		}
 	}
 }
@@ -29,18 +26,15 @@ Protein::Protein(const std::vector<const AminoAcid*> &sequence) {
 
 Protein::Protein(const MoleculeData *moleculeData) {
 	for (size_t i = 0; i < moleculeData->sequence.size(); ++i) {
-		std::string name = moleculeData->sequence[i].name;
-		const AminoAcid *aminoAcid = AminoAcid::get(name);
-		if (aminoAcid) {
-			sequence.push_back(aminoAcid);
-		}
-		else {
+		const std::string &name = moleculeData->sequence[i].name;
+		bool added;
+		const AminoAcid *aminoAcid = AminoAcid::getOrAdd(name, added);
+		if (added) {
 			std::cout << "INFO > Adding amino acid \"" << name << "\" to dictionary. " <<
 				"Consider creating a dictionary entry yourself.\n\n";
-			const AminoAcid *newAminoAcid = AminoAcid::set(name, "", "", "", "");
-			if (newAminoAcid) {
-				this->sequence.push_back(newAminoAcid);
-			}
+		}
+		if (aminoAcid) {
+			sequence.push_back(aminoAcid);
 		}
 	}
 }
@@ -0,0 +1,311 @@
+#include "bio/SecondaryStructureAssigner.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "bio/Parallel.h"
+
+namespace {
+
+enum BackboneAtom : uint8_t {
+	OTHER, N, CA, C, O
+};
+
+//Kabsch & Sander electrostatic model, kcal/mol
+constexpr float COUPLING_CONSTANT = 27.888f;
+constexpr float MIN_HBOND_ENERGY = -9.9f;
+constexpr float MAX_HBOND_ENERGY = -0.5f;
+constexpr float MIN_DISTANCE = 0.5f;
+
+//Residues with CA atoms further apart can't be hydrogen bonded
+constexpr float MAX_CA_DISTANCE = 9.0f;
+constexpr float MAX_PEPTIDE_BOND = 2.5f;
+
+//Residues per slice of the parallel loops
+constexpr size_t MIN_RESIDUES_PER_THREAD = 256;
+
+float hbondEnergy(const glm::vec3 &n, const glm::vec3 &h, const glm::vec3 &c, const glm::vec3 &o) {
+	float distanceON = glm::distance(o, n);
+	float distanceCH = glm::distance(c, h);
+	float distanceOH = glm::distance(o, h);
+	float distanceCN = glm::distance(c, n);
+	if (std::min({distanceON, distanceCH, distanceOH, distanceCN}) < MIN_DISTANCE) {
+		return MIN_HBOND_ENERGY;
+	}
+	float energy = COUPLING_CONSTANT * (1.0f / distanceON + 1.0f / distanceCH - 1.0f / distanceOH - 1.0f / distanceCN);
+	return std::max(energy, MIN_HBOND_ENERGY);
+}
+
+int helixType(SecondaryStructureIndex::Structure structure) {
+	switch (structure) {
+	case SecondaryStructureIndex::HELIX_3_10:
+		return 5;
+	case SecondaryStructureIndex::HELIX_PI:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
+}
+
+void SecondaryStructureAssigner::assign(const AtomTable &atoms) {
+	size_t residueCount = atoms.residueCount();
+	residueStructures.assign(residueCount, SecondaryStructureIndex::NONE);
+	if (residueCount == 0) {
+		return;
+	}
+
+	readBackbones(atoms);
+	computeHBonds(atoms);
+	findBridges();
+
+	//DSSP priority: alpha helices, then strands, then 3/10 and pi helices where nothing else is
+	assignHelices(4, SecondaryStructureIndex::HELIX_ALPHA, false);
+	parallelFor(residueCount, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			if (residueStructures[i] != SecondaryStructureIndex::NONE) {
+				continue;
+			}
+			//A bridge is part of a ladder if a neighbor bridges to the matching neighbor of the partner
+			for (size_t slot = 2 * i; slot < 2 * i + 2; ++slot) {
+				const Bridge &bridge = bridges[slot];
+				if (bridge.type == NO_BRIDGE) {
+					continue;
+				}
+				long step = bridge.type == PARALLEL ? 1 : -1;
+				bool ladder = false;
+				for (long direction = -1; direction <= 1; direction += 2) {
+					long neighbor = static_cast<long>(i) + direction;
+					if (neighbor < 0 || neighbor >= static_cast<long>(residueCount) || !linked(i, neighbor)) {
+						continue;
+					}
+					long partner = static_cast<long>(bridge.partner) + direction * step;
+					for (size_t other = 2 * static_cast<size_t>(neighbor); other < 2 * static_cast<size_t>(neighbor) + 2; ++other) {
+						ladder = ladder || (bridges[other].type == bridge.type && static_cast<long>(bridges[other].partner) == partner);
+					}
+				}
+				if (ladder) {
+					residueStructures[i] = SecondaryStructureIndex::SHEET;
+				}
+			}
+		}
+	}, MIN_RESIDUES_PER_THREAD);
+	assignHelices(3, SecondaryStructureIndex::HELIX_3_10, true);
+	assignHelices(5, SecondaryStructureIndex::HELIX_PI, true);
+}
+
+void SecondaryStructureAssigner::readBackbones(const AtomTable &atoms) {
+	size_t residueCount = atoms.residueCount();
+
+	std::vector<uint8_t> roles(atoms.names.size(), OTHER);
+	for (size_t id = 0; id < roles.size(); ++id) {
+		const std::string &name = atoms.names[static_cast<uint16_t>(id)];
+		roles[id] = name == "N" ? N : name == "CA" ? CA : name == "C" ? C : name == "O" ? O : OTHER;
+	}
+	int prolineId = -1;
+	for (size_t id = 0; id < atoms.residueNames.size(); ++id) {
+		if (atoms.residueNames[static_cast<uint16_t>(id)] == "PRO") {
+			prolineId = static_cast<int>(id);
+		}
+	}
+
+	backbones.resize(residueCount);
+	parallelFor(residueCount, [&](size_t first, size_t last) {
+		for (size_t r = first; r < last; ++r) {
+			size_t atomEnd = r + 1 < residueCount ? atoms.residueAtomStarts[r + 1] : atoms.size();
+			glm::vec3 *positions[] = {nullptr, &backbones[r].n, &backbones[r].ca, &backbones[r].c, &backbones[r].o};
+			bool found[5] = {};
+			//First location wins when a backbone atom has alternates
+			for (size_t a = atoms.residueAtomStarts[r]; a < atomEnd; ++a) {
+				uint8_t role = roles[atoms.nameIds[a]];
+				if (role != OTHER && !found[role]) {
+					*positions[role] = atoms.coords(a);
+					found[role] = true;
+				}
+			}
+			backbones[r].complete = found[N] && found[CA] && found[C] && found[O];
+		}
+	}, MIN_RESIDUES_PER_THREAD);
+
+	//Peptide bonded runs of complete residues, and the amide hydrogen placed opposite the previous carbonyl
+	segments.resize(residueCount);
+	segmentStarts.clear();
+	for (size_t r = 0; r < residueCount; ++r) {
+		Backbone &backbone = backbones[r];
+		bool bonded = r > 0 && backbone.complete && backbones[r - 1].complete &&
+			atoms.residueChainIndices[r] == atoms.residueChainIndices[r - 1] &&
+			glm::distance(backbones[r - 1].c, backbone.n) < MAX_PEPTIDE_BOND;
+		if (!bonded) {
+			segmentStarts.push_back(static_cast<uint32_t>(r));
+		}
+		segments[r] = static_cast<uint32_t>(segmentStarts.size() - 1);
+
+		backbone.donor = bonded && atoms.residueNameIds[r] != prolineId;
+		if (backbone.donor) {
+			backbone.h = backbone.n + glm::normalize(backbones[r - 1].c - backbones[r - 1].o);
+		}
+	}
+	segmentStarts.push_back(static_cast<uint32_t>(residueCount));
+}
+
+void SecondaryStructureAssigner::computeHBonds(const AtomTable &atoms) {
+	size_t residueCount = atoms.residueCount();
+
+	gridResidues.clear();
+	caX.clear();
+	caY.clear();
+	caZ.clear();
+	for (size_t r = 0; r < residueCount; ++r) {
+		if (backbones[r].complete) {
+			gridResidues.push_back(static_cast<uint32_t>(r));
+			caX.push_back(backbones[r].ca.x);
+			caY.push_back(backbones[r].ca.y);
+			caZ.push_back(backbones[r].ca.z);
+		}
+	}
+	grid.build(caX.data(), caY.data(), caZ.data(), gridResidues.size(), MAX_CA_DISTANCE);
+
+	//Each donor only writes its own two slots, so donors are split freely between threads
+	donorBonds.assign(2 * residueCount, HBond{NO_RESIDUE, 0.0f});
+	parallelFor(gridResidues.size(), [&](size_t first, size_t last) {
+		for (size_t point = first; point < last; ++point) {
+			uint32_t donor = gridResidues[point];
+			const Backbone &donorBackbone = backbones[donor];
+			if (!donorBackbone.donor) {
+				continue;
+			}
+			HBond *best = &donorBonds[2 * donor];
+			grid.forEachNear(caX[point], caY[point], caZ[point], [&](uint32_t other) {
+				uint32_t acceptor = gridResidues[other];
+				//The carbonyl right before an amide belongs to the same peptide bond
+				if (acceptor == donor || acceptor + 1 == donor) {
+					return;
+				}
+				const Backbone &acceptorBackbone = backbones[acceptor];
+				glm::vec3 offset = acceptorBackbone.ca - donorBackbone.ca;
+				if (glm::dot(offset, offset) >= MAX_CA_DISTANCE * MAX_CA_DISTANCE) {
+					return;
+				}
+				float energy = hbondEnergy(donorBackbone.n, donorBackbone.h, acceptorBackbone.c, acceptorBackbone.o);
+				if (energy < best[0].energy) {
+					best[1] = best[0];
+					best[0] = HBond{acceptor, energy};
+				}
+				else if (energy < best[1].energy) {
+					best[1] = HBond{acceptor, energy};
+				}
+			});
+		}
+	}, MIN_RESIDUES_PER_THREAD);
+}
+
+bool SecondaryStructureAssigner::hbond(size_t acceptor, size_t donor) const {
+	const HBond *bonds = &donorBonds[2 * donor];
+	return (bonds[0].acceptor == acceptor && bonds[0].energy < MAX_HBOND_ENERGY) ||
+		(bonds[1].acceptor == acceptor && bonds[1].energy < MAX_HBOND_ENERGY);
+}
+
+bool SecondaryStructureAssigner::turn(int n, size_t residue) const {
+	size_t end = residue + n;
+	return end < segments.size() && linked(residue, end) && hbond(residue, end);
+}
+
+void SecondaryStructureAssigner::findBridges() {
+	size_t residueCount = segments.size();
+	bridges.assign(2 * residueCount, Bridge{NO_RESIDUE, NO_BRIDGE});
+
+	//Bridges need both neighbors of both residues
+	auto inside = [&](size_t r) {
+		return r > 0 && r + 1 < residueCount && linked(r - 1, r + 1);
+	};
+
+	parallelFor(gridResidues.size(), [&](size_t first, size_t last) {
+		for (size_t point = first; point < last; ++point) {
+			uint32_t i = gridResidues[point];
+			if (!inside(i)) {
+				continue;
+			}
+			Bridge *found = &bridges[2 * i];
+			grid.forEachNear(caX[point], caY[point], caZ[point], [&](uint32_t other) {
+				uint32_t j = gridResidues[other];
+				if (!inside(j) || (linked(i, j) && std::abs(static_cast<long>(i) - static_cast<long>(j)) < 3)) {
+					return;
+				}
+				glm::vec3 offset = backbones[j].ca - backbones[i].ca;
+				if (glm::dot(offset, offset) >= MAX_CA_DISTANCE * MAX_CA_DISTANCE) {
+					return;
+				}
+				BridgeType type = NO_BRIDGE;
+				if ((hbond(i - 1, j) && hbond(j, i + 1)) || (hbond(j - 1, i) && hbond(i, j + 1))) {
+					type = PARALLEL;
+				}
+				else if ((hbond(i, j) && hbond(j, i)) || (hbond(i - 1, j + 1) && hbond(j - 1, i + 1))) {
+					type = ANTIPARALLEL;
+				}
+				if (type == NO_BRIDGE) {
+					return;
+				}
+				Bridge *slot = found[0].type == NO_BRIDGE ? &found[0] : found[1].type == NO_BRIDGE ? &found[1] : nullptr;
+				if (slot) {
+					*slot = Bridge{j, type};
+				}
+			});
+			//Grid order isn't residue order, keep partners sorted so the result doesn't depend on it
+			if (found[1].type != NO_BRIDGE && found[1].partner < found[0].partner) {
+				std::swap(found[0], found[1]);
+			}
+		}
+	}, MIN_RESIDUES_PER_THREAD);
+}
+
+void SecondaryStructureAssigner::assignHelices(int n, SecondaryStructureIndex::Structure structure, bool onlyUnassigned) {
+	//Helices never cross segment ends, so segments are independent
+	parallelFor(segmentStarts.size() - 1, [&](size_t first, size_t last) {
+		for (size_t segment = first; segment < last; ++segment) {
+			size_t start = segmentStarts[segment];
+			size_t end = segmentStarts[segment + 1];
+			//Two consecutive n-turns at i - 1 and i make residues i..i + n - 1 helical
+			for (size_t i = start + 1; i + n <= end; ++i) {
+				if (!turn(n, i - 1) || !turn(n, i)) {
+					continue;
+				}
+				bool free = true;
+				for (size_t r = i; onlyUnassigned && r < i + n; ++r) {
+					free = free && (residueStructures[r] == SecondaryStructureIndex::NONE || residueStructures[r] == structure);
+				}
+				if (!free) {
+					continue;
+				}
+				for (size_t r = i; r < i + n; ++r) {
+					residueStructures[r] = structure;
+				}
+			}
+		}
+	});
+}
+
+void SecondaryStructureAssigner::toRanges(const AtomTable &atoms, std::vector<Helix> &helices, std::vector<Sheet> &sheets) const {
+	size_t residueCount = residueStructures.size();
+	size_t runStart = 0;
+	for (size_t r = 1; r <= residueCount; ++r) {
+		uint8_t structure = residueStructures[runStart];
+		if (r < residueCount && residueStructures[r] == structure && linked(r - 1, r)) {
+			continue;
+		}
+		if (structure != SecondaryStructureIndex::NONE) {
+			char chain = atoms.chainIds[atoms.residueChainIndices[runStart]];
+			int residueStart = atoms.residueNums[runStart];
+			int residueEnd = atoms.residueNums[r - 1];
+			if (structure == SecondaryStructureIndex::SHEET) {
+				sheets.push_back(Sheet{chain, residueStart, residueEnd});
+			}
+			else {
+				helices.push_back(Helix{
+					helixType(static_cast<SecondaryStructureIndex::Structure>(structure)), chain, residueStart, residueEnd
+				});
+			}
+		}
+		runStart = r;
+	}
+}
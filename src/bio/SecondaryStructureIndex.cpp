@@ -0,0 +1,94 @@
+#include "bio/SecondaryStructureIndex.h"
+
+#include <algorithm>
+#include <climits>
+
+SecondaryStructureIndex::SecondaryStructureIndex() {
+	chainIndexOf.fill(-1);
+}
+
+SecondaryStructureIndex::Structure SecondaryStructureIndex::fromHelixType(int type) {
+	switch (type) {
+	//Alpha
+	case 1:
+	case 6:
+		return HELIX_ALPHA;
+	//3/10
+	case 5:
+		return HELIX_3_10;
+	//Pi
+	case 3:
+		return HELIX_PI;
+	default:
+		return HELIX_OTHER;
+	}
+}
+
+void SecondaryStructureIndex::clear() {
+	residueStructures.clear();
+	chains.clear();
+	chainIndexOf.fill(-1);
+}
+
+void SecondaryStructureIndex::build(const std::vector<Helix> &helices, const std::vector<Sheet> &sheets, const AtomTable &atoms) {
+	clear();
+
+	//Residue number range of every chain
+	std::vector<int> first(atoms.chainIds.size(), INT_MAX);
+	std::vector<int> last(atoms.chainIds.size(), INT_MIN);
+	for (size_t i = 0; i < atoms.residueCount(); ++i) {
+		uint16_t chain = atoms.residueChainIndices[i];
+		first[chain] = std::min(first[chain], atoms.residueNums[i]);
+		last[chain] = std::max(last[chain], atoms.residueNums[i]);
+	}
+	chains.resize(atoms.chainIds.size());
+	for (size_t i = 0; i < chains.size(); ++i) {
+		chainIndexOf[static_cast<unsigned char>(atoms.chainIds[i])] = static_cast<int16_t>(i);
+		if (first[i] <= last[i]) {
+			chains[i].firstResidue = first[i];
+			chains[i].structures.assign(static_cast<size_t>(last[i] - first[i]) + 1, NONE);
+		}
+	}
+
+	auto mark = [&](char chain, int residueStart, int residueEnd, Structure structure) {
+		int index = chainIndexOf[static_cast<unsigned char>(chain)];
+		if (index < 0 || chains[index].structures.empty()) {
+			return;
+		}
+		ChainRange &range = chains[index];
+		int lastResidue = range.firstResidue + static_cast<int>(range.structures.size()) - 1;
+		int begin = std::max(residueStart, range.firstResidue);
+		int end = std::min(residueEnd, lastResidue);
+		if (begin <= end) {
+			std::fill(range.structures.begin() + (begin - range.firstResidue),
+				range.structures.begin() + (end - range.firstResidue) + 1, structure);
+		}
+	};
+
+	//Lowest priority first, later writes win
+	for (const auto &sheet : sheets) {
+		mark(sheet.chain, sheet.residueStart, sheet.residueEnd, SHEET);
+	}
+	for (auto helix = helices.rbegin(); helix != helices.rend(); ++helix) {
+		mark(helix->chain, helix->residueStart, helix->residueEnd, fromHelixType(helix->type));
+	}
+
+	residueStructures.resize(atoms.residueCount());
+	for (size_t i = 0; i < atoms.residueCount(); ++i) {
+		const ChainRange &range = chains[atoms.residueChainIndices[i]];
+		residueStructures[i] = range.structures[atoms.residueNums[i] - range.firstResidue];
+	}
+}
+
+SecondaryStructureIndex::Structure SecondaryStructureIndex::lookup(char chain, int residueNum) const {
+	int index = chainIndexOf[static_cast<unsigned char>(chain)];
+	if (index < 0) {
+		return NONE;
+	}
+	const ChainRange &range = chains[index];
+	long long offset = static_cast<long long>(residueNum) - range.firstResidue;
+	if (offset < 0 || offset >= static_cast<long long>(range.structures.size())) {
+		return NONE;
+	}
+	return static_cast<Structure>(range.structures[offset]);
+}
@@ -0,0 +1,885 @@
+#include "bio/Selection.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+#include "bio/AminoAcid.h"
+#include "bio/Parallel.h"
+#include "bio/SpatialGrid.h"
+
+namespace {
+
+//Words per thread, 2048 words are 131072 atoms
+constexpr size_t MIN_WORDS_PER_THREAD = 2048;
+constexpr int64_t MIN_INTEGER = std::numeric_limits<int64_t>::min();
+constexpr int64_t MAX_INTEGER = std::numeric_limits<int64_t>::max();
+
+const char *const NUCLEIC_NAMES[] = {"A", "C", "G", "U", "T", "I", "DA", "DC", "DG", "DT", "DU", "DI"};
+const char *const WATER_NAMES[] = {"HOH", "WAT", "H2O", "DOD", "SOL", "TIP", "TIP3", "TIP4", "SPC", "T3P"};
+const char *const BACKBONE_NAMES[] = {"N", "CA", "C", "O", "OXT"};
+
+enum class TokenType : uint8_t {
+	WORD, STRING, OPEN, CLOSE, OPERATOR, END
+};
+
+struct Token {
+	TokenType type;
+	std::string text;
+	size_t position;
+};
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//Glob match with * for any run of characters and ? for any one
+bool matches(std::string_view pattern, std::string_view text) {
+	size_t p = 0, t = 0, starP = std::string_view::npos, starT = 0;
+	while (t < text.size()) {
+		if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+			++p;
+			++t;
+		} else if (p < pattern.size() && pattern[p] == '*') {
+			starP = p++;
+			starT = t;
+		} else if (starP != std::string_view::npos) {
+			p = starP + 1;
+			t = ++starT;
+		} else {
+			return false;
+		}
+	}
+	while (p < pattern.size() && pattern[p] == '*') {
+		++p;
+	}
+	return p == pattern.size();
+}
+
+bool matchesAny(const std::vector<std::string> &patterns, std::string_view text) {
+	for (const std::string &pattern : patterns) {
+		if (matches(pattern, text)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <size_t N>
+bool isOneOf(const char *const (&names)[N], const std::string &text) {
+	return std::find(std::begin(names), std::end(names), text) != std::end(names);
+}
+
+bool inRanges(const std::vector<std::pair<int64_t, int64_t>> &ranges, int64_t value) {
+	for (const auto &range : ranges) {
+		if (value >= range.first && value <= range.second) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool tokenize(std::string_view text, std::vector<Token> &tokens, std::string &error) {
+	size_t i = 0;
+	while (i < text.size()) {
+		char c = text[i];
+		if (std::isspace(static_cast<unsigned char>(c))) {
+			++i;
+		} else if (c == '(' || c == ')') {
+			tokens.push_back({c == '(' ? TokenType::OPEN : TokenType::CLOSE, std::string(1, c), i});
+			++i;
+		} else if (c == '<' || c == '>' || c == '=' || c == '!') {
+			size_t length = i + 1 < text.size() && text[i + 1] == '=' ? 2 : 1;
+			std::string op(text.substr(i, length));
+			if (op == "=" || op == "!") {
+				error = "Unknown operator '" + op + "' at column " + std::to_string(i + 1);
+				return false;
+			}
+			tokens.push_back({TokenType::OPERATOR, op, i});
+			i += length;
+		} else if (c == '"') {
+			size_t end = text.find('"', i + 1);
+			if (end == std::string_view::npos) {
+				error = "Unterminated quote at column " + std::to_string(i + 1);
+				return false;
+			}
+			tokens.push_back({TokenType::STRING, std::string(text.substr(i + 1, end - i - 1)), i});
+			i = end + 1;
+		} else {
+			size_t begin = i;
+			while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) &&
+				text[i] != '(' && text[i] != ')' && text[i] != '<' && text[i] != '>' &&
+				text[i] != '=' && text[i] != '!' && text[i] != '"') {
+				++i;
+			}
+			tokens.push_back({TokenType::WORD, std::string(text.substr(begin, i - begin)), begin});
+		}
+	}
+	tokens.push_back({TokenType::END, "", text.size()});
+	return true;
+}
+
+bool parseInteger(const std::string &text, int64_t &value) {
+	if (text.empty()) {
+		return false;
+	}
+	char *end;
+	errno = 0;
+	value = std::strtoll(text.c_str(), &end, 10);
+	return errno == 0 && *end == '\0';
+}
+
+bool parseFloat(const std::string &text, float &value) {
+	if (text.empty()) {
+		return false;
+	}
+	char *end;
+	value = std::strtof(text.c_str(), &end);
+	return *end == '\0';
+}
+
+/*
+Recursive descent over the tokens, emitting the postfix program as it goes:
+	or := and ("or" and)*
+	and := unary ("and" unary)*
+	unary := "not" unary | "within" number "of" unary | "byres" unary
+		| "same" "residue" "as" unary | primary
+	primary := "(" or ")" | keyword values | keyword operator number | class
+*/
+class Parser {
+private:
+	using Instruction = Selection::Instruction;
+	using Op = Selection::Op;
+
+	const std::vector<Token> &tokens;
+	std::vector<Instruction> &program;
+	std::string &error;
+	size_t next = 0;
+
+	const Token &peek() const {
+		return tokens[next];
+	}
+
+	bool isWord(const Token &token, std::string_view word) const {
+		return token.type == TokenType::WORD && equalsIgnoreCase(token.text, word);
+	}
+
+	bool accept(std::string_view word) {
+		if (isWord(peek(), word)) {
+			++next;
+			return true;
+		}
+		return false;
+	}
+
+	bool fail(const std::string &message) {
+		const Token &token = peek();
+		error = message + (token.type == TokenType::END ? " at end of expression" :
+			" at '" + token.text + "' (column " + std::to_string(token.position + 1) + ")");
+		return false;
+	}
+
+	//Unquoted boolean operators end value lists
+	bool isValue(const Token &token) const {
+		if (token.type == TokenType::STRING) {
+			return true;
+		}
+		return token.type == TokenType::WORD && !isWord(token, "and") && !isWord(token, "or") && !isWord(token, "not");
+	}
+
+	void emit(Op op) {
+		Instruction instruction;
+		instruction.op = op;
+		program.push_back(std::move(instruction));
+	}
+
+	bool parseValues(Instruction &instruction) {
+		while (isValue(peek())) {
+			instruction.patterns.push_back(peek().text);
+			++next;
+		}
+		return !instruction.patterns.empty() || fail("Expected a value");
+	}
+
+	//Single values or ranges written a-b, a:b or a to b
+	bool parseRanges(Instruction &instruction) {
+		while (isValue(peek())) {
+			const std::string &text = tokens[next].text;
+			int64_t first, last;
+			//The separator of a range is the first '-' or ':' after the leading sign
+			size_t separator = text.find_first_of("-:", 1);
+			if (separator != std::string::npos) {
+				if (!parseInteger(text.substr(0, separator), first) || !parseInteger(text.substr(separator + 1), last)) {
+					return fail("Expected an integer range");
+				}
+				++next;
+			} else {
+				if (!parseInteger(text, first)) {
+					return fail("Expected an integer");
+				}
+				++next;
+				last = first;
+				if (accept("to")) {
+					if (!isValue(peek()) || !parseInteger(peek().text, last)) {
+						return fail("Expected an integer");
+					}
+					++next;
+				}
+			}
+			instruction.ranges.emplace_back(std::min(first, last), std::max(first, last));
+		}
+		return !instruction.ranges.empty() || fail("Expected an integer");
+	}
+
+	bool parseComparison(Selection::Comparison &comparison) {
+		const std::string &op = peek().text;
+		if (op == "<") {
+			comparison = Selection::Comparison::LESS;
+		} else if (op == "<=") {
+			comparison = Selection::Comparison::LESS_EQUAL;
+		} else if (op == ">") {
+			comparison = Selection::Comparison::GREATER;
+		} else if (op == ">=") {
+			comparison = Selection::Comparison::GREATER_EQUAL;
+		} else if (op == "==") {
+			comparison = Selection::Comparison::EQUAL;
+		} else {
+			comparison = Selection::Comparison::NOT_EQUAL;
+		}
+		++next;
+		return true;
+	}
+
+	//resid and index comparisons become ranges so they share the range kernels
+	bool parseIntegerComparison(Instruction &instruction) {
+		Selection::Comparison comparison;
+		parseComparison(comparison);
+		int64_t value;
+		if (!isValue(peek()) || !parseInteger(peek().text, value)) {
+			return fail("Expected an integer");
+		}
+		++next;
+		switch (comparison) {
+		case Selection::Comparison::LESS:
+			if (value > MIN_INTEGER) {
+				instruction.ranges.emplace_back(MIN_INTEGER, value - 1);
+			}
+			break;
+		case Selection::Comparison::LESS_EQUAL:
+			instruction.ranges.emplace_back(MIN_INTEGER, value);
+			break;
+		case Selection::Comparison::GREATER:
+			if (value < MAX_INTEGER) {
+				instruction.ranges.emplace_back(value + 1, MAX_INTEGER);
+			}
+			break;
+		case Selection::Comparison::GREATER_EQUAL:
+			instruction.ranges.emplace_back(value, MAX_INTEGER);
+			break;
+		case Selection::Comparison::EQUAL:
+			instruction.ranges.emplace_back(value, value);
+			break;
+		case Selection::Comparison::NOT_EQUAL:
+			if (value > MIN_INTEGER) {
+				instruction.ranges.emplace_back(MIN_INTEGER, value - 1);
+			}
+			if (value < MAX_INTEGER) {
+				instruction.ranges.emplace_back(value + 1, MAX_INTEGER);
+			}
+			break;
+		}
+		return true;
+	}
+
+	bool parsePrimary() {
+		const Token &token = peek();
+		if (token.type == TokenType::OPEN) {
+			++next;
+			if (!parseOr()) {
+				return false;
+			}
+			if (peek().type != TokenType::CLOSE) {
+				return fail("Expected ')'");
+			}
+			++next;
+			return true;
+		}
+		if (token.type != TokenType::WORD) {
+			return fail("Expected a keyword");
+		}
+
+		Instruction instruction;
+		const std::string &keyword = token.text;
+		++next;
+		if (equalsIgnoreCase(keyword, "all")) {
+			emit(Op::ALL);
+		} else if (equalsIgnoreCase(keyword, "none")) {
+			emit(Op::NONE);
+		} else if (equalsIgnoreCase(keyword, "protein")) {
+			emit(Op::PROTEIN);
+		} else if (equalsIgnoreCase(keyword, "nucleic")) {
+			emit(Op::NUCLEIC);
+		} else if (equalsIgnoreCase(keyword, "water")) {
+			emit(Op::WATER);
+		} else if (equalsIgnoreCase(keyword, "hydrogen")) {
+			emit(Op::HYDROGEN);
+		} else if (equalsIgnoreCase(keyword, "backbone")) {
+			emit(Op::BACKBONE);
+		} else if (equalsIgnoreCase(keyword, "sidechain")) {
+			emit(Op::PROTEIN);
+			emit(Op::BACKBONE);
+			emit(Op::NOT);
+			emit(Op::AND);
+		} else if (equalsIgnoreCase(keyword, "ligand")) {
+			emit(Op::PROTEIN);
+			emit(Op::NUCLEIC);
+			emit(Op::OR);
+			emit(Op::WATER);
+			emit(Op::OR);
+			emit(Op::NOT);
+		} else if (equalsIgnoreCase(keyword, "chain") || equalsIgnoreCase(keyword, "resname") ||
+			equalsIgnoreCase(keyword, "name") || equalsIgnoreCase(keyword, "element") ||
+			equalsIgnoreCase(keyword, "elem")) {
+			instruction.op = equalsIgnoreCase(keyword, "chain") ? Op::CHAIN :
+				equalsIgnoreCase(keyword, "resname") ? Op::RESIDUE_NAME :
+				equalsIgnoreCase(keyword, "name") ? Op::ATOM_NAME : Op::ELEMENT;
+			if (!parseValues(instruction)) {
+				return false;
+			}
+			program.push_back(std::move(instruction));
+		} else if (equalsIgnoreCase(keyword, "resid") || equalsIgnoreCase(keyword, "resnum") ||
+			equalsIgnoreCase(keyword, "index")) {
+			instruction.op = equalsIgnoreCase(keyword, "index") ? Op::INDEX : Op::RESIDUE_NUM;
+			bool parsed = peek().type == TokenType::OPERATOR ? parseIntegerComparison(instruction) : parseRanges(instruction);
+			if (!parsed) {
+				return false;
+			}
+			program.push_back(std::move(instruction));
+		} else if (equalsIgnoreCase(keyword, "x") || equalsIgnoreCase(keyword, "y") || equalsIgnoreCase(keyword, "z") ||
+			equalsIgnoreCase(keyword, "bfactor") || equalsIgnoreCase(keyword, "beta")) {
+			instruction.op = Op::COMPARE;
+			instruction.column = equalsIgnoreCase(keyword, "x") ? Selection::Column::X :
+				equalsIgnoreCase(keyword, "y") ? Selection::Column::Y :
+				equalsIgnoreCase(keyword, "z") ? Selection::Column::Z : Selection::Column::B_FACTOR;
+			if (peek().type != TokenType::OPERATOR) {
+				return fail("Expected a comparison");
+			}
+			parseComparison(instruction.comparison);
+			if (!isValue(peek()) || !parseFloat(peek().text, instruction.value)) {
+				return fail("Expected a number");
+			}
+			++next;
+			program.push_back(std::move(instruction));
+		} else {
+			--next;
+			return fail("Unknown keyword");
+		}
+		return true;
+	}
+
+	bool parseUnary() {
+		if (accept("not")) {
+			if (!parseUnary()) {
+				return false;
+			}
+			emit(Op::NOT);
+			return true;
+		}
+		if (accept("within")) {
+			Instruction instruction;
+			instruction.op = Op::WITHIN;
+			if (!isValue(peek()) || !parseFloat(peek().text, instruction.value) || !(instruction.value >= 0.0f)) {
+				return fail("Expected a distance");
+			}
+			++next;
+			if (!accept("of")) {
+				return fail("Expected 'of'");
+			}
+			if (!parseUnary()) {
+				return false;
+			}
+			program.push_back(std::move(instruction));
+			return true;
+		}
+		bool byResidue = accept("byres");
+		if (!byResidue && accept("same")) {
+			if (!accept("residue") || !accept("as")) {
+				return fail("Expected 'same residue as'");
+			}
+			byResidue = true;
+		}
+		if (byResidue) {
+			if (!parseUnary()) {
+				return false;
+			}
+			emit(Op::BYRES);
+			return true;
+		}
+		return parsePrimary();
+	}
+
+	//within terms go last, so they only measure distances for atoms the other terms kept
+	bool parseAnd() {
+		std::vector<std::vector<Instruction>> terms;
+		do {
+			size_t begin = program.size();
+			if (!parseUnary()) {
+				return false;
+			}
+			terms.emplace_back(std::make_move_iterator(program.begin() + begin), std::make_move_iterator(program.end()));
+			program.resize(begin);
+		} while (accept("and"));
+
+		std::stable_partition(terms.begin(), terms.end(), [](const std::vector<Instruction> &term) {
+			return term.back().op != Op::WITHIN;
+		});
+		for (size_t i = 0; i < terms.size(); ++i) {
+			program.insert(program.end(), std::make_move_iterator(terms[i].begin()), std::make_move_iterator(terms[i].end()));
+			if (i > 0) {
+				emit(Op::AND);
+			}
+		}
+		return true;
+	}
+
+public:
+	Parser(const std::vector<Token> &tokens, std::vector<Instruction> &program, std::string &error) :
+		tokens(tokens), program(program), error(error) {}
+
+	bool parseOr() {
+		if (!parseAnd()) {
+			return false;
+		}
+		while (accept("or")) {
+			if (!parseAnd()) {
+				return false;
+			}
+			emit(Op::OR);
+		}
+		return true;
+	}
+
+	bool parse() {
+		if (!parseOr()) {
+			return false;
+		}
+		return peek().type == TokenType::END || fail("Expected 'and' or 'or'");
+	}
+};
+
+/*
+Sets the words of mask from test(atom), which returns 0 or 1. The flags of 64
+atoms are gathered into bytes first, a loop the compiler can vectorize, then
+packed 8 at a time: multiplying 8 little-endian 0/1 bytes by 0x0102040810204080
+sums byte i into bit 56 + i.
+*/
+template <class Test>
+void gatherBits(AtomMask &mask, Test test) {
+	size_t count = mask.size;
+	parallelFor(mask.words.size(), [&](size_t begin, size_t end) {
+		uint8_t flags[64];
+		for (size_t w = begin; w < end; ++w) {
+			size_t base = w * 64;
+			size_t bits = std::min<size_t>(64, count - base);
+			for (size_t b = 0; b < bits; ++b) {
+				flags[b] = static_cast<uint8_t>(test(base + b));
+			}
+			std::fill(flags + bits, flags + 64, 0);
+			uint64_t word = 0;
+			for (size_t group = 0; group < 8; ++group) {
+				uint64_t bytes;
+				std::memcpy(&bytes, flags + group * 8, 8);
+				word |= ((bytes * 0x0102040810204080ULL) >> 56) << (group * 8);
+			}
+			mask.words[w] = word;
+		}
+	}, MIN_WORDS_PER_THREAD);
+}
+
+//Matches of every id of a pool
+std::vector<uint8_t> poolTable(const StringPool &pool, const std::vector<std::string> &patterns) {
+	std::vector<uint8_t> table(pool.size());
+	for (size_t id = 0; id < table.size(); ++id) {
+		table[id] = matchesAny(patterns, pool[static_cast<uint16_t>(id)]);
+	}
+	return table;
+}
+
+template <class Table>
+void gatherResidues(const AtomTable &atoms, const Table &residueTable, AtomMask &mask) {
+	const uint32_t *residueIndices = atoms.residueIndices.data();
+	gatherBits(mask, [&](size_t atom) {
+		return residueTable[residueIndices[atom]];
+	});
+}
+
+template <class Compare>
+void compareColumn(const std::vector<float> &column, float value, AtomMask &mask, Compare compare) {
+	const float *values = column.data();
+	gatherBits(mask, [&](size_t atom) {
+		return compare(values[atom], value);
+	});
+}
+
+//Per residue name id: 1 for amino acids, 2 for nucleotides, 3 for water
+std::vector<uint8_t> residueClasses(const AtomTable &atoms) {
+	std::vector<uint8_t> classes(atoms.residueNames.size());
+	for (size_t id = 0; id < classes.size(); ++id) {
+		const std::string &name = atoms.residueNames[static_cast<uint16_t>(id)];
+		const AminoAcid *aminoAcid = name.size() == 3 ? AminoAcid::get(name) : nullptr;
+		if (aminoAcid && aminoAcid->abbr3 == name) {
+			classes[id] = 1;
+		} else if (isOneOf(NUCLEIC_NAMES, name)) {
+			classes[id] = 2;
+		} else if (isOneOf(WATER_NAMES, name)) {
+			classes[id] = 3;
+		}
+	}
+	return classes;
+}
+
+//Atoms closer than radius to source. Atoms not in candidates (if any) are left out, for within on the right of and
+void within(const AtomTable &atoms, float radius, const AtomMask &source, const AtomMask *candidates, AtomMask &mask) {
+	std::vector<uint32_t> sourceAtoms = source.indices();
+	if (sourceAtoms.empty()) {
+		return;
+	}
+	std::vector<float> x(sourceAtoms.size()), y(sourceAtoms.size()), z(sourceAtoms.size());
+	float minX = atoms.x[sourceAtoms[0]], minY = atoms.y[sourceAtoms[0]], minZ = atoms.z[sourceAtoms[0]];
+	float maxX = minX, maxY = minY, maxZ = minZ;
+	for (size_t i = 0; i < sourceAtoms.size(); ++i) {
+		x[i] = atoms.x[sourceAtoms[i]];
+		y[i] = atoms.y[sourceAtoms[i]];
+		z[i] = atoms.z[sourceAtoms[i]];
+		minX = std::min(minX, x[i]);
+		minY = std::min(minY, y[i]);
+		minZ = std::min(minZ, z[i]);
+		maxX = std::max(maxX, x[i]);
+		maxY = std::max(maxY, y[i]);
+		maxZ = std::max(maxZ, z[i]);
+	}
+	minX -= radius;
+	minY -= radius;
+	minZ -= radius;
+	maxX += radius;
+	maxY += radius;
+	maxZ += radius;
+
+	SpatialGrid grid;
+	grid.build(x.data(), y.data(), z.data(), sourceAtoms.size(), radius);
+	const float *ax = atoms.x.data(), *ay = atoms.y.data(), *az = atoms.z.data();
+	gatherBits(mask, [&](size_t atom) {
+		if (candidates && !candidates->test(atom)) {
+			return false;
+		}
+		float px = ax[atom], py = ay[atom], pz = az[atom];
+		if (px < minX || px > maxX || py < minY || py > maxY || pz < minZ || pz > maxZ) {
+			return false;
+		}
+		if (source.test(atom)) {
+			return true;
+		}
+		return grid.anyWithin(px, py, pz, radius);
+	});
+}
+
+void byResidue(const AtomTable &atoms, const AtomMask &source, AtomMask &mask) {
+	//Selections are mostly sparse, walk the set bits rather than every atom
+	std::vector<uint8_t> residues(atoms.residueCount());
+	for (size_t w = 0; w < source.words.size(); ++w) {
+		uint64_t word = source.words[w];
+		for (size_t atom = w * 64; word; ++atom, word >>= 1) {
+			if (word & 1) {
+				residues[atoms.residueIndices[atom]] = 1;
+			}
+		}
+	}
+	gatherResidues(atoms, residues, mask);
+}
+
+}
+
+void AtomMask::resize(size_t atomCount) {
+	size = atomCount;
+	words.assign((atomCount + 63) / 64, 0);
+}
+
+size_t AtomMask::count() const {
+	std::atomic<size_t> total(0);
+	parallelFor(words.size(), [&](size_t begin, size_t end) {
+		size_t bits = 0;
+		for (size_t w = begin; w < end; ++w) {
+			bits += std::bitset<64>(words[w]).count();
+		}
+		total += bits;
+	}, MIN_WORDS_PER_THREAD * 8);
+	return total;
+}
+
+std::vector<uint32_t> AtomMask::indices() const {
+	std::vector<uint32_t> result;
+	for (size_t w = 0; w < words.size(); ++w) {
+		uint64_t word = words[w];
+		for (uint32_t atom = static_cast<uint32_t>(w * 64); word; ++atom, word >>= 1) {
+			if (word & 1) {
+				result.push_back(atom);
+			}
+		}
+	}
+	return result;
+}
+
+std::vector<bool> AtomMask::flags() const {
+	std::vector<bool> result(size);
+	for (size_t i = 0; i < size; ++i) {
+		result[i] = test(i);
+	}
+	return result;
+}
+
+Selection::Selection(std::string_view expression) {
+	compile(expression);
+}
+
+bool Selection::compile(std::string_view expression) {
+	std::vector<Token> tokens;
+	std::string message;
+	if (!tokenize(expression, tokens, message)) {
+		errorMessage = message;
+		return false;
+	}
+	std::vector<Instruction> compiled;
+	Parser parser(tokens, compiled, message);
+	if (!parser.parse()) {
+		errorMessage = message;
+		return false;
+	}
+	program = std::move(compiled);
+	source = expression;
+	errorMessage.clear();
+	return true;
+}
+
+AtomMask Selection::evaluate(const AtomTable &atoms) const {
+	AtomMask mask;
+	evaluate(atoms, mask);
+	return mask;
+}
+
+void Selection::evaluate(const AtomTable &atoms, AtomMask &out) const {
+	out.resize(atoms.size());
+	if (program.empty() || atoms.empty()) {
+		return;
+	}
+
+	//Residue name classes are only needed by a few ops, resolve them on first use
+	std::vector<uint8_t> classes;
+	auto classTable = [&](uint8_t residueClass) {
+		if (classes.empty()) {
+			classes = residueClasses(atoms);
+		}
+		std::vector<uint8_t> residues(atoms.residueCount());
+		for (size_t residue = 0; residue < residues.size(); ++residue) {
+			residues[residue] = classes[atoms.residueNameIds[residue]] == residueClass;
+		}
+		return residues;
+	};
+
+	std::vector<AtomMask> stack;
+	for (size_t i = 0; i < program.size(); ++i) {
+		const Instruction &instruction = program[i];
+		if (instruction.op == Op::AND || instruction.op == Op::OR) {
+			AtomMask right = std::move(stack.back());
+			stack.pop_back();
+			AtomMask &left = stack.back();
+			bool isAnd = instruction.op == Op::AND;
+			parallelFor(left.words.size(), [&](size_t begin, size_t end) {
+				for (size_t w = begin; w < end; ++w) {
+					left.words[w] = isAnd ? left.words[w] & right.words[w] : left.words[w] | right.words[w];
+				}
+			}, MIN_WORDS_PER_THREAD * 8);
+			continue;
+		}
+		if (instruction.op == Op::NOT) {
+			AtomMask &top = stack.back();
+			parallelFor(top.words.size(), [&](size_t begin, size_t end) {
+				for (size_t w = begin; w < end; ++w) {
+					top.words[w] = ~top.words[w];
+				}
+			}, MIN_WORDS_PER_THREAD * 8);
+			if (top.size % 64) {
+				top.words.back() &= (uint64_t(1) << (top.size % 64)) - 1;
+			}
+			continue;
+		}
+		if (instruction.op == Op::WITHIN || instruction.op == Op::BYRES) {
+			AtomMask source = std::move(stack.back());
+			AtomMask &result = stack.back();
+			result.resize(atoms.size());
+			if (instruction.op == Op::WITHIN) {
+				//S and within R of T only needs distances for the atoms of S
+				bool anded = i + 1 < program.size() && program[i + 1].op == Op::AND;
+				within(atoms, instruction.value, source, anded ? &stack[stack.size() - 2] : nullptr, result);
+			} else {
+				byResidue(atoms, source, result);
+			}
+			continue;
+		}
+
+		stack.emplace_back();
+		AtomMask &mask = stack.back();
+		mask.resize(atoms.size());
+		switch (instruction.op) {
+		case Op::ALL:
+			gatherBits(mask, [](size_t) {
+				return true;
+			});
+			break;
+
+		case Op::NONE:
+			break;
+
+		case Op::CHAIN: {
+			//Full identifiers, chainIds only holds the codes AtomTable::chainCode() gave multi-character ones
+			std::vector<uint8_t> chains(atoms.chainIds.size());
+			for (size_t chain = 0; chain < chains.size(); ++chain) {
+				chains[chain] = matchesAny(instruction.patterns, atoms.chainName(chain));
+			}
+			std::vector<uint8_t> residues(atoms.residueCount());
+			for (size_t residue = 0; residue < residues.size(); ++residue) {
+				residues[residue] = chains[atoms.residueChainIndices[residue]];
+			}
+			gatherResidues(atoms, residues, mask);
+			break;
+		}
+
+		case Op::RESIDUE_NAME: {
+			std::vector<uint8_t> names = poolTable(atoms.residueNames, instruction.patterns);
+			std::vector<uint8_t> residues(atoms.residueCount());
+			for (size_t residue = 0; residue < residues.size(); ++residue) {
+				residues[residue] = names[atoms.residueNameIds[residue]];
+			}
+			gatherResidues(atoms, residues, mask);
+			break;
+		}
+
+		case Op::RESIDUE_NUM: {
+			std::vector<uint8_t> residues(atoms.residueCount());
+			for (size_t residue = 0; residue < residues.size(); ++residue) {
+				residues[residue] = inRanges(instruction.ranges, atoms.residueNums[residue]);
+			}
+			gatherResidues(atoms, residues, mask);
+			break;
+		}
+
+		case Op::ATOM_NAME:
+		case Op::ELEMENT: {
+			bool isName = instruction.op == Op::ATOM_NAME;
+			std::vector<uint8_t> table = poolTable(isName ? atoms.names : atoms.elements, instruction.patterns);
+			const uint16_t *ids = isName ? atoms.nameIds.data() : atoms.elementIds.data();
+			gatherBits(mask, [&](size_t atom) {
+				return table[ids[atom]];
+			});
+			break;
+		}
+
+		case Op::INDEX:
+			//Ranges set whole words where they can
+			for (const auto &range : instruction.ranges) {
+				int64_t first = std::max<int64_t>(range.first, 0);
+				int64_t last = std::min<int64_t>(range.second, static_cast<int64_t>(mask.size) - 1);
+				for (int64_t atom = first; atom <= last;) {
+					if (atom % 64 == 0 && last - atom >= 63) {
+						mask.words[atom / 64] = ~uint64_t(0);
+						atom += 64;
+					} else {
+						mask.words[atom / 64] |= uint64_t(1) << (atom % 64);
+						++atom;
+					}
+				}
+			}
+			break;
+
+		case Op::COMPARE: {
+			const std::vector<float> &column = instruction.column == Column::X ? atoms.x :
+				instruction.column == Column::Y ? atoms.y :
+				instruction.column == Column::Z ? atoms.z : atoms.bFactors;
+			//One instantiation per comparison keeps the branch out of the atom loop
+			switch (instruction.comparison) {
+			case Comparison::LESS:
+				compareColumn(column, instruction.value, mask, [](float a, float b) { return a < b; });
+				break;
+			case Comparison::LESS_EQUAL:
+				compareColumn(column, instruction.value, mask, [](float a, float b) { return a <= b; });
+				break;
+			case Comparison::GREATER:
+				compareColumn(column, instruction.value, mask, [](float a, float b) { return a > b; });
+				break;
+			case Comparison::GREATER_EQUAL:
+				compareColumn(column, instruction.value, mask, [](float a, float b) { return a >= b; });
+				break;
+			case Comparison::EQUAL:
+				compareColumn(column, instruction.value, mask, [](float a, float b) { return a == b; });
+				break;
+			case Comparison::NOT_EQUAL:
+				compareColumn(column, instruction.value, mask, [](float a, float b) { return a != b; });
+				break;
+			}
+			break;
+		}
+
+		case Op::PROTEIN:
+			gatherResidues(atoms, classTable(1), mask);
+			break;
+
+		case Op::NUCLEIC:
+			gatherResidues(atoms, classTable(2), mask);
+			break;
+
+		case Op::WATER:
+			gatherResidues(atoms, classTable(3), mask);
+			break;
+
+		case Op::HYDROGEN: {
+			std::vector<uint8_t> table = poolTable(atoms.elements, {"H", "D"});
+			const uint16_t *ids = atoms.elementIds.data();
+			gatherBits(mask, [&](size_t atom) {
+				return table[ids[atom]];
+			});
+			break;
+		}
+
+		case Op::BACKBONE: {
+			std::vector<uint8_t> residues = classTable(1);
+			std::vector<uint8_t> names(atoms.names.size());
+			for (size_t id = 0; id < names.size(); ++id) {
+				names[id] = isOneOf(BACKBONE_NAMES, atoms.names[static_cast<uint16_t>(id)]);
+			}
+			const uint16_t *ids = atoms.nameIds.data();
+			const uint32_t *residueIndices = atoms.residueIndices.data();
+			gatherBits(mask, [&](size_t atom) {
+				return names[ids[atom]] & residues[residueIndices[atom]];
+			});
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+	out = std::move(stack.back());
+}
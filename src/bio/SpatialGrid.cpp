@@ -0,0 +1,155 @@
+#include "bio/SpatialGrid.h"
+
+#include <atomic>
+#include <memory>
+
+#include "bio/Parallel.h"
+
+namespace {
+
+//Below this many points the serial counting sort wins over the atomics
+constexpr size_t PARALLEL_MIN_POINTS = 1 << 16;
+
+}
+
+void SpatialGrid::clear() {
+	cellsX = cellsY = cellsZ = 0;
+	cellStarts.clear();
+	items.clear();
+	cellOfItem.clear();
+	slotX.clear();
+	slotY.clear();
+	slotZ.clear();
+}
+
+void SpatialGrid::build(const float *x, const float *y, const float *z, size_t count, float minimumCellSize) {
+	clear();
+	if (count == 0) {
+		return;
+	}
+
+	float minX = x[0], minY = y[0], minZ = z[0];
+	float maxX = x[0], maxY = y[0], maxZ = z[0];
+	for (size_t i = 1; i < count; ++i) {
+		minX = std::min(minX, x[i]);
+		minY = std::min(minY, y[i]);
+		minZ = std::min(minZ, z[i]);
+		maxX = std::max(maxX, x[i]);
+		maxY = std::max(maxY, y[i]);
+		maxZ = std::max(maxZ, z[i]);
+	}
+
+	//Cells along each axis include the empty layer on both sides
+	cellSize = std::max(minimumCellSize, 1e-3f);
+	size_t maxCells = std::max<size_t>(count * 4, 4096);
+	while (true) {
+		cellsX = static_cast<int>((maxX - minX) / cellSize) + 3;
+		cellsY = static_cast<int>((maxY - minY) / cellSize) + 3;
+		cellsZ = static_cast<int>((maxZ - minZ) / cellSize) + 3;
+		if (static_cast<double>(cellsX) * cellsY * cellsZ <= static_cast<double>(maxCells)) {
+			break;
+		}
+		cellSize *= 1.25f;
+	}
+	originX = minX - cellSize;
+	originY = minY - cellSize;
+	originZ = minZ - cellSize;
+
+	size_t row = 0;
+	for (ptrdiff_t k = -1; k <= 1; ++k) {
+		for (ptrdiff_t j = -1; j <= 1; ++j) {
+			rowOffsets[row++] = (k * cellsY + j) * cellsX - 1;
+		}
+	}
+
+	//Counting sort: cell of every point, cell sizes, offsets, scatter
+	cellOfItem.resize(count);
+	parallelFor(count, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			cellOfItem[i] = static_cast<uint32_t>(cellOf(x[i], y[i], z[i]));
+		}
+	}, 1 << 16);
+
+	size_t cells = cellCount();
+	cellStarts.assign(cells + 1, 0);
+	items.resize(count);
+	if (workerCount() == 1 || count < PARALLEL_MIN_POINTS) {
+		for (size_t i = 0; i < count; ++i) {
+			++cellStarts[cellOfItem[i] + 1];
+		}
+		for (size_t c = 1; c < cellStarts.size(); ++c) {
+			cellStarts[c] += cellStarts[c - 1];
+		}
+		std::vector<uint32_t> cursor(cellStarts.begin(), cellStarts.end() - 1);
+		for (size_t i = 0; i < count; ++i) {
+			items[cursor[cellOfItem[i]]++] = static_cast<uint32_t>(i);
+		}
+	} else {
+		//Cell sizes and then cursors are counted with atomics, points landing in a cell in any order
+		std::unique_ptr<std::atomic<uint32_t>[]> counters(new std::atomic<uint32_t>[cells]);
+		parallelFor(cells, [&](size_t first, size_t last) {
+			for (size_t c = first; c < last; ++c) {
+				counters[c].store(0, std::memory_order_relaxed);
+			}
+		}, 1 << 16);
+		parallelFor(count, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				counters[cellOfItem[i]].fetch_add(1, std::memory_order_relaxed);
+			}
+		}, 1 << 16);
+
+		//Prefix sum in blocks: block totals, their offsets, then each block on its own
+		size_t blocks = workerCount();
+		size_t blockSize = (cells + blocks - 1) / blocks;
+		std::vector<uint32_t> blockStarts(blocks + 1, 0);
+		parallelFor(blocks, [&](size_t first, size_t last) {
+			for (size_t b = first; b < last; ++b) {
+				uint32_t total = 0;
+				for (size_t c = b * blockSize; c < std::min(cells, (b + 1) * blockSize); ++c) {
+					total += counters[c].load(std::memory_order_relaxed);
+				}
+				blockStarts[b + 1] = total;
+			}
+		});
+		for (size_t b = 1; b <= blocks; ++b) {
+			blockStarts[b] += blockStarts[b - 1];
+		}
+		parallelFor(blocks, [&](size_t first, size_t last) {
+			for (size_t b = first; b < last; ++b) {
+				uint32_t start = blockStarts[b];
+				for (size_t c = b * blockSize; c < std::min(cells, (b + 1) * blockSize); ++c) {
+					cellStarts[c] = start;
+					start += counters[c].load(std::memory_order_relaxed);
+					counters[c].store(cellStarts[c], std::memory_order_relaxed);
+				}
+			}
+		});
+		cellStarts[cells] = static_cast<uint32_t>(count);
+
+		parallelFor(count, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i) {
+				items[counters[cellOfItem[i]].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(i);
+			}
+		}, 1 << 16);
+		//Points of a cell in index order, as the serial sort leaves them
+		parallelFor(cells, [&](size_t first, size_t last) {
+			for (size_t c = first; c < last; ++c) {
+				if (cellStarts[c + 1] - cellStarts[c] > 1) {
+					std::sort(items.begin() + cellStarts[c], items.begin() + cellStarts[c + 1]);
+				}
+			}
+		}, 1 << 16);
+	}
+
+	slotX.resize(count);
+	slotY.resize(count);
+	slotZ.resize(count);
+	parallelFor(count, [&](size_t first, size_t last) {
+		for (size_t slot = first; slot < last; ++slot) {
+			uint32_t point = items[slot];
+			slotX[slot] = x[point];
+			slotY[slot] = y[point];
+			slotZ[slot] = z[point];
+		}
+	}, 1 << 16);
+}
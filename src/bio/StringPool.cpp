@@ -0,0 +1,50 @@
+#include "bio/StringPool.h"
+
+#include <iostream>
+
+StringPool::StringPool() {
+	clear();
+}
+
+StringPool::StringPool(const StringPool &other) :
+	strings(other.strings) {
+	rebuildIds();
+}
+
+StringPool &StringPool::operator=(const StringPool &other) {
+	if (this != &other) {
+		strings = other.strings;
+		rebuildIds();
+	}
+	return *this;
+}
+
+uint16_t StringPool::intern(std::string_view string) {
+	auto found = ids.find(string);
+	if (found != ids.end()) {
+		return found->second;
+	}
+	if (strings.size() >= MAX_SIZE) {
+		std::cerr << "ERROR > Too many distinct strings, mapping to empty: " << string << "\n\n";
+		return 0;
+	}
+
+	uint16_t id = static_cast<uint16_t>(strings.size());
+	strings.emplace_back(string);
+	ids.emplace(strings.back(), id);
+	return id;
+}
+
+void StringPool::clear() {
+	ids.clear();
+	strings.clear();
+	strings.emplace_back();
+	ids.emplace(strings.back(), 0);
+}
+
+void StringPool::rebuildIds() {
+	ids.clear();
+	for (size_t i = 0; i < strings.size(); ++i) {
+		ids.emplace(strings[i], static_cast<uint16_t>(i));
+	}
+}
@@ -0,0 +1,329 @@
+#include "bio/Superposition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include "bio/Parallel.h"
+
+namespace {
+
+constexpr double EIGENVALUE_PRECISION = 1e-11;
+constexpr double EIGENVECTOR_PRECISION = 1e-6;
+constexpr int MAX_NEWTON_STEPS = 50;
+
+//Covariance sums: float partial sums in COVARIANCE_LANES independent lanes per term, flushed to double every
+//COVARIANCE_BLOCK atoms. The lanes carry no dependency from one atom to the next, so the products map onto SIMD
+//registers without reassociating a single sum, and the short blocks keep the float rounding error small
+constexpr size_t COVARIANCE_LANES = 8;
+constexpr size_t COVARIANCE_BLOCK = 256;
+
+/*
+RMSD and rotation from the covariance s (s[3 * a + b] = sum of mobile a times
+reference b over the centered atoms) and the squared norms of both sets.
+The rotation turns the centered mobile atoms onto the centered reference.
+*/
+void solveQCP(const double s[9], double mobileNorm, double referenceNorm, size_t count, Superposition &result) {
+	double sxx = s[0], sxy = s[1], sxz = s[2];
+	double syx = s[3], syy = s[4], syz = s[5];
+	double szx = s[6], szy = s[7], szz = s[8];
+
+	double sxx2 = sxx * sxx, syy2 = syy * syy, szz2 = szz * szz;
+	double sxy2 = sxy * sxy, syz2 = syz * syz, sxz2 = sxz * sxz;
+	double syx2 = syx * syx, szy2 = szy * szy, szx2 = szx * szx;
+
+	double syzSzymSyySzz2 = 2.0 * (syz * szy - syy * szz);
+	double sxx2Syy2Szz2Syz2Szy2 = syy2 + szz2 - sxx2 + syz2 + szy2;
+	double sxy2Sxz2Syx2Szx2 = sxy2 + sxz2 - syx2 - szx2;
+
+	double sxzpSzx = sxz + szx, syzpSzy = syz + szy, sxypSyx = sxy + syx;
+	double syzmSzy = syz - szy, sxzmSzx = sxz - szx, sxymSyx = sxy - syx;
+	double sxxpSyy = sxx + syy, sxxmSyy = sxx - syy;
+
+	//Characteristic polynomial of the key matrix, x^4 + c2 x^2 + c1 x + c0
+	double c2 = -2.0 * (sxx2 + syy2 + szz2 + sxy2 + syx2 + sxz2 + szx2 + syz2 + szy2);
+	double c1 = 8.0 * (sxx * syz * szy + syy * szx * sxz + szz * sxy * syx -
+		sxx * syy * szz - syz * szx * sxy - szy * syx * sxz);
+	double c0 = sxy2Sxz2Syx2Szx2 * sxy2Sxz2Syx2Szx2 +
+		(sxx2Syy2Szz2Syz2Szy2 + syzSzymSyySzz2) * (sxx2Syy2Szz2Syz2Szy2 - syzSzymSyySzz2) +
+		(-sxzpSzx * syzmSzy + sxymSyx * (sxxmSyy - szz)) * (-sxzmSzx * syzpSzy + sxymSyx * (sxxmSyy + szz)) +
+		(-sxzpSzx * syzpSzy - sxypSyx * (sxxpSyy - szz)) * (-sxzmSzx * syzmSzy - sxypSyx * (sxxpSyy + szz)) +
+		(sxypSyx * syzpSzy + sxzpSzx * (sxxmSyy + szz)) * (-sxymSyx * syzmSzy + sxzpSzx * (sxxpSyy + szz)) +
+		(sxypSyx * syzmSzy + sxzmSzx * (sxxmSyy - szz)) * (-sxymSyx * syzpSzy + sxzmSzx * (sxxpSyy - szz));
+
+	//Largest root, Newton from the upper bound (G1 + G2) / 2
+	double e0 = 0.5 * (mobileNorm + referenceNorm);
+	double lambda = e0;
+	for (int i = 0; i < MAX_NEWTON_STEPS; ++i) {
+		double previous = lambda;
+		double x2 = lambda * lambda;
+		double b = (x2 + c2) * lambda;
+		double a = b + c1;
+		double denominator = 2.0 * x2 * lambda + b + a;
+		if (denominator == 0.0) {
+			break;
+		}
+		lambda -= (a * lambda + c0) / denominator;
+		if (std::abs(lambda - previous) < std::abs(EIGENVALUE_PRECISION * lambda)) {
+			break;
+		}
+	}
+	result.rmsd = static_cast<float>(std::sqrt(std::max(0.0, 2.0 * (e0 - lambda) / count)));
+
+	//Eigenvector of lambda from the adjoint of (key matrix - lambda), trying other columns when degenerate
+	double a11 = sxxpSyy + szz - lambda, a12 = syzmSzy, a13 = -sxzmSzx, a14 = sxymSyx;
+	double a21 = syzmSzy, a22 = sxxmSyy - szz - lambda, a23 = sxypSyx, a24 = sxzpSzx;
+	double a31 = a13, a32 = a23, a33 = syy - sxx - szz - lambda, a34 = syzpSzy;
+	double a41 = a14, a42 = a24, a43 = a34, a44 = szz - sxxpSyy - lambda;
+	double a3344_4334 = a33 * a44 - a43 * a34, a3244_4234 = a32 * a44 - a42 * a34;
+	double a3243_4233 = a32 * a43 - a42 * a33, a3143_4133 = a31 * a43 - a41 * a33;
+	double a3144_4134 = a31 * a44 - a41 * a34, a3142_4132 = a31 * a42 - a41 * a32;
+
+	double q1 = a22 * a3344_4334 - a23 * a3244_4234 + a24 * a3243_4233;
+	double q2 = -a21 * a3344_4334 + a23 * a3144_4134 - a24 * a3143_4133;
+	double q3 = a21 * a3244_4234 - a22 * a3144_4134 + a24 * a3142_4132;
+	double q4 = -a21 * a3243_4233 + a22 * a3143_4133 - a23 * a3142_4132;
+	double norm = q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4;
+
+	if (norm < EIGENVECTOR_PRECISION) {
+		q1 = a12 * a3344_4334 - a13 * a3244_4234 + a14 * a3243_4233;
+		q2 = -a11 * a3344_4334 + a13 * a3144_4134 - a14 * a3143_4133;
+		q3 = a11 * a3244_4234 - a12 * a3144_4134 + a14 * a3142_4132;
+		q4 = -a11 * a3243_4233 + a12 * a3143_4133 - a13 * a3142_4132;
+		norm = q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4;
+	}
+	if (norm < EIGENVECTOR_PRECISION) {
+		double a1324_1423 = a13 * a24 - a14 * a23, a1224_1422 = a12 * a24 - a14 * a22;
+		double a1223_1322 = a12 * a23 - a13 * a22, a1124_1421 = a11 * a24 - a14 * a21;
+		double a1123_1321 = a11 * a23 - a13 * a21, a1122_1221 = a11 * a22 - a12 * a21;
+		q1 = a42 * a1324_1423 - a43 * a1224_1422 + a44 * a1223_1322;
+		q2 = -a41 * a1324_1423 + a43 * a1124_1421 - a44 * a1123_1321;
+		q3 = a41 * a1224_1422 - a42 * a1124_1421 + a44 * a1122_1221;
+		q4 = -a41 * a1223_1322 + a42 * a1123_1321 - a43 * a1122_1221;
+		norm = q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4;
+		if (norm < EIGENVECTOR_PRECISION) {
+			q1 = a32 * a1324_1423 - a33 * a1224_1422 + a34 * a1223_1322;
+			q2 = -a31 * a1324_1423 + a33 * a1124_1421 - a34 * a1123_1321;
+			q3 = a31 * a1224_1422 - a32 * a1124_1421 + a34 * a1122_1221;
+			q4 = -a31 * a1223_1322 + a32 * a1123_1321 - a33 * a1122_1221;
+			norm = q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4;
+		}
+	}
+	if (norm < EIGENVECTOR_PRECISION) {
+		//Already superposed, or too few atoms to define a rotation
+		result.rotation = glm::mat3(1.0f);
+		return;
+	}
+
+	double length = std::sqrt(norm);
+	q1 /= length;
+	q2 /= length;
+	q3 /= length;
+	q4 /= length;
+	double a2 = q1 * q1, x2 = q2 * q2, y2 = q3 * q3, z2 = q4 * q4;
+	double xy = q2 * q3, az = q1 * q4, zx = q4 * q2, ay = q1 * q3, yz = q3 * q4, ax = q1 * q2;
+
+	//The quaternion's matrix turns the reference onto the mobile atoms, store its transpose
+	//(glm indexes [column][row])
+	glm::mat3 &r = result.rotation;
+	r[0][0] = static_cast<float>(a2 + x2 - y2 - z2);
+	r[0][1] = static_cast<float>(2.0 * (xy + az));
+	r[0][2] = static_cast<float>(2.0 * (zx - ay));
+	r[1][0] = static_cast<float>(2.0 * (xy - az));
+	r[1][1] = static_cast<float>(a2 - x2 + y2 - z2);
+	r[1][2] = static_cast<float>(2.0 * (yz + ax));
+	r[2][0] = static_cast<float>(2.0 * (zx + ay));
+	r[2][1] = static_cast<float>(2.0 * (yz - ax));
+	r[2][2] = static_cast<float>(a2 - x2 - y2 + z2);
+}
+
+}
+
+void Superposition::apply(const float *in, float *out, size_t count) const {
+	parallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			glm::vec3 position = rotation * (glm::vec3(in[3 * i], in[3 * i + 1], in[3 * i + 2]) - mobileCenter) + referenceCenter;
+			out[3 * i] = position.x;
+			out[3 * i + 1] = position.y;
+			out[3 * i + 2] = position.z;
+		}
+	}, 1 << 15);
+}
+
+Superposer::Superposer(const float *referenceXyz, size_t atomCount, std::vector<uint32_t> fitAtoms) :
+	fitAtoms(std::move(fitAtoms)) {
+	size_t count = this->fitAtoms.empty() ? atomCount : this->fitAtoms.size();
+	std::vector<float> x(count), y(count), z(count);
+	for (size_t k = 0; k < count; ++k) {
+		size_t atom = this->fitAtoms.empty() ? k : this->fitAtoms[k];
+		x[k] = referenceXyz[3 * atom];
+		y[k] = referenceXyz[3 * atom + 1];
+		z[k] = referenceXyz[3 * atom + 2];
+	}
+	setReference(x, y, z);
+}
+
+Superposer::Superposer(const AtomTable &reference, std::vector<uint32_t> fitAtoms) :
+	fitAtoms(std::move(fitAtoms)) {
+	size_t count = this->fitAtoms.empty() ? reference.size() : this->fitAtoms.size();
+	std::vector<float> x(count), y(count), z(count);
+	for (size_t k = 0; k < count; ++k) {
+		size_t atom = this->fitAtoms.empty() ? k : this->fitAtoms[k];
+		x[k] = reference.x[atom];
+		y[k] = reference.y[atom];
+		z[k] = reference.z[atom];
+	}
+	setReference(x, y, z);
+}
+
+void Superposer::setReference(const std::vector<float> &x, const std::vector<float> &y, const std::vector<float> &z) {
+	size_t count = x.size();
+	double sx = 0.0, sy = 0.0, sz = 0.0;
+	for (size_t k = 0; k < count; ++k) {
+		sx += x[k];
+		sy += y[k];
+		sz += z[k];
+	}
+	double scale = count ? 1.0 / count : 0.0;
+	referenceCenter = glm::vec3(static_cast<float>(sx * scale), static_cast<float>(sy * scale), static_cast<float>(sz * scale));
+
+	referenceX.resize(count);
+	referenceY.resize(count);
+	referenceZ.resize(count);
+	referenceNorm = 0.0;
+	for (size_t k = 0; k < count; ++k) {
+		referenceX[k] = x[k] - referenceCenter.x;
+		referenceY[k] = y[k] - referenceCenter.y;
+		referenceZ[k] = z[k] - referenceCenter.z;
+		referenceNorm += static_cast<double>(referenceX[k]) * referenceX[k] +
+			static_cast<double>(referenceY[k]) * referenceY[k] + static_cast<double>(referenceZ[k]) * referenceZ[k];
+	}
+}
+
+Superposition Superposer::fit(const float *xyz) const {
+	Superposition result;
+	result.referenceCenter = referenceCenter;
+	size_t count = referenceX.size();
+	if (count == 0) {
+		return result;
+	}
+
+	//Fitted atoms into contiguous arrays, so the loops below run over plain float columns
+	thread_local std::vector<float> mobileX, mobileY, mobileZ;
+	mobileX.resize(count);
+	mobileY.resize(count);
+	mobileZ.resize(count);
+	double sx = 0.0, sy = 0.0, sz = 0.0;
+	for (size_t k = 0; k < count; ++k) {
+		size_t atom = fitAtoms.empty() ? k : fitAtoms[k];
+		mobileX[k] = xyz[3 * atom];
+		mobileY[k] = xyz[3 * atom + 1];
+		mobileZ[k] = xyz[3 * atom + 2];
+		sx += mobileX[k];
+		sy += mobileY[k];
+		sz += mobileZ[k];
+	}
+	result.mobileCenter = glm::vec3(static_cast<float>(sx / count), static_cast<float>(sy / count), static_cast<float>(sz / count));
+
+	//Covariance and norm of the centered atoms, the reference is already centered
+	float cx = result.mobileCenter.x, cy = result.mobileCenter.y, cz = result.mobileCenter.z;
+	double s[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+	double mobileNorm = 0.0;
+	const float *rx = referenceX.data(), *ry = referenceY.data(), *rz = referenceZ.data();
+	const float *mx = mobileX.data(), *my = mobileY.data(), *mz = mobileZ.data();
+	size_t k = 0;
+	while (k + COVARIANCE_LANES <= count) {
+		//Whole rows of lanes only, COVARIANCE_BLOCK being a multiple of COVARIANCE_LANES
+		size_t blockEnd = std::min(count - count % COVARIANCE_LANES, k + COVARIANCE_BLOCK);
+		//Nine covariance terms, then the mobile norm
+		float partial[10][COVARIANCE_LANES] = {};
+		for (; k < blockEnd; k += COVARIANCE_LANES) {
+			for (size_t lane = 0; lane < COVARIANCE_LANES; ++lane) {
+				float x = mx[k + lane] - cx, y = my[k + lane] - cy, z = mz[k + lane] - cz;
+				partial[0][lane] += x * rx[k + lane];
+				partial[1][lane] += x * ry[k + lane];
+				partial[2][lane] += x * rz[k + lane];
+				partial[3][lane] += y * rx[k + lane];
+				partial[4][lane] += y * ry[k + lane];
+				partial[5][lane] += y * rz[k + lane];
+				partial[6][lane] += z * rx[k + lane];
+				partial[7][lane] += z * ry[k + lane];
+				partial[8][lane] += z * rz[k + lane];
+				partial[9][lane] += x * x + y * y + z * z;
+			}
+		}
+		for (size_t lane = 0; lane < COVARIANCE_LANES; ++lane) {
+			for (int term = 0; term < 9; ++term) {
+				s[term] += partial[term][lane];
+			}
+			mobileNorm += partial[9][lane];
+		}
+	}
+	//Atoms left over after the last whole row of lanes
+	for (; k < count; ++k) {
+		double x = mx[k] - cx, y = my[k] - cy, z = mz[k] - cz;
+		s[0] += x * rx[k];
+		s[1] += x * ry[k];
+		s[2] += x * rz[k];
+		s[3] += y * rx[k];
+		s[4] += y * ry[k];
+		s[5] += y * rz[k];
+		s[6] += z * rx[k];
+		s[7] += z * ry[k];
+		s[8] += z * rz[k];
+		mobileNorm += x * x + y * y + z * z;
+	}
+
+	solveQCP(s, mobileNorm, referenceNorm, count, result);
+	return result;
+}
+
+std::vector<Superposition> Superposer::fitFrames(FrameSource &source, size_t batchSize) const {
+	size_t frameCount = source.frameCount();
+	size_t atomCount = source.atomCount();
+	std::vector<Superposition> results(frameCount);
+	if (batchSize == 0) {
+		batchSize = workerCount();
+	}
+	batchSize = std::max<size_t>(1, std::min(batchSize, frameCount));
+
+	std::vector<std::vector<float>> buffers(batchSize, std::vector<float>(3 * atomCount));
+	std::vector<float *> outputs(batchSize);
+	std::vector<size_t> frames(batchSize);
+	std::unique_ptr<bool[]> success(new bool[batchSize]);
+	for (size_t i = 0; i < batchSize; ++i) {
+		outputs[i] = buffers[i].data();
+	}
+
+	for (size_t first = 0; first < frameCount; first += batchSize) {
+		size_t count = std::min(batchSize, frameCount - first);
+		for (size_t i = 0; i < count; ++i) {
+			frames[i] = first + i;
+		}
+		source.readFrames(frames.data(), outputs.data(), success.get(), count);
+		parallelFor(count, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				if (success[i]) {
+					results[first + i] = fit(outputs[i]);
+				}
+				else {
+					results[first + i].rmsd = std::numeric_limits<float>::quiet_NaN();
+				}
+			}
+		});
+	}
+	return results;
+}
+
+float Superposer::rmsdNoFit(const float *a, const float *b, size_t count) {
+	if (count == 0) {
+		return 0.0f;
+	}
+	double sum = 0.0;
+	for (size_t i = 0; i < 3 * count; ++i) {
+		double difference = a[i] - b[i];
+		sum += difference * difference;
+	}
+	return static_cast<float>(std::sqrt(sum / count));
+}
@@ -0,0 +1,129 @@
+#include "bio/TRRFile.h"
+
+#include <iostream>
+
+namespace {
+
+constexpr uint32_t TRR_MAGIC = 1993;
+
+//magic, version string length, XDR string "GMX_trn_file"
+constexpr size_t VERSION_SIZE = 24;
+//ir, e, box, vir, pres, top, sym, x, v, f sizes, natoms, step, nre
+constexpr size_t INT_FIELDS = 13;
+
+constexpr float NM_TO_ANGSTROM = 10.0f;
+
+struct FrameHeader {
+	uint32_t irSize;
+	uint32_t eSize;
+	uint32_t boxSize;
+	uint32_t virSize;
+	uint32_t presSize;
+	uint32_t topSize;
+	uint32_t symSize;
+	uint32_t xSize;
+	uint32_t vSize;
+	uint32_t fSize;
+	uint32_t natoms;
+	size_t realSize; //4 or 8
+	size_t headerSize;
+	size_t xOffset; //From the frame start
+	size_t frameSize;
+};
+
+//False if the header is malformed or doesn't fit in size bytes
+bool readHeader(const char *data, size_t size, FrameHeader &header) {
+	if (size < VERSION_SIZE + 4 * INT_FIELDS || bigEndian32(data) != TRR_MAGIC) {
+		return false;
+	}
+	const char *fields = data + VERSION_SIZE;
+	header.irSize = bigEndian32(fields);
+	header.eSize = bigEndian32(fields + 4);
+	header.boxSize = bigEndian32(fields + 8);
+	header.virSize = bigEndian32(fields + 12);
+	header.presSize = bigEndian32(fields + 16);
+	header.topSize = bigEndian32(fields + 20);
+	header.symSize = bigEndian32(fields + 24);
+	header.xSize = bigEndian32(fields + 28);
+	header.vSize = bigEndian32(fields + 32);
+	header.fSize = bigEndian32(fields + 36);
+	header.natoms = bigEndian32(fields + 40);
+
+	//Precision follows from whichever block is present
+	size_t realSize = 0;
+	if (header.boxSize) {
+		realSize = header.boxSize / 9;
+	}
+	else if (header.natoms && (header.xSize || header.vSize || header.fSize)) {
+		uint32_t blockSize = header.xSize ? header.xSize : header.vSize ? header.vSize : header.fSize;
+		realSize = blockSize / (3 * header.natoms);
+	}
+	if (realSize != 4 && realSize != 8) {
+		return false;
+	}
+	header.realSize = realSize;
+	//time and lambda are reals
+	header.headerSize = VERSION_SIZE + 4 * INT_FIELDS + 2 * realSize;
+	//Blocks follow in the order of their sizes, GROMACS writes ir, e, top and sym empty but counts them when skipping
+	header.xOffset = header.headerSize + static_cast<size_t>(header.irSize) + header.eSize + header.boxSize +
+		header.virSize + header.presSize + header.topSize + header.symSize;
+	header.frameSize = header.xOffset + static_cast<size_t>(header.xSize) + header.vSize + header.fSize;
+	return header.frameSize <= size;
+}
+
+}
+
+TRRFile::TRRFile(const std::string &path) :
+	TrajectoryFile(path) {
+	if (!file.isOpen() || loadIndex(path)) {
+		return;
+	}
+	buildIndex();
+	saveIndex(path);
+}
+
+void TRRFile::buildIndex() {
+	size_t position = 0;
+	size_t end = 0;
+	while (position < file.size()) {
+		FrameHeader header;
+		if (!readHeader(file.data() + position, file.size() - position, header)) {
+			std::cerr << "ERROR > Unreadable TRR frame at byte " << position << ", ignoring the rest of the file\n\n";
+			break;
+		}
+		if (header.xSize) {
+			if (frameOffsets.empty()) {
+				atoms = header.natoms;
+			}
+			else if (header.natoms != atoms) {
+				std::cerr << "ERROR > TRR frame at byte " << position << " has " << header.natoms << " atoms, expected " << atoms << "\n\n";
+				break;
+			}
+			frameOffsets.push_back(position);
+		}
+		position += header.frameSize;
+		end = position;
+	}
+	if (!frameOffsets.empty()) {
+		frameOffsets.push_back(end);
+	}
+}
+
+bool TRRFile::decodeFrame(const char *data, size_t size, float *xyz) const {
+	FrameHeader header;
+	if (!readHeader(data, size, header) || header.natoms != atoms || header.xSize != 3 * atoms * header.realSize) {
+		return false;
+	}
+	const char *x = data + header.xOffset;
+	if (header.realSize == 8) {
+		for (size_t i = 0; i < 3 * atoms; ++i) {
+			xyz[i] = static_cast<float>(bigEndianDouble(x + 8 * i)) * NM_TO_ANGSTROM;
+		}
+	}
+	else {
+		for (size_t i = 0; i < 3 * atoms; ++i) {
+			xyz[i] = bigEndianFloat(x + 4 * i) * NM_TO_ANGSTROM;
+		}
+	}
+	return true;
+}
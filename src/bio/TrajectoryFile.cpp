@@ -0,0 +1,100 @@
+#include "bio/TrajectoryFile.h"
+
+#include <fstream>
+
+#include "bio/Parallel.h"
+
+namespace {
+
+//Bumped whenever a reader finds frames differently, so indexes of older versions are rebuilt
+const char INDEX_MAGIC[8] = {'D', 'L', 'F', 'R', 'I', 'D', 'X', '2'};
+
+struct IndexHeader {
+	char magic[8];
+	uint64_t fileSize;
+	uint64_t atoms;
+	uint64_t frames;
+};
+
+std::string indexPath(const std::string &path) {
+	return path + ".offsets";
+}
+
+}
+
+TrajectoryFile::TrajectoryFile(const std::string &path) :
+	file(path) {}
+
+bool TrajectoryFile::loadIndex(const std::string &path) {
+	std::ifstream in(indexPath(path), std::ios::binary);
+	IndexHeader header;
+	if (!in || !in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+		std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.fileSize != file.size()) {
+		return false;
+	}
+
+	//A stale or corrupt index is rescanned: every frame takes at least a byte, and an atom at least a bit of it
+	if (header.frames == 0 || header.frames >= file.size() || header.atoms == 0 || header.atoms / 8 >= file.size()) {
+		return false;
+	}
+	in.seekg(0, std::ios::end);
+	if (static_cast<uint64_t>(in.tellg()) != sizeof(header) + (header.frames + 1) * sizeof(uint64_t)) {
+		return false;
+	}
+	in.seekg(sizeof(header));
+
+	std::vector<uint64_t> offsets(header.frames + 1);
+	if (!in.read(reinterpret_cast<char *>(offsets.data()), offsets.size() * sizeof(uint64_t)) ||
+		offsets.back() > file.size()) {
+		return false;
+	}
+	for (size_t i = 1; i < offsets.size(); ++i) {
+		if (offsets[i] <= offsets[i - 1]) {
+			return false;
+		}
+	}
+	frameOffsets.swap(offsets);
+	atoms = static_cast<size_t>(header.atoms);
+	return true;
+}
+
+void TrajectoryFile::saveIndex(const std::string &path) const {
+	if (frameOffsets.empty()) {
+		return;
+	}
+	//Read-only locations just rebuild the index every time
+	std::ofstream out(indexPath(path), std::ios::binary | std::ios::trunc);
+	if (!out) {
+		return;
+	}
+	IndexHeader header;
+	std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.fileSize = file.size();
+	header.atoms = atoms;
+	header.frames = frameOffsets.size() - 1;
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char *>(frameOffsets.data()), frameOffsets.size() * sizeof(uint64_t));
+}
+
+size_t TrajectoryFile::frameCount() const {
+	return frameOffsets.empty() ? 0 : frameOffsets.size() - 1;
+}
+
+size_t TrajectoryFile::atomCount() const {
+	return atoms;
+}
+
+bool TrajectoryFile::readFrame(size_t index, float *xyz) {
+	if (index >= frameCount()) {
+		return false;
+	}
+	return decodeFrame(file.data() + frameOffsets[index], frameOffsets[index + 1] - frameOffsets[index], xyz);
+}
+
+void TrajectoryFile::readFrames(const size_t *frames, float *const *outputs, bool *results, size_t count) {
+	parallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			results[i] = readFrame(frames[i], outputs[i]);
+		}
+	});
+}
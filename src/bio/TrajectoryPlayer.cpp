@@ -0,0 +1,117 @@
+#include "bio/TrajectoryPlayer.h"
+
+TrajectoryPlayer::TrajectoryPlayer(std::unique_ptr<FrameSource> source, size_t prefetchCount) :
+	source(std::move(source)), slots(prefetchCount + 1) {
+	for (Slot &slot : slots) {
+		slot.xyz.resize(3 * this->source->atomCount());
+	}
+	worker = std::thread(&TrajectoryPlayer::prefetchLoop, this);
+}
+
+TrajectoryPlayer::~TrajectoryPlayer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+size_t TrajectoryPlayer::frameCount() const {
+	return source->frameCount();
+}
+
+size_t TrajectoryPlayer::atomCount() const {
+	return source->atomCount();
+}
+
+size_t TrajectoryPlayer::prefetchCount() const {
+	return slots.size() - 1;
+}
+
+const float *TrajectoryPlayer::frame(size_t index) {
+	if (index >= frameCount()) {
+		return nullptr;
+	}
+	std::unique_lock<std::mutex> lock(mutex);
+	current = index;
+	wake.notify_one();
+	decoded.wait(lock, [&] {
+		Slot *slot = findSlot(index);
+		return slot && slot->state != DECODING;
+	});
+	Slot *slot = findSlot(index);
+	return slot->state == READY ? slot->xyz.data() : nullptr;
+}
+
+const float *TrajectoryPlayer::tryFrame(size_t index) {
+	if (index >= frameCount()) {
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	current = index;
+	wake.notify_one();
+	Slot *slot = findSlot(index);
+	return slot && slot->state == READY ? slot->xyz.data() : nullptr;
+}
+
+void TrajectoryPlayer::prefetchLoop() {
+	size_t count = frameCount();
+	std::vector<size_t> frames;
+	std::vector<Slot *> targets;
+	std::vector<float *> outputs;
+	std::unique_ptr<bool[]> results(new bool[slots.size()]);
+	std::unique_lock<std::mutex> lock(mutex);
+	while (running) {
+		//Frames of the window no slot holds yet, nearest to current first, each paired with a slot outside the window
+		frames.clear();
+		targets.clear();
+		for (size_t k = 0; k < slots.size() && k < count; ++k) {
+			size_t frame = (current + k) % count;
+			if (findSlot(frame)) {
+				continue;
+			}
+			for (Slot &slot : slots) {
+				if (slot.state == EMPTY || (slot.state != DECODING && !inWindow(slot.frame))) {
+					slot.frame = frame;
+					slot.state = DECODING;
+					frames.push_back(frame);
+					targets.push_back(&slot);
+					break;
+				}
+			}
+		}
+		if (frames.empty()) {
+			wake.wait(lock);
+			continue;
+		}
+
+		outputs.clear();
+		for (Slot *slot : targets) {
+			outputs.push_back(slot->xyz.data());
+		}
+		lock.unlock();
+		//Random-access sources decode the batch in parallel
+		source->readFrames(frames.data(), outputs.data(), results.get(), frames.size());
+		lock.lock();
+
+		for (size_t i = 0; i < targets.size(); ++i) {
+			targets[i]->state = results[i] ? READY : FAILED;
+		}
+		decoded.notify_all();
+	}
+}
+
+TrajectoryPlayer::Slot *TrajectoryPlayer::findSlot(size_t frame) {
+	for (Slot &slot : slots) {
+		if (slot.state != EMPTY && slot.frame == frame) {
+			return &slot;
+		}
+	}
+	return nullptr;
+}
+
+bool TrajectoryPlayer::inWindow(size_t frame) const {
+	size_t count = source->frameCount();
+	return (frame + count - current) % count < slots.size();
+}
@@ -0,0 +1,319 @@
+#include "bio/XTCFile.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+constexpr uint32_t XTC_MAGIC = 1995;
+//GROMACS 2023 frames with a 64-bit compressed size
+constexpr uint32_t XTC_MAGIC_64 = 2023;
+
+//magic, natoms, step, time, box, natoms again
+constexpr size_t HEADER_SIZE = 56;
+//Atom counts up to this are stored as plain floats
+constexpr uint32_t MAX_UNCOMPRESSED = 9;
+
+constexpr float NM_TO_ANGSTROM = 10.0f;
+
+//Ranges of the small deltas between neighbouring atoms, indexed by bit count
+constexpr int MAGIC_INTS[] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 10, 12, 16, 20, 25, 32, 40, 50, 64,
+	80, 101, 128, 161, 203, 256, 322, 406, 512, 645, 812, 1024, 1290,
+	1625, 2048, 2580, 3250, 4096, 5060, 6501, 8192, 10321, 13003,
+	16384, 20642, 26007, 32768, 41285, 52015, 65536, 82570, 104031,
+	131072, 165140, 208063, 262144, 330280, 416127, 524287, 660561,
+	832255, 1048576, 1321122, 1664510, 2097152, 2642245, 3329021,
+	4194304, 5284491, 6658042, 8388607, 10568983, 13316085, 16777216
+};
+constexpr int FIRST_INDEX = 9;
+constexpr int LAST_INDEX = sizeof(MAGIC_INTS) / sizeof(MAGIC_INTS[0]) - 1;
+
+size_t padded(uint64_t size) {
+	return static_cast<size_t>((size + 3) & ~uint64_t(3));
+}
+
+//Bits needed for values below size
+int bitsForInt(uint32_t size) {
+	int bits = 0;
+	uint64_t num = 1;
+	while (size >= num && bits < 32) {
+		++bits;
+		num <<= 1;
+	}
+	return bits;
+}
+
+//Bits needed for three values packed as one mixed-radix number
+int bitsForInts(const uint32_t sizes[3]) {
+	uint32_t bytes[32] = {1};
+	int byteCount = 1;
+	for (int i = 0; i < 3; ++i) {
+		uint64_t carry = 0;
+		int b = 0;
+		for (; b < byteCount; ++b) {
+			carry += static_cast<uint64_t>(bytes[b]) * sizes[i];
+			bytes[b] = carry & 0xFF;
+			carry >>= 8;
+		}
+		while (carry) {
+			bytes[b++] = carry & 0xFF;
+			carry >>= 8;
+		}
+		byteCount = b;
+	}
+	int bits = 0;
+	uint32_t num = 1;
+	--byteCount;
+	while (bytes[byteCount] >= num) {
+		++bits;
+		num *= 2;
+	}
+	return bits + byteCount * 8;
+}
+
+//Bit stream of the compressed coordinates, reads past the end yield zeros and set overrun
+struct BitReader {
+	const unsigned char *data;
+	size_t size;
+	size_t position = 0;
+	int lastBits = 0;
+	uint32_t lastByte = 0;
+	bool overrun = false;
+
+	unsigned char nextByte() {
+		if (position < size) {
+			return data[position++];
+		}
+		overrun = true;
+		return 0;
+	}
+
+	uint32_t bits(int count) {
+		uint64_t mask = (uint64_t(1) << count) - 1;
+		uint64_t num = 0;
+		while (count >= 8) {
+			lastByte = (lastByte << 8) | nextByte();
+			num |= static_cast<uint64_t>(lastByte >> lastBits) << (count - 8);
+			count -= 8;
+		}
+		if (count > 0) {
+			if (lastBits < count) {
+				lastBits += 8;
+				lastByte = (lastByte << 8) | nextByte();
+			}
+			lastBits -= count;
+			num |= (lastByte >> lastBits) & ((1u << count) - 1);
+		}
+		return static_cast<uint32_t>(num & mask);
+	}
+
+	//Unpacks three values stored as one mixed-radix number of bitCount bits
+	void ints(int bitCount, const uint32_t sizes[3], int values[3]) {
+		uint32_t bytes[32] = {0};
+		int byteCount = 0;
+		while (bitCount > 8) {
+			bytes[byteCount++] = bits(8);
+			bitCount -= 8;
+		}
+		if (bitCount > 0) {
+			bytes[byteCount++] = bits(bitCount);
+		}
+		for (int i = 2; i > 0; --i) {
+			uint32_t num = 0;
+			for (int b = byteCount - 1; b >= 0; --b) {
+				num = (num << 8) | bytes[b];
+				uint32_t quotient = num / sizes[i];
+				bytes[b] = quotient;
+				num -= quotient * sizes[i];
+			}
+			values[i] = static_cast<int>(num);
+		}
+		values[0] = static_cast<int>(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24));
+	}
+};
+
+}
+
+XTCFile::XTCFile(const std::string &path) :
+	TrajectoryFile(path) {
+	if (!file.isOpen() || loadIndex(path)) {
+		return;
+	}
+	buildIndex();
+	saveIndex(path);
+}
+
+void XTCFile::buildIndex() {
+	const char *data = file.data();
+	size_t size = file.size();
+	size_t position = 0;
+	while (position + HEADER_SIZE <= size) {
+		uint32_t magic = bigEndian32(data + position);
+		uint32_t natoms = bigEndian32(data + position + 4);
+		if (magic != XTC_MAGIC && magic != XTC_MAGIC_64) {
+			std::cerr << "ERROR > Not an XTC frame at byte " << position << "\n\n";
+			break;
+		}
+		if (frameOffsets.empty()) {
+			atoms = natoms;
+		}
+		else if (natoms != atoms) {
+			std::cerr << "ERROR > XTC frame " << frameOffsets.size() << " has " << natoms << " atoms, expected " << atoms << "\n\n";
+			break;
+		}
+
+		size_t frameSize = HEADER_SIZE + 12 * static_cast<size_t>(natoms);
+		if (natoms > MAX_UNCOMPRESSED) {
+			//precision, minint[3], maxint[3], smallidx, then the byte count
+			size_t countPosition = position + HEADER_SIZE + 32;
+			size_t countSize = magic == XTC_MAGIC_64 ? 8 : 4;
+			if (countPosition + countSize > size) {
+				break;
+			}
+			uint64_t byteCount = magic == XTC_MAGIC_64 ?
+				static_cast<uint64_t>(bigEndian32(data + countPosition)) << 32 | bigEndian32(data + countPosition + 4) :
+				bigEndian32(data + countPosition);
+			frameSize = HEADER_SIZE + 32 + countSize + padded(byteCount);
+		}
+		if (position + frameSize > size) {
+			std::cerr << "ERROR > XTC file ends inside frame " << frameOffsets.size() << ", ignoring it\n\n";
+			break;
+		}
+		frameOffsets.push_back(position);
+		position += frameSize;
+	}
+	if (!frameOffsets.empty()) {
+		frameOffsets.push_back(position);
+	}
+}
+
+bool XTCFile::decodeFrame(const char *data, size_t size, float *xyz) const {
+	if (size < HEADER_SIZE || bigEndian32(data + 4) != atoms) {
+		return false;
+	}
+	uint32_t magic = bigEndian32(data);
+	size_t count = atoms;
+
+	if (count <= MAX_UNCOMPRESSED) {
+		for (size_t i = 0; i < 3 * count; ++i) {
+			xyz[i] = bigEndianFloat(data + HEADER_SIZE + 4 * i) * NM_TO_ANGSTROM;
+		}
+		return true;
+	}
+
+	const char *cursor = data + HEADER_SIZE;
+	float precision = bigEndianFloat(cursor);
+	int minInt[3], maxInt[3];
+	for (int k = 0; k < 3; ++k) {
+		minInt[k] = static_cast<int>(bigEndian32(cursor + 4 + 4 * k));
+		maxInt[k] = static_cast<int>(bigEndian32(cursor + 16 + 4 * k));
+	}
+	int smallIndex = static_cast<int>(bigEndian32(cursor + 28));
+	cursor += magic == XTC_MAGIC_64 ? 40 : 36;
+	if (precision <= 0.0f || smallIndex < FIRST_INDEX || smallIndex > LAST_INDEX) {
+		return false;
+	}
+
+	uint32_t sizeInt[3];
+	int bitSizeInt[3] = {0, 0, 0};
+	for (int k = 0; k < 3; ++k) {
+		sizeInt[k] = static_cast<uint32_t>(maxInt[k] - minInt[k]) + 1;
+	}
+	//Large ranges are stored one coordinate at a time
+	int bitSize = 0;
+	if ((sizeInt[0] | sizeInt[1] | sizeInt[2]) > 0xFFFFFF) {
+		for (int k = 0; k < 3; ++k) {
+			bitSizeInt[k] = bitsForInt(sizeInt[k]);
+		}
+	}
+	else {
+		bitSize = bitsForInts(sizeInt);
+	}
+
+	int smaller = MAGIC_INTS[std::max(FIRST_INDEX, smallIndex - 1)] / 2;
+	int smallNum = MAGIC_INTS[smallIndex] / 2;
+	uint32_t sizeSmall[3];
+	std::fill(sizeSmall, sizeSmall + 3, static_cast<uint32_t>(MAGIC_INTS[smallIndex]));
+
+	BitReader reader{reinterpret_cast<const unsigned char *>(cursor), size - static_cast<size_t>(cursor - data)};
+	float scale = NM_TO_ANGSTROM / precision;
+	float *out = xyz;
+	float *outEnd = xyz + 3 * count;
+	auto emit = [&](const int coords[3]) {
+		if (out < outEnd) {
+			out[0] = coords[0] * scale;
+			out[1] = coords[1] * scale;
+			out[2] = coords[2] * scale;
+			out += 3;
+		}
+	};
+
+	size_t i = 0;
+	int run = 0;
+	while (i < count) {
+		int current[3];
+		if (bitSize == 0) {
+			for (int k = 0; k < 3; ++k) {
+				current[k] = static_cast<int>(reader.bits(bitSizeInt[k]));
+			}
+		}
+		else {
+			reader.ints(bitSize, sizeInt, current);
+		}
+		++i;
+		int previous[3];
+		for (int k = 0; k < 3; ++k) {
+			current[k] += minInt[k];
+			previous[k] = current[k];
+		}
+
+		int isSmaller = 0;
+		if (reader.bits(1)) {
+			run = static_cast<int>(reader.bits(5));
+			isSmaller = run % 3;
+			run -= isSmaller;
+			--isSmaller;
+		}
+
+		if (run > 0) {
+			//Run of atoms stored as small deltas from the previous one
+			for (int k = 0; k < run; k += 3) {
+				reader.ints(smallIndex, sizeSmall, current);
+				++i;
+				for (int c = 0; c < 3; ++c) {
+					current[c] += previous[c] - smallNum;
+				}
+				if (k == 0) {
+					//The first two atoms of a run are swapped, water compresses better with O first
+					std::swap(current[0], previous[0]);
+					std::swap(current[1], previous[1]);
+					std::swap(current[2], previous[2]);
+					emit(previous);
+				}
+				else {
+					std::copy(current, current + 3, previous);
+				}
+				emit(current);
+			}
+		}
+		else {
+			emit(current);
+		}
+
+		smallIndex += isSmaller;
+		if (smallIndex < FIRST_INDEX || smallIndex > LAST_INDEX || reader.overrun) {
+			return false;
+		}
+		if (isSmaller < 0) {
+			smallNum = smaller;
+			smaller = smallIndex > FIRST_INDEX ? MAGIC_INTS[smallIndex - 1] / 2 : 0;
+		}
+		else if (isSmaller > 0) {
+			smaller = smallNum;
+			smallNum = MAGIC_INTS[smallIndex] / 2;
+		}
+		std::fill(sizeSmall, sizeSmall + 3, static_cast<uint32_t>(MAGIC_INTS[smallIndex]));
+	}
+	return out == outEnd;
+}
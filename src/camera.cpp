@@ -124,6 +124,15 @@ void Camera::Update(float delta)
     TargetDistanceSmooth = glm::mix(TargetDistanceSmooth, TargetDistance, a);
 }
 
+bool Camera::IsSettled(float epsilon) const
+{
+    return glm::abs(Theta - ThetaSmooth) < epsilon &&
+           glm::abs(Phi - PhiSmooth) < epsilon &&
+           glm::abs(Zoom - ZoomSmooth) < epsilon &&
+           glm::abs(TargetDistance - TargetDistanceSmooth) < epsilon &&
+           glm::all(glm::lessThan(glm::abs(Target - TargetSmooth), glm::vec3(epsilon)));
+}
+
 void Camera::updateCameraVectors()
 {
     Forward.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
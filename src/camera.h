@@ -60,6 +60,9 @@ class Camera {
         // Updates the orbital smoothed values
         void Update(float delta);
 
+        // True once the smoothed values have caught up with their targets
+        bool IsSettled(float epsilon = 1e-3f) const;
+
         void Reset(glm::vec3 position, float yaw = -90, float pitch = 0, float targetDistance = 5);
 
     private:
@@ -0,0 +1,194 @@
+#include "contact_map_view.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    // Colors of the closest and the farthest contacts, interpolated on the distance over the cutoff
+    constexpr ImU32 NEAR_COLOR = IM_COL32(180, 20, 30, 255);
+    constexpr ImU32 FAR_COLOR = IM_COL32(250, 210, 120, 255);
+    constexpr ImU32 SELECTION_COLOR = IM_COL32(40, 140, 255, 255);
+    constexpr float MIN_VIEW_SIZE = 8.0f; // Residues
+
+    ImU32 contactColor(float distance, float cutoff)
+    {
+        float t = std::clamp(distance / cutoff, 0.0f, 1.0f);
+        ImVec4 near_color = ImGui::ColorConvertU32ToFloat4(NEAR_COLOR);
+        ImVec4 far_color = ImGui::ColorConvertU32ToFloat4(FAR_COLOR);
+        return ImGui::ColorConvertFloat4ToU32(ImVec4(near_color.x + (far_color.x - near_color.x) * t,
+                                                     near_color.y + (far_color.y - near_color.y) * t,
+                                                     near_color.z + (far_color.z - near_color.z) * t, 1.0f));
+    }
+
+    void residueLabel(const AtomTable &atoms, int residue, char *out, size_t size)
+    {
+        snprintf(out, size, "%s %s %d", atoms.chainName(atoms.residueChainIndices[residue]).c_str(),
+                 atoms.residueNames[atoms.residueNameIds[residue]].c_str(), atoms.residueNums[residue]);
+    }
+}
+
+void ContactMapView::render(const ContactMap &contacts, const AtomTable &atoms)
+{
+    ImGui::Begin("Contact Map", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+    float residue_count = static_cast<float>(atoms.residueCount());
+    ImGui::Text("%zu contacts under %.1f A between %zu residues", contacts.size(), contacts.cutoff,
+                atoms.residueCount());
+    if (ImGui::Button("Reset View"))
+        view_size = 0.0f;
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Selection"))
+        selected_first = selected_second = -1;
+
+    hovered_first = hovered_second = -1;
+    if (atoms.residueCount() == 0)
+    {
+        ImGui::End();
+        return;
+    }
+    if (view_size <= 0.0f || view_size > residue_count)
+    {
+        view_size = residue_count;
+        row_begin = column_begin = 0.0f;
+    }
+
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("contact_map_canvas", ImVec2(map_size, map_size),
+                           ImGuiButtonFlags_MouseButtonLeft | ImGuiButtonFlags_MouseButtonRight);
+    bool hovered = ImGui::IsItemHovered();
+    ImGuiIO &io = ImGui::GetIO();
+    float residues_per_pixel = view_size / map_size;
+
+    // Zoom around the residue pair under the cursor, pan with the right button
+    if (hovered && io.MouseWheel != 0.0f)
+    {
+        float mouse_column = column_begin + (io.MousePos.x - origin.x) * residues_per_pixel;
+        float mouse_row = row_begin + (io.MousePos.y - origin.y) * residues_per_pixel;
+        float scale = std::pow(0.85f, io.MouseWheel);
+        float new_size = std::clamp(view_size * scale, std::min(MIN_VIEW_SIZE, residue_count), residue_count);
+        column_begin = mouse_column - (mouse_column - column_begin) * new_size / view_size;
+        row_begin = mouse_row - (mouse_row - row_begin) * new_size / view_size;
+        view_size = new_size;
+        residues_per_pixel = view_size / map_size;
+    }
+    if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Right))
+    {
+        column_begin -= io.MouseDelta.x * residues_per_pixel;
+        row_begin -= io.MouseDelta.y * residues_per_pixel;
+    }
+    column_begin = std::clamp(column_begin, 0.0f, residue_count - view_size);
+    row_begin = std::clamp(row_begin, 0.0f, residue_count - view_size);
+
+    // One bin per pixel at most, larger ones once residues get wider than a pixel
+    int bin_count = static_cast<int>(std::min(map_size, std::ceil(view_size)));
+    float bin_size = map_size / bin_count;
+    float residues_per_bin = view_size / bin_count;
+    bins.assign(static_cast<size_t>(bin_count) * bin_count, -1.0f);
+
+    auto addBin = [&](uint32_t row, uint32_t column, float distance) {
+        float row_bin = (row - row_begin) / residues_per_bin;
+        float column_bin = (column - column_begin) / residues_per_bin;
+        if (row_bin < 0.0f || column_bin < 0.0f || row_bin >= bin_count || column_bin >= bin_count)
+            return;
+        float &bin = bins[static_cast<size_t>(row_bin) * bin_count + static_cast<size_t>(column_bin)];
+        if (bin < 0.0f || distance < bin)
+            bin = distance;
+    };
+
+    // Contacts only store the upper triangle, so rows in view and rows mirroring columns in view are both visited
+    uint32_t view_begin = static_cast<uint32_t>(std::min(row_begin, column_begin));
+    uint32_t view_end = static_cast<uint32_t>(std::ceil(std::max(row_begin, column_begin) + view_size));
+    view_end = std::min<uint32_t>(view_end, static_cast<uint32_t>(contacts.offsets.empty() ? 0 : contacts.offsets.size() - 1));
+    for (uint32_t residue = view_begin; residue < view_end; ++residue)
+    {
+        for (uint32_t k = contacts.offsets[residue]; k < contacts.offsets[residue + 1]; ++k)
+        {
+            uint32_t partner = contacts.partners[k];
+            addBin(residue, partner, contacts.distances[k]);
+            addBin(partner, residue, contacts.distances[k]);
+        }
+    }
+
+    ImDrawList *draw_list = ImGui::GetWindowDrawList();
+    draw_list->AddRectFilled(origin, ImVec2(origin.x + map_size, origin.y + map_size), IM_COL32(255, 255, 255, 255));
+    draw_list->PushClipRect(origin, ImVec2(origin.x + map_size, origin.y + map_size), true);
+    for (int row = 0; row < bin_count; ++row)
+    {
+        for (int column = 0; column < bin_count; ++column)
+        {
+            float distance = bins[static_cast<size_t>(row) * bin_count + column];
+            if (distance < 0.0f)
+                continue;
+            ImVec2 min(origin.x + column * bin_size, origin.y + row * bin_size);
+            draw_list->AddRectFilled(min, ImVec2(min.x + bin_size, min.y + bin_size),
+                                     contactColor(distance, contacts.cutoff));
+        }
+    }
+
+    if (selected_first >= 0)
+    {
+        float x = origin.x + (selected_second - column_begin) / residues_per_pixel;
+        float y = origin.y + (selected_first - row_begin) / residues_per_pixel;
+        float extent = std::max(3.0f, 1.0f / residues_per_pixel);
+        draw_list->AddRect(ImVec2(x - 1.0f, y - 1.0f), ImVec2(x + extent + 1.0f, y + extent + 1.0f),
+                           SELECTION_COLOR, 0.0f, 0, 2.0f);
+    }
+    draw_list->PopClipRect();
+
+    if (hovered)
+    {
+        int row = static_cast<int>(row_begin + (io.MousePos.y - origin.y) * residues_per_pixel);
+        int column = static_cast<int>(column_begin + (io.MousePos.x - origin.x) * residues_per_pixel);
+        int last = static_cast<int>(atoms.residueCount()) - 1;
+        hovered_first = std::clamp(row, 0, last);
+        hovered_second = std::clamp(column, 0, last);
+
+        char first_label[64], second_label[64];
+        residueLabel(atoms, hovered_first, first_label, sizeof(first_label));
+        residueLabel(atoms, hovered_second, second_label, sizeof(second_label));
+        float distance = contacts.distance(hovered_first, hovered_second);
+        ImGui::BeginTooltip();
+        ImGui::Text("%s - %s", first_label, second_label);
+        if (distance >= 0.0f)
+            ImGui::Text("%.2f A", distance);
+        else
+            ImGui::TextDisabled("No contact");
+        ImGui::EndTooltip();
+
+        if (ImGui::IsItemClicked(ImGuiMouseButton_Left))
+        {
+            selected_first = hovered_first;
+            selected_second = hovered_second;
+        }
+    }
+
+    if (selected_first >= 0)
+    {
+        char first_label[64], second_label[64];
+        residueLabel(atoms, selected_first, first_label, sizeof(first_label));
+        residueLabel(atoms, selected_second, second_label, sizeof(second_label));
+        ImGui::Text("Selected: %s - %s", first_label, second_label);
+    }
+
+    ImGui::End();
+}
+
+bool ContactMapView::highlighted_atoms(const AtomTable &atoms, std::vector<bool> &mask) const
+{
+    int first = hovered_first >= 0 ? hovered_first : selected_first;
+    int second = hovered_first >= 0 ? hovered_second : selected_second;
+    mask.assign(atoms.size(), false);
+    if (first < 0 || second < 0 || static_cast<size_t>(std::max(first, second)) >= atoms.residueCount())
+        return false;
+
+    for (int residue : {first, second})
+    {
+        size_t end = static_cast<size_t>(residue) + 1 < atoms.residueCount() ? atoms.residueAtomStarts[residue + 1]
+                                                                             : atoms.size();
+        for (size_t atom = atoms.residueAtomStarts[residue]; atom < end; ++atom)
+            mask[atom] = true;
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef OPENGL_MODEL_VIEWER_CONTACT_MAP_VIEW_H
+#define OPENGL_MODEL_VIEWER_CONTACT_MAP_VIEW_H
+
+#include <vector>
+
+#include "imgui/imgui.h"
+#include "bio/AtomTable.h"
+#include "bio/ContactMap.h"
+
+/*
+ * ImGui heatmap of a ContactMap. Residue pairs are binned to the pixels of the map and every bin shows its
+ * closest contact, so only the sparse contacts are visited and chains of tens of thousands of residues still
+ * draw in a few thousand rectangles. The mouse wheel zooms around the cursor and right-drag pans.
+ *
+ * Hovering reports a residue pair and clicking selects it: MoleculeView recolors highlighted_atoms() in the
+ * 3D representation to link both views.
+ */
+struct ContactMapView {
+    int hovered_first = -1;
+    int hovered_second = -1;
+    int selected_first = -1;
+    int selected_second = -1;
+
+    // Visible residues: rows from row_begin, columns from column_begin, view_size of each (0 for all)
+    float row_begin = 0.0f;
+    float column_begin = 0.0f;
+    float view_size = 0.0f;
+    float map_size = 400.0f; // Pixels
+
+    void render(const ContactMap &contacts, const AtomTable &atoms);
+
+    // Flags the atoms of the hovered pair, or of the selected one when nothing is hovered. Returns false if neither
+    bool highlighted_atoms(const AtomTable &atoms, std::vector<bool> &mask) const;
+
+private:
+    std::vector<float> bins; // Closest distance of every bin, negative when empty
+};
+
+
+#endif //OPENGL_MODEL_VIEWER_CONTACT_MAP_VIEW_H
@@ -171,6 +171,47 @@ DrawableMesh::DrawableMesh(GLuint drawMode, objl::Mesh mesh, const char *texture
     glEnableVertexAttribArray(n_attribute);
 }
 
+/*
+ * Constructor for a DrawableMesh class
+ * Uploads generated geometry (interleaved position and normal per vertex) with a plain white texture
+ */
+DrawableMesh::DrawableMesh(GLuint drawMode, const std::vector<float> &vertices, const std::vector<unsigned int> &indices) {
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    // Uploads the vertex and index data, binding both buffers to the VAO
+    Update(drawMode, vertices, indices);
+
+    // Same locations as the OBJ constructor, texture coordinates are left disabled
+    const unsigned int v_attribute = 0; // Position
+    const unsigned int n_attribute = 2; // Normals
+
+    glVertexAttribPointer(v_attribute, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(v_attribute);
+    glVertexAttribPointer(n_attribute, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *) (3 * sizeof(float)));
+    glEnableVertexAttribArray(n_attribute);
+
+    LoadTexture("resources/white.png");
+}
+
+/*
+ * Defines the Update method for class DrawableMesh
+ * Replaces the buffer contents with new interleaved position and normal data
+ */
+void DrawableMesh::Update(GLuint drawMode, const std::vector<float> &vertices, const std::vector<unsigned int> &indices) {
+    this->vert_count = vertices.size() / 6;
+    this->ind_count = indices.size();
+
+    // Binding the VAO first keeps the element buffer attached to it
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), drawMode);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), drawMode);
+}
+
 /*
  *  Defines the Draw method for class DrawableMesh
  *  Draws a mesh using OpenGL
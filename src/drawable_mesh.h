@@ -3,6 +3,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "obj/OBJ_Loader.h"
+#include "bio/MolecularSurface.h"
 
 class DrawableMesh
 {
@@ -26,6 +27,19 @@ public:
 
     DrawableMesh(GLuint drawMode, objl::Mesh mesh, const char * texturesFolder = nullptr);
 
+    // Interleaved position and normal per vertex (surfaces, cartoons), same attribute layout as OBJ meshes
+    DrawableMesh(GLuint drawMode, const std::vector<float> &vertices, const std::vector<unsigned int> &indices);
+
+    DrawableMesh(GLuint drawMode, const MolecularSurface &surface)
+        : DrawableMesh(drawMode, surface.vertices, surface.indices){};
+
+    // Re-uploads interleaved position and normal data, sizes may change
+    void Update(GLuint drawMode, const std::vector<float> &vertices, const std::vector<unsigned int> &indices);
+
+    void Update(GLuint drawMode, const MolecularSurface &surface) {
+        Update(drawMode, surface.vertices, surface.indices);
+    }
+
     void Draw() const;
     void LoadTexture(const char *texture_path);
 };
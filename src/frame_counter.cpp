@@ -27,6 +27,12 @@ int FrameCounter::update(bool print)
     return fps;
 }
 
+void FrameCounter::resume()
+{
+    previousTime = glfwGetTime();
+    deltaTime = 0.0;
+}
+
 int FrameCounter::update()
 {
     return update(true);
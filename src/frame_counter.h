@@ -9,6 +9,9 @@ struct FrameCounter
     int update();
     int update(bool print);
 
+    // Restarts timing after the loop slept, so the idle time doesn't show up as one huge frame
+    void resume();
+
     private:
         int frameCount;
 	    double previousTime;
@@ -0,0 +1,117 @@
+#include "frame_pacer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+// Frames kept for measurement when not throttling, older ones are dropped unmeasured
+static constexpr size_t MAX_TRACKED_FRAMES = 8;
+
+static float smooth(float average, double sample_seconds)
+{
+    float sample = float(sample_seconds * 1000.0);
+    return average == 0.0f ? sample : average + (sample - average) * 0.1f;
+}
+
+FramePacer::~FramePacer()
+{
+    release();
+}
+
+void FramePacer::release()
+{
+    for (auto &frame : in_flight)
+        glDeleteSync(frame.fence);
+    in_flight.clear();
+}
+
+void FramePacer::note_input()
+{
+    if (pending_input_time < 0.0)
+        pending_input_time = glfwGetTime();
+}
+
+void FramePacer::retire(const FrameInFlight &frame, double completed_time)
+{
+    // The frame reaches the middle of the screen half a refresh after the GPU is done with it
+    if (frame.input_time >= 0.0)
+        input_to_photon_ms = smooth(input_to_photon_ms, completed_time - frame.input_time + refresh_interval * 0.5);
+    glDeleteSync(frame.fence);
+}
+
+void FramePacer::begin_frame()
+{
+    double wait_start = glfwGetTime();
+
+    if (low_latency)
+    {
+        // Block until the GPU is at most max_frames_ahead frames behind
+        while (!in_flight.empty() && int(in_flight.size()) > max_frames_ahead)
+        {
+            FrameInFlight frame = in_flight.front();
+            in_flight.pop_front();
+            glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+            retire(frame, glfwGetTime());
+        }
+    }
+
+    if (frame_limit > 0)
+    {
+        // Sleep most of the remaining time, spin the last millisecond for accuracy
+        double interval = 1.0 / double(frame_limit);
+        double now = glfwGetTime();
+        if (next_frame_time - now > 0.002)
+            std::this_thread::sleep_for(std::chrono::duration<double>(next_frame_time - now - 0.001));
+        while (glfwGetTime() < next_frame_time) {}
+
+        now = glfwGetTime();
+        // Don't try to catch up after a long frame
+        next_frame_time = std::max(next_frame_time + interval, now);
+    }
+
+    frame_start_time = glfwGetTime();
+    throttle_wait_ms = smooth(throttle_wait_ms, frame_start_time - wait_start);
+}
+
+void FramePacer::sample_input()
+{
+    frame_input_time = pending_input_time;
+    pending_input_time = -1.0;
+}
+
+void FramePacer::end_frame()
+{
+    double now = glfwGetTime();
+    cpu_frame_ms = smooth(cpu_frame_ms, now - frame_start_time);
+
+    if (low_latency && max_frames_ahead == 0)
+    {
+        // Fully synchronous, the frame is done once glFinish returns
+        glFinish();
+        if (frame_input_time >= 0.0)
+            input_to_photon_ms = smooth(input_to_photon_ms, glfwGetTime() - frame_input_time + refresh_interval * 0.5);
+        frame_input_time = -1.0;
+        return;
+    }
+
+    in_flight.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frame_input_time});
+    frame_input_time = -1.0;
+
+    // Measure frames that already finished without waiting on them
+    while (!in_flight.empty())
+    {
+        GLenum status = glClientWaitSync(in_flight.front().fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        retire(in_flight.front(), now);
+        in_flight.pop_front();
+    }
+
+    while (in_flight.size() > MAX_TRACKED_FRAMES)
+    {
+        glDeleteSync(in_flight.front().fence);
+        in_flight.pop_front();
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef OPENGL_MODEL_VIEWER_FRAME_PACER_H
+#define OPENGL_MODEL_VIEWER_FRAME_PACER_H
+
+#include <glad/glad.h>
+
+#include <deque>
+
+/*
+ * Frame pacing for low input latency.
+ * Fences after every swap keep the CPU from queueing more than max_frames_ahead frames on the GPU,
+ * an optional limiter caps the frame rate when vsync is off, and the time from the first input event
+ * of a frame until that frame finished on the GPU is tracked as an input-to-photon estimate
+ */
+class FramePacer {
+public:
+    FramePacer() = default;
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    bool low_latency = false; // Throttle and sample input late, otherwise only measure
+    int max_frames_ahead = 1; // Frames the GPU may lag behind, 0 waits for every frame with glFinish
+    int frame_limit = 0; // Frames per second, 0 for unlimited
+    double refresh_interval = 1.0 / 60.0; // Display refresh period, used for the scanout part of the estimate
+
+    // Called from input callbacks, remembers the oldest input not yet used by a frame
+    void note_input();
+
+    // Called at the top of the loop: waits on old frames and applies the frame limit
+    void begin_frame();
+
+    // Called right before the view matrix is built, input received so far is in this frame
+    void sample_input();
+
+    // Called right after the buffer swap
+    void end_frame();
+
+    // Deletes the fences of frames still in flight, must run while the context is current.
+    // The pacer is a global used by the input callbacks, so main() calls this before glfwTerminate
+    void release();
+
+    // Measurements in milliseconds, lightly smoothed
+    float input_to_photon_ms = 0.0f;
+    float throttle_wait_ms = 0.0f;
+    float cpu_frame_ms = 0.0f;
+
+private:
+    struct FrameInFlight {
+        GLsync fence;
+        double input_time; // < 0 if the frame didn't carry new input
+    };
+
+    void retire(const FrameInFlight &frame, double completed_time);
+
+    std::deque<FrameInFlight> in_flight;
+    double pending_input_time = -1.0;
+    double frame_input_time = -1.0;
+    double frame_start_time = 0.0;
+    double next_frame_time = 0.0;
+};
+
+#endif //OPENGL_MODEL_VIEWER_FRAME_PACER_H
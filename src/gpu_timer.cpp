@@ -0,0 +1,40 @@
+#include "gpu_timer.h"
+
+GpuTimer::GpuTimer()
+{
+    glGenQueries(QUERY_COUNT, start_queries);
+    glGenQueries(QUERY_COUNT, end_queries);
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(QUERY_COUNT, start_queries);
+    glDeleteQueries(QUERY_COUNT, end_queries);
+}
+
+void GpuTimer::begin()
+{
+    // Collect the oldest pair before reusing it, it was issued QUERY_COUNT frames ago.
+    // The end timestamp completes last, once it is available so is the start
+    if (issued[current])
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(end_queries[current], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(start_queries[current], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(end_queries[current], GL_QUERY_RESULT, &end);
+            float ms = end > start ? float(end - start) / 1.0e6f : 0.0f;
+            milliseconds = milliseconds == 0.0f ? ms : milliseconds + (ms - milliseconds) * 0.2f;
+        }
+    }
+    glQueryCounter(start_queries[current], GL_TIMESTAMP);
+}
+
+void GpuTimer::end()
+{
+    glQueryCounter(end_queries[current], GL_TIMESTAMP);
+    issued[current] = true;
+    current = (current + 1) % QUERY_COUNT;
+}
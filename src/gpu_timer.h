@@ -0,0 +1,35 @@
+#ifndef OPENGL_MODEL_VIEWER_GPU_TIMER_H
+#define OPENGL_MODEL_VIEWER_GPU_TIMER_H
+
+#include <glad/glad.h>
+
+/*
+ * Measures how long the GPU spends on the commands issued between begin() and end().
+ * Each interval is a pair of GL_TIMESTAMP queries rather than a GL_TIME_ELAPSED query, so timers may overlap and
+ * nest (frame, scene, anti-aliasing), which GL_TIME_ELAPSED doesn't allow.
+ * Results are read back a few frames late from a small ring of queries, so timing never stalls the pipeline
+ */
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin();
+    void end();
+
+    // Latest available measurement in milliseconds, lightly smoothed
+    float milliseconds = 0.0f;
+
+private:
+    static constexpr int QUERY_COUNT = 4;
+
+    unsigned int start_queries[QUERY_COUNT];
+    unsigned int end_queries[QUERY_COUNT];
+    bool issued[QUERY_COUNT] = {};
+    int current = 0;
+};
+
+#endif //OPENGL_MODEL_VIEWER_GPU_TIMER_H
@@ -1,10 +1,130 @@
 #include "graphics/Color.h"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+struct Rgb {
+	float r, g, b;
+};
+
+constexpr Rgb hex(uint32_t rgb) {
+	return Rgb{((rgb >> 16) & 0xFF) / 255.0f, ((rgb >> 8) & 0xFF) / 255.0f, (rgb & 0xFF) / 255.0f};
+}
+
+struct ElementColor {
+	Element element;
+	Rgb rgb;
+};
+
+//Jmol CPK colors, the common organic elements keep the viewer's original colors
+constexpr ElementColor CPK_ENTRIES[] = {
+	{Element::H, {1.0f, 1.0f, 1.0f}}, {Element::C, {0.39f, 0.39f, 0.39f}}, {Element::N, {0.0f, 0.0f, 1.0f}},
+	{Element::O, {1.0f, 0.0f, 0.0f}}, {Element::P, {1.0f, 0.5f, 0.0f}}, {Element::S, {1.0f, 1.0f, 0.0f}},
+	{Element::He, hex(0xD9FFFF)}, {Element::Li, hex(0xCC80FF)}, {Element::Be, hex(0xC2FF00)},
+	{Element::B, hex(0xFFB5B5)}, {Element::F, hex(0x90E050)}, {Element::Ne, hex(0xB3E3F5)},
+	{Element::Na, hex(0xAB5CF2)}, {Element::Mg, hex(0x8AFF00)}, {Element::Al, hex(0xBFA6A6)},
+	{Element::Si, hex(0xF0C8A0)}, {Element::Cl, hex(0x1FF01F)}, {Element::Ar, hex(0x80D1E3)},
+	{Element::K, hex(0x8F40D4)}, {Element::Ca, hex(0x3DFF00)}, {Element::Ti, hex(0xBFC2C7)},
+	{Element::Mn, hex(0x9C7AC7)}, {Element::Fe, hex(0xE06633)}, {Element::Co, hex(0xF090A0)},
+	{Element::Ni, hex(0x50D050)}, {Element::Cu, hex(0xC88033)}, {Element::Zn, hex(0x7D80B0)},
+	{Element::Se, hex(0xFFA100)}, {Element::Br, hex(0xA62929)}, {Element::Mo, hex(0x54B5B5)},
+	{Element::Cd, hex(0xFFD98F)}, {Element::I, hex(0x940094)}, {Element::Pt, hex(0xD0D0E0)},
+	{Element::Au, hex(0xFFD123)}, {Element::Hg, hex(0xB8B8D0)}, {Element::U, hex(0x008FFF)}
+};
+
+//Elements without an entry get a negative red channel
+constexpr std::array<Rgb, static_cast<size_t>(Element::COUNT)> buildCpkColors() {
+	std::array<Rgb, static_cast<size_t>(Element::COUNT)> colors{};
+	for (size_t i = 0; i < colors.size(); ++i) {
+		colors[i] = Rgb{-1.0f, 0.0f, 0.0f};
+	}
+	for (const auto &entry : CPK_ENTRIES) {
+		colors[static_cast<size_t>(entry.element)] = entry.rgb;
+	}
+	return colors;
+}
+
+//Indexed by Element
+constexpr std::array<Rgb, static_cast<size_t>(Element::COUNT)> CPK_COLORS = buildCpkColors();
+static_assert(CPK_COLORS[static_cast<size_t>(Element::N)].b == 1.0f && CPK_COLORS[0].r < 0.0f, "CPK table is misindexed");
+
+struct NamedColor {
+	const char *name;
+	Rgb rgb;
+};
+
+constexpr NamedColor NAMED_COLORS[] = {
+	{"red", {1.0f, 0.0f, 0.0f}},
+	{"green", {0.0f, 1.0f, 0.0f}},
+	{"blue", {0.0f, 0.0f, 1.0f}},
+	{"orange", {1.0f, 0.5f, 0.0f}},
+	{"yellow", {1.0f, 1.0f, 0.0f}},
+	{"purple", {1.0f, 0.0f, 1.0f}},
+	{"white", {1.0f, 1.0f, 1.0f}},
+	{"light-gray", {0.7f, 0.7f, 0.7f}},
+	{"dark-gray", {0.3f, 0.3f, 0.3f}},
+	{"brown", {0.57f, 0.36f, 0.19f}},
+	{"black", {0.0f, 0.0f, 0.0f}}
+};
+
+//Distinct hues for chains, repeated when there are more chains
+constexpr Rgb CHAIN_COLORS[] = {
+	hex(0x4E79A7), hex(0xF28E2B), hex(0xE15759), hex(0x76B7B2), hex(0x59A14F), hex(0xEDC948),
+	hex(0xB07AA1), hex(0xFF9DA7), hex(0x9C755F), hex(0xBAB0AC), hex(0x86BCB6), hex(0xD37295)
+};
+constexpr size_t CHAIN_COLOR_COUNT = sizeof(CHAIN_COLORS) / sizeof(CHAIN_COLORS[0]);
+
+struct ResidueHydrophobicity {
+	const char *residue;
+	float value;
+};
+
+//Kyte & Doolittle (1982)
+constexpr ResidueHydrophobicity HYDROPHOBICITY[] = {
+	{"ILE", 4.5f}, {"VAL", 4.2f}, {"LEU", 3.8f}, {"PHE", 2.8f}, {"CYS", 2.5f},
+	{"MET", 1.9f}, {"ALA", 1.8f}, {"GLY", -0.4f}, {"THR", -0.7f}, {"SER", -0.8f},
+	{"TRP", -0.9f}, {"TYR", -1.3f}, {"PRO", -1.6f}, {"HIS", -3.2f}, {"GLU", -3.5f},
+	{"GLN", -3.5f}, {"ASP", -3.5f}, {"ASN", -3.5f}, {"LYS", -3.9f}, {"ARG", -4.5f}
+};
+
+Color toColor(const Rgb &rgb) {
+	return Color(rgb.r, rgb.g, rgb.b);
+}
+
+void storeColor(const Color &color, float *out) {
+	out[0] = color.r;
+	out[1] = color.g;
+	out[2] = color.b;
+}
+
+//out[i] = palette[indices[i]] for rgb triplets, the core of every lookup based scheme
+template <class Index>
+void gatherColors(const Index *indices, size_t count, const float *palette, float *out) {
+	for (size_t i = 0; i < count; ++i) {
+		const float *color = palette + static_cast<size_t>(indices[i]) * 3;
+		out[i * 3] = color[0];
+		out[i * 3 + 1] = color[1];
+		out[i * 3 + 2] = color[2];
+	}
+}
+
+}
+
 const Color Color::HELIX_COLOR_ALPHA(1.0f, 0.0f, 0.5f);
 const Color Color::HELIX_COLOR_3_10(0.63f, 0.0f, 0.5f);
 const Color Color::HELIX_COLOR_PI(0.38f, 0.0f, 0.5f);
 const Color Color::HELIX_COLOR_UNDEFINED(0.7f, 0.7f, 0.7f);
 const Color Color::SHEET_COLOR(1.0f, 0.78f, 0.0f);
+const Color Color::UNSTRUCTURED_COLOR(1.0f, 1.0f, 1.0f);
+const Color Color::UNKNOWN_ELEMENT_COLOR(1.0f, 0.08f, 0.58f);
+
+const char *const Color::SCHEME_NAMES[static_cast<int>(ColorScheme::COUNT)] = {
+	"Element", "Chain", "Secondary structure", "B-factor", "Hydrophobicity"
+};
 
 Color::Color() {}
 
@@ -16,102 +136,137 @@ Color Color::fromByte(unsigned char r, unsigned char g, unsigned char b) {
 }
 
 Color Color::fromName(const std::string &name) {
-	if (name == "red") {
-		return Color(1.0f, 0.0f, 0.0f);
-	}
-	if (name == "green") {
-		return Color(0.0f, 1.0f, 0.0f);
-	}
-	if (name == "blue") {
-		return Color(0.0f, 0.0f, 1.0f);
-	}
-	if (name == "orange") {
-		return Color(1.0f, 0.5f, 0.0f);
-	}
-	if (name == "yellow") {
-		return Color(1.0f, 1.0f, 0.0f);
-	}
-	if (name == "purple") {
-		return Color(1.0f, 0.0f, 1.0f);
-	}
-	if (name == "white") {
-		return Color(1.0f, 1.0f, 1.0f);
-	}
-	if (name == "light-gray") {
-		return Color(0.7f, 0.7f, 0.7f);
-	}
-	if (name == "dark-gray") {
-		return Color(0.3f, 0.3f, 0.3f);
-	}
-	if (name == "brown") {
-		return Color(0.57f, 0.36f, 0.19f);
-	}
-	if (name == "black") {
-		return Color(0.0f, 0.0f, 0.0f);
+	for (const auto &entry : NAMED_COLORS) {
+		if (name == entry.name) {
+			return toColor(entry.rgb);
+		}
 	}
 	throw std::invalid_argument("Invalid color name");
 }
 
 Color Color::fromElement(const std::string &element) {
-	if (element == "C") {
-		return Color(0.39f, 0.39f, 0.39f);
-	}
-	if (element == "H") {
-		return Color(1.0f, 1.0f, 1.0f);
-	}
-	if (element == "N") {
-		return Color(0.0f, 0.0f, 1.0f);
-	}
-	if (element == "O") {
-		return Color(1.0f, 0.0f, 0.0f);
-	}
-	if (element == "P") {
-		return Color(1.0f, 0.5f, 0.0f);
-	}
-	if (element == "S") {
-		return Color(1.0f, 1.0f, 0.0f);
+	return fromElement(elementFromSymbol(element));
+}
+
+Color Color::fromElement(Element element) {
+	const Rgb &rgb = CPK_COLORS[static_cast<size_t>(element) < CPK_COLORS.size() ? static_cast<size_t>(element) : 0];
+	return rgb.r < 0.0f ? UNKNOWN_ELEMENT_COLOR : toColor(rgb);
+}
+
+Color Color::fromHydrophobicity(const std::string &residueName) {
+	for (const auto &entry : HYDROPHOBICITY) {
+		if (residueName == entry.residue) {
+			//Kyte-Doolittle values range from -4.5 to 4.5
+			return gradient((entry.value + 4.5f) / 9.0f);
+		}
 	}
+	return UNSTRUCTURED_COLOR;
+}
+
+//Blue at 0, white at 0.5, red at 1
+Color Color::gradient(float t) {
+	t = std::min(std::max(t, 0.0f), 1.0f);
+	float red = std::min(1.0f, 2.0f * t);
+	float blue = std::min(1.0f, 2.0f - 2.0f * t);
+	return Color(red, std::min(red, blue), blue);
+}
 
-	throw std::invalid_argument("ERROR > Unknown color for element: " + element);
+const Color &Color::structureColor(SecondaryStructureIndex::Structure structure) {
+	static const Color *const COLORS[SecondaryStructureIndex::COUNT] = {
+		&UNSTRUCTURED_COLOR,
+		&HELIX_COLOR_ALPHA,
+		&HELIX_COLOR_3_10,
+		&HELIX_COLOR_PI,
+		&HELIX_COLOR_UNDEFINED,
+		&SHEET_COLOR
+	};
+	return *COLORS[structure];
 }
 
 Color Color::fromStructure(const Atom *atom, const MoleculeData *moleculeData) {
-	//Check if atom is in a helix
-	for (size_t i = 0; i < moleculeData->helices.size(); ++i) {
-		if (atom->chain == moleculeData->helices[i].chain &&
-			atom->residueNum >= moleculeData->helices[i].residueStart &&
-			atom->residueNum <= moleculeData->helices[i].residueEnd) {
-
-			switch (moleculeData->helices[i].type) {
-			//Alpha
-			case 1:
-			case 6:
-				return HELIX_COLOR_ALPHA;
-			//3/10
-			case 5:
-				return HELIX_COLOR_3_10;
-			//Pi
-			case 3:
-				return HELIX_COLOR_PI;
-			default:
-				return HELIX_COLOR_UNDEFINED;
-			}
+	return structureColor(moleculeData->secondaryStructure().lookup(atom->chain, atom->residueNum));
+}
 
-			break;
+void Color::fromStructure(const MoleculeData *moleculeData, float *rgbOut) {
+	fromScheme(ColorScheme::STRUCTURE, moleculeData, rgbOut);
+}
+
+void Color::fromScheme(ColorScheme scheme, const MoleculeData *moleculeData, float *rgbOut) {
+	const AtomTable &atoms = moleculeData->atoms;
+	size_t count = atoms.size();
+
+	//Every scheme but B-factors colors atoms by some per-residue or per-string id, resolve the color of each
+	//id once and gather. Per-residue schemes gather twice: residue colors first, then atom colors from those
+	std::vector<float> palette;
+	auto paletteOf = [&palette](size_t size, auto colorOf) {
+		palette.resize(size * 3);
+		for (size_t i = 0; i < size; ++i) {
+			storeColor(colorOf(i), palette.data() + i * 3);
 		}
-	}
+	};
+	std::vector<float> residueColors;
+	auto gatherResidueColors = [&](const auto *residuePaletteIndices) {
+		residueColors.resize(atoms.residueCount() * 3);
+		gatherColors(residuePaletteIndices, atoms.residueCount(), palette.data(), residueColors.data());
+		gatherColors(atoms.residueIndices.data(), count, residueColors.data(), rgbOut);
+	};
+
+	switch (scheme) {
+	case ColorScheme::ELEMENT:
+		paletteOf(atoms.elements.size(), [&](size_t id) {
+			return fromElement(atoms.elements[static_cast<uint16_t>(id)]);
+		});
+		gatherColors(atoms.elementIds.data(), count, palette.data(), rgbOut);
+		break;
+
+	case ColorScheme::CHAIN:
+		paletteOf(atoms.chainIds.size(), [](size_t index) {
+			return toColor(CHAIN_COLORS[index % CHAIN_COLOR_COUNT]);
+		});
+		gatherResidueColors(atoms.residueChainIndices.data());
+		break;
+
+	case ColorScheme::STRUCTURE:
+		paletteOf(SecondaryStructureIndex::COUNT, [](size_t structure) {
+			return structureColor(static_cast<SecondaryStructureIndex::Structure>(structure));
+		});
+		gatherResidueColors(moleculeData->secondaryStructure().residueStructures.data());
+		break;
 
-	//Check if atom is in a sheet
-	for (size_t i = 0; i < moleculeData->sheets.size(); ++i) {
-		if (atom->chain == moleculeData->sheets[i].chain &&
-			atom->residueNum >= moleculeData->sheets[i].residueStart &&
-			atom->residueNum <= moleculeData->sheets[i].residueEnd) {
+	case ColorScheme::HYDROPHOBICITY:
+		paletteOf(atoms.residueNames.size(), [&](size_t id) {
+			return fromHydrophobicity(atoms.residueNames[static_cast<uint16_t>(id)]);
+		});
+		gatherResidueColors(atoms.residueNameIds.data());
+		break;
 
-			return SHEET_COLOR;
+	case ColorScheme::B_FACTOR: {
+		if (count == 0) {
+			break;
+		}
+		const float *bFactors = atoms.bFactors.data();
+		float low = bFactors[0];
+		float high = bFactors[0];
+		for (size_t i = 1; i < count; ++i) {
+			low = std::min(low, bFactors[i]);
+			high = std::max(high, bFactors[i]);
 		}
+		float scale = high > low ? 1.0f / (high - low) : 0.0f;
+		//gradient() without the call and clamp, so this stays a straight SIMD loop
+		for (size_t i = 0; i < count; ++i) {
+			float t = (bFactors[i] - low) * scale;
+			float red = std::min(1.0f, 2.0f * t);
+			float blue = std::min(1.0f, 2.0f - 2.0f * t);
+			rgbOut[i * 3] = red;
+			rgbOut[i * 3 + 1] = std::min(red, blue);
+			rgbOut[i * 3 + 2] = blue;
+		}
+		break;
 	}
 
-	return Color(1.0f, 1.0f, 1.0f);
+	default:
+		break;
+	}
 }
 
 bool Color::operator==(const Color &color) const {
@@ -0,0 +1,312 @@
+#include "impostor_renderer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "bio/Element.h"
+
+namespace
+{
+    // Atom radius as a fraction of the van der Waals radius, and bond radius, for ball-and-stick
+    const float BALL_SCALE = 0.25f;
+    const float STICK_RADIUS = 0.15f;
+    // Atoms and bonds share one radius in licorice, so spheres round off the bond ends
+    const float LICORICE_RADIUS = 0.25f;
+
+    // RGBA8 in memory order, read back as normalized unsigned bytes
+    uint32_t PackColor(const float *rgb)
+    {
+        auto channel = [](float value) {
+            return static_cast<uint32_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+        };
+        return channel(rgb[0]) | channel(rgb[1]) << 8 | channel(rgb[2]) << 16 | 0xFFu << 24;
+    }
+}
+
+/**
+ * @brief Loads the impostor shaders and creates the static quad and box geometry.
+ */
+ImpostorRenderer::ImpostorRenderer()
+    : sphere_shader("shaders/impostor_sphere.vert", "shaders/impostor_sphere.frag"),
+      cylinder_shader("shaders/impostor_cylinder.vert", "shaders/impostor_cylinder.frag")
+{
+    // Billboard quad, drawn as a triangle strip
+    const float quad[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+
+    // Box around a bond, x and y across the bond, z from the first atom (0) to the second (1)
+    const float box[] = {
+        -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f, -1.0f, 1.0f, 0.0f,
+        -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, -1.0f, 1.0f, 1.0f
+    };
+    const unsigned int box_indices[] = {
+        0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7,
+        0, 1, 5, 0, 5, 4, 1, 2, 6, 1, 6, 5,
+        2, 3, 7, 2, 7, 6, 3, 0, 4, 3, 4, 7
+    };
+
+    glGenBuffers(1, &instance_VBO);
+
+    glGenVertexArrays(1, &sphere_VAO);
+    glBindVertexArray(sphere_VAO);
+    glGenBuffers(1, &quad_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(0);
+
+    glGenVertexArrays(1, &cylinder_VAO);
+    glBindVertexArray(cylinder_VAO);
+    glGenBuffers(1, &box_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, box_VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(box), box, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(0);
+    glGenBuffers(1, &box_EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, box_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(box_indices), box_indices, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+}
+
+ImpostorRenderer::~ImpostorRenderer()
+{
+    glDeleteVertexArrays(1, &sphere_VAO);
+    glDeleteVertexArrays(1, &cylinder_VAO);
+    glDeleteBuffers(1, &quad_VBO);
+    glDeleteBuffers(1, &box_VBO);
+    glDeleteBuffers(1, &box_EBO);
+    glDeleteBuffers(1, &instance_VBO);
+}
+
+/**
+ * @brief Rewrites the instance buffer for the selected atoms and the bonds between them.
+ */
+void ImpostorRenderer::Update(const MoleculeData &molecule, const float *atom_colors,
+                              Representation representation, const std::vector<bool> *selection)
+{
+    spheres.clear();
+    cylinders.clear();
+    sphere_atoms.clear();
+    cylinder_atoms.clear();
+    AppendAtoms(molecule, atom_colors, representation, selection);
+    Upload();
+}
+
+/**
+ * @brief Rewrites the instance buffer with every chain at the level picked by coarse_grain.update().
+ */
+void ImpostorRenderer::Update(const MoleculeData &molecule, const float *atom_colors,
+                              Representation representation, const CoarseGrain &coarse_grain)
+{
+    const AtomTable &atoms = molecule.atoms;
+    spheres.clear();
+    cylinders.clear();
+    sphere_atoms.clear();
+    cylinder_atoms.clear();
+
+    std::vector<bool> atom_level(atoms.size());
+    for (size_t i = 0; i < atoms.size(); ++i)
+        atom_level[i] = coarse_grain.atomLevel(atoms, i) == CoarseGrain::ATOMS;
+    AppendAtoms(molecule, atom_colors, representation, &atom_level);
+
+    // Bead color is the mean color of the residue's atoms
+    auto bead_color = [&](uint32_t residue) {
+        size_t begin = atoms.residueAtomStarts[residue];
+        size_t end = residue + 1 < atoms.residueCount() ? atoms.residueAtomStarts[residue + 1] : atoms.size();
+        float rgb[3] = {0.0f, 0.0f, 0.0f};
+        for (size_t a = begin; a < end; ++a)
+            for (int k = 0; k < 3; ++k)
+                rgb[k] += atom_colors[3 * a + k] / static_cast<float>(end - begin);
+        return PackColor(rgb);
+    };
+
+    for (const CoarseGrain::ChainLevel &chain : coarse_grain.chains)
+    {
+        if (chain.level == CoarseGrain::RESIDUES)
+        {
+            for (uint32_t residue : chain.residues)
+            {
+                const CoarseGrain::Bead &bead = coarse_grain.beads[residue];
+                spheres.push_back(SphereInstance{{bead.center.x, bead.center.y, bead.center.z}, bead.radius,
+                                                 bead_color(residue)});
+                sphere_atoms.push_back(NO_ATOM);
+            }
+        }
+        else if (chain.level == CoarseGrain::CHAIN)
+        {
+            // Licorice through every stride-th bead and the last one, spheres round off the joints
+            size_t stride = static_cast<size_t>(chain.stride);
+            size_t count = chain.residues.size();
+            for (size_t k = 0; k < count;)
+            {
+                const glm::vec3 &center = coarse_grain.beads[chain.residues[k]].center;
+                uint32_t color = bead_color(chain.residues[k]);
+                spheres.push_back(SphereInstance{{center.x, center.y, center.z}, chain.beadRadius, color});
+                sphere_atoms.push_back(NO_ATOM);
+                if (k + 1 == count)
+                    break;
+                // The step to the last bead may be shorter than the stride
+                size_t next_k = std::min(k + stride, count - 1);
+                const glm::vec3 &next = coarse_grain.beads[chain.residues[next_k]].center;
+                if (glm::length(next - center) <= CoarseGrain::MAX_LINK * (next_k - k))
+                {
+                    cylinders.push_back(CylinderInstance{{center.x, center.y, center.z}, chain.beadRadius,
+                                                         {next.x, next.y, next.z}, color,
+                                                         bead_color(chain.residues[next_k])});
+                    cylinder_atoms.insert(cylinder_atoms.end(), {NO_ATOM, NO_ATOM});
+                }
+                k = next_k;
+            }
+        }
+    }
+    Upload();
+}
+
+/**
+ * @brief Rewrites the instance positions from a new coordinate set, e.g. a trajectory frame.
+ */
+void ImpostorRenderer::UpdatePositions(const float *xyz)
+{
+    for (size_t i = 0; i < spheres.size(); ++i)
+    {
+        if (sphere_atoms[i] != NO_ATOM)
+            std::memcpy(spheres[i].center, xyz + 3 * sphere_atoms[i], 3 * sizeof(float));
+    }
+    for (size_t i = 0; i < cylinders.size(); ++i)
+    {
+        if (cylinder_atoms[2 * i] != NO_ATOM)
+        {
+            std::memcpy(cylinders[i].start, xyz + 3 * cylinder_atoms[2 * i], 3 * sizeof(float));
+            std::memcpy(cylinders[i].end, xyz + 3 * cylinder_atoms[2 * i + 1], 3 * sizeof(float));
+        }
+    }
+    Upload();
+}
+
+void ImpostorRenderer::AppendAtoms(const MoleculeData &molecule, const float *atom_colors,
+                                   Representation representation, const std::vector<bool> *selection)
+{
+    const AtomTable &atoms = molecule.atoms;
+    const BondTable &bonds = molecule.bonds();
+    auto selected = [&](size_t atom) {
+        return !selection || (atom < selection->size() && (*selection)[atom]);
+    };
+
+    // Atom radius of every distinct element string
+    std::vector<float> element_radii(atoms.elements.size(), LICORICE_RADIUS);
+    if (representation == BALL_AND_STICK)
+    {
+        for (size_t id = 0; id < element_radii.size(); ++id)
+        {
+            Element element = elementFromSymbol(atoms.elements[static_cast<uint16_t>(id)]);
+            element_radii[id] = BALL_SCALE * vanDerWaalsRadius(element);
+        }
+    }
+    float bond_radius = representation == BALL_AND_STICK ? STICK_RADIUS : LICORICE_RADIUS;
+
+    for (size_t i = 0; i < atoms.size(); ++i)
+    {
+        if (selected(i))
+        {
+            spheres.push_back(SphereInstance{{atoms.x[i], atoms.y[i], atoms.z[i]},
+                                             element_radii[atoms.elementIds[i]], PackColor(atom_colors + 3 * i)});
+            sphere_atoms.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    bonds.forEach([&](uint32_t first, uint32_t second) {
+        if (selected(first) && selected(second))
+        {
+            cylinders.push_back(CylinderInstance{{atoms.x[first], atoms.y[first], atoms.z[first]}, bond_radius,
+                                                 {atoms.x[second], atoms.y[second], atoms.z[second]},
+                                                 PackColor(atom_colors + 3 * first), PackColor(atom_colors + 3 * second)});
+            cylinder_atoms.insert(cylinder_atoms.end(), {first, second});
+        }
+    });
+}
+
+void ImpostorRenderer::Upload()
+{
+    sphere_count = spheres.size();
+    cylinder_count = cylinders.size();
+
+    size_t sphere_bytes = spheres.size() * sizeof(SphereInstance);
+    size_t cylinder_bytes = cylinders.size() * sizeof(CylinderInstance);
+    staging.resize(sphere_bytes + cylinder_bytes);
+    if (sphere_bytes)
+        std::memcpy(staging.data(), spheres.data(), sphere_bytes);
+    if (cylinder_bytes)
+        std::memcpy(staging.data() + sphere_bytes, cylinders.data(), cylinder_bytes);
+
+    // Reallocates only when the instances outgrow the buffer
+    glBindBuffer(GL_ARRAY_BUFFER, instance_VBO);
+    if (staging.size() > instance_capacity)
+    {
+        instance_capacity = staging.size();
+        glBufferData(GL_ARRAY_BUFFER, instance_capacity, staging.data(), GL_DYNAMIC_DRAW);
+    }
+    else if (!staging.empty())
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, staging.size(), staging.data());
+    }
+
+    // Cylinders start after the spheres, their attribute offsets follow the sphere count
+    BindInstanceAttributes(sphere_bytes);
+}
+
+void ImpostorRenderer::BindInstanceAttributes(size_t cylinder_offset) const
+{
+    glBindVertexArray(sphere_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_VBO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void *) offsetof(SphereInstance, center));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SphereInstance), (void *) offsetof(SphereInstance, color));
+    for (unsigned int attribute = 1; attribute <= 2; ++attribute)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+
+    glBindVertexArray(cylinder_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_VBO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(CylinderInstance),
+                          (void *) (cylinder_offset + offsetof(CylinderInstance, start)));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(CylinderInstance),
+                          (void *) (cylinder_offset + offsetof(CylinderInstance, end)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CylinderInstance),
+                          (void *) (cylinder_offset + offsetof(CylinderInstance, start_color)));
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CylinderInstance),
+                          (void *) (cylinder_offset + offsetof(CylinderInstance, end_color)));
+    for (unsigned int attribute = 1; attribute <= 4; ++attribute)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Draws the spheres, then the cylinders, each with one instanced call.
+ */
+void ImpostorRenderer::Draw(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection) const
+{
+    if (sphere_count)
+    {
+        sphere_shader.use();
+        sphere_shader.setMat4("model", model);
+        sphere_shader.setMat4("view", view);
+        sphere_shader.setMat4("projection", projection);
+        glBindVertexArray(sphere_VAO);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, sphere_count);
+    }
+    if (cylinder_count)
+    {
+        cylinder_shader.use();
+        cylinder_shader.setMat4("model", model);
+        cylinder_shader.setMat4("view", view);
+        cylinder_shader.setMat4("projection", projection);
+        glBindVertexArray(cylinder_VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr, cylinder_count);
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "bio/MoleculeData.h"
+#include "bio/CoarseGrain.h"
+
+/**
+ * Ball-and-stick and licorice rendering with ray-cast impostors: atoms are instanced
+ * quads shaded as spheres, bonds are instanced boxes shaded as cylinders colored per half.
+ * The quad and the box are the only triangle geometry and never change, switching
+ * representation or selection only rewrites the instance buffer.
+ */
+class ImpostorRenderer
+{
+public:
+    enum Representation
+    {
+        BALL_AND_STICK,
+        LICORICE
+    };
+
+    unsigned int sphere_count = 0;
+    unsigned int cylinder_count = 0;
+
+    ImpostorRenderer();
+    ~ImpostorRenderer();
+    ImpostorRenderer(const ImpostorRenderer &) = delete;
+    ImpostorRenderer &operator=(const ImpostorRenderer &) = delete;
+
+    // atom_colors holds 3 floats per atom (Color::fromScheme layout), selection one flag per atom or nullptr for all
+    void Update(const MoleculeData &molecule, const float *atom_colors, Representation representation,
+                const std::vector<bool> *selection = nullptr);
+    // Chains at ATOMS level are drawn atom by atom, the others as residue beads or as a tube through them
+    void Update(const MoleculeData &molecule, const float *atom_colors, Representation representation,
+                const CoarseGrain &coarse_grain);
+    // Moves the atom instances to new coordinates, 3 floats per atom, keeping colors, radii and bonds.
+    // Bead and tube instances keep their positions until the next Update
+    void UpdatePositions(const float *xyz);
+    void Draw(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection) const;
+
+private:
+    struct SphereInstance
+    {
+        float center[3];
+        float radius;
+        uint32_t color;
+    };
+
+    struct CylinderInstance
+    {
+        float start[3];
+        float radius;
+        float end[3];
+        uint32_t start_color;
+        uint32_t end_color;
+    };
+
+    Shader sphere_shader;
+    Shader cylinder_shader;
+
+    unsigned int sphere_VAO;
+    unsigned int cylinder_VAO;
+    unsigned int quad_VBO;
+    unsigned int box_VBO;
+    unsigned int box_EBO;
+
+    // Spheres first, then cylinders, in one buffer
+    unsigned int instance_VBO;
+    size_t instance_capacity = 0;
+    std::vector<SphereInstance> spheres;
+    std::vector<CylinderInstance> cylinders;
+    // Source atoms of every instance for UpdatePositions, NO_ATOM for beads and tubes
+    static constexpr uint32_t NO_ATOM = 0xFFFFFFFFu;
+    std::vector<uint32_t> sphere_atoms;
+    std::vector<uint32_t> cylinder_atoms; // Two per cylinder
+    std::vector<uint8_t> staging;
+
+    void AppendAtoms(const MoleculeData &molecule, const float *atom_colors, Representation representation,
+                     const std::vector<bool> *selection);
+    void Upload();
+    void BindInstanceAttributes(size_t cylinder_offset) const;
+};
@@ -0,0 +1,375 @@
+#include "molecule_view.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+#include "imgui/imgui.h"
+#include "graphics/Color.h"
+#include "bio/BinaryCIFFile.h"
+#include "bio/CIFFile.h"
+#include "bio/PDBFile.h"
+
+namespace
+{
+    std::string lowercase_extension(const std::string &path)
+    {
+        size_t dot = path.find_last_of('.');
+        std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        return extension;
+    }
+
+    // Same rule as Cartoon: residues need a CA and an O to be part of a trace
+    std::vector<bool> atoms_outside_cartoon(const AtomTable &atoms)
+    {
+        std::vector<bool> outside(atoms.size(), true);
+        for (size_t r = 0; r < atoms.residueCount(); ++r)
+        {
+            size_t begin = atoms.residueAtomStarts[r];
+            size_t end = r + 1 < atoms.residueCount() ? atoms.residueAtomStarts[r + 1] : atoms.size();
+            bool has_ca = false, has_o = false;
+            for (size_t a = begin; a < end; ++a)
+            {
+                const std::string &name = atoms.names[atoms.nameIds[a]];
+                has_ca |= name == "CA";
+                has_o |= name == "O";
+            }
+            if (has_ca && has_o)
+                std::fill(outside.begin() + begin, outside.begin() + end, false);
+        }
+        return outside;
+    }
+
+    // SELECTION_COLOR of the contact map, so the pair looks the same in both views
+    const float HIGHLIGHT_COLOR[3] = {40 / 255.0f, 140 / 255.0f, 1.0f};
+}
+
+bool MoleculeView::load_structure(const std::string &path, Camera &camera)
+{
+    std::string extension = lowercase_extension(path);
+    std::unique_ptr<MoleculeData> read;
+    if (extension == "pdb" || extension == "ent")
+        read = std::make_unique<PDBFile>(path);
+    else if (extension == "cif" || extension == "mmcif")
+        read = std::make_unique<CIFFile>(path);
+    else if (extension == "bcif")
+        read = std::make_unique<BinaryCIFFile>(path);
+    else
+    {
+        status = "Unknown structure format: " + path;
+        return false;
+    }
+    if (read->atoms.size() == 0)
+    {
+        status = "No atoms read from " + path;
+        return false;
+    }
+
+    molecule = std::move(read);
+    trajectory.reset();
+    playing = false;
+    frame = 0;
+    contact_map_view = ContactMapView();
+    highlight = false;
+    coarse_grain.build(molecule->atoms);
+    beads_moved = false;
+    cartoon.clear();
+    cartoon_moved = false;
+    std::fill(cartoon_segments.begin(), cartoon_segments.end(), 0);
+    outside_cartoon = atoms_outside_cartoon(molecule->atoms);
+    superposer = std::make_unique<Superposer>(molecule->atoms);
+    rebuild();
+    contacts.clear();
+    update_contacts(false);
+
+    // Look at the center of the bounding box from far enough to see all of it
+    const AtomTable &atoms = molecule->atoms;
+    glm::vec3 low(atoms.x[0], atoms.y[0], atoms.z[0]);
+    glm::vec3 high = low;
+    for (size_t i = 1; i < atoms.size(); ++i)
+    {
+        glm::vec3 position(atoms.x[i], atoms.y[i], atoms.z[i]);
+        low = glm::min(low, position);
+        high = glm::max(high, position);
+    }
+    camera.Reset(0.5f * (low + high), -90, -10, std::max(5.0f, glm::length(high - low)));
+
+    status = std::to_string(atoms.size()) + " atoms read from " + path;
+    return true;
+}
+
+bool MoleculeView::load_trajectory(const std::string &path)
+{
+    if (!molecule)
+        return false;
+    std::unique_ptr<FrameSource> source = openFrameSource(path);
+    if (!source || source->frameCount() == 0)
+    {
+        status = "No frames read from " + path;
+        return false;
+    }
+    if (source->atomCount() != molecule->atoms.size())
+    {
+        status = "Trajectory has " + std::to_string(source->atomCount()) + " atoms, the structure " +
+                 std::to_string(molecule->atoms.size());
+        return false;
+    }
+
+    trajectory = std::make_unique<TrajectoryPlayer>(std::move(source));
+    playing = false;
+    playback_time = 0.0f;
+    status = std::to_string(trajectory->frameCount()) + " frames read from " + path;
+    return show_frame(0, true);
+}
+
+bool MoleculeView::render_ui(Camera &camera)
+{
+    bool changed = false;
+    ImGui::Begin("Molecule", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+    ImGui::InputText("Structure", structure_path, sizeof(structure_path));
+    if (ImGui::Button("Load Structure"))
+        changed |= load_structure(structure_path, camera);
+
+    if (molecule)
+    {
+        const AtomTable &atoms = molecule->atoms;
+        ImGui::Text("%zu atoms, %zu residues, %zu chains", atoms.size(), atoms.residueCount(), atoms.chainIds.size());
+
+        bool restyled = ImGui::Combo("Representation", &representation, "Ball and Stick\0Licorice\0Cartoon\0");
+        restyled |= ImGui::Combo("Color", &color_scheme, Color::SCHEME_NAMES, int(ColorScheme::COUNT));
+        restyled |= ImGui::Checkbox("Level of Detail", &level_of_detail);
+        if (restyled)
+        {
+            rebuild();
+            changed = true;
+        }
+        if (ImGui::Checkbox("Contact Map", &show_contact_map))
+            update_contacts(false);
+
+        ImGui::Separator();
+        ImGui::InputText("Trajectory", trajectory_path, sizeof(trajectory_path));
+        if (ImGui::Button("Open Trajectory"))
+            changed |= load_trajectory(trajectory_path);
+
+        if (trajectory)
+        {
+            if (ImGui::Button(playing ? "Pause###play" : "Play###play"))
+            {
+                playing = !playing;
+                playback_time = 0.0f;
+            }
+            ImGui::SameLine();
+            ImGui::Checkbox("Loop", &loop);
+
+            // Scrubbing pauses and waits for the frame, so every position of the slider is shown
+            int last_frame = int(trajectory->frameCount()) - 1;
+            if (ImGui::SliderInt("Frame", &frame, 0, last_frame))
+            {
+                playing = false;
+                changed |= show_frame(frame, true);
+            }
+            ImGui::SliderFloat("Frames / s", &frames_per_second, 1.0f, 120.0f, "%.0f");
+            if (ImGui::Checkbox("Align to Structure", &align_frames))
+                changed |= show_frame(frame, true);
+            if (align_frames)
+            {
+                ImGui::SameLine();
+                ImGui::Text("RMSD %.2f A", frame_rmsd);
+            }
+        }
+    }
+
+    if (!status.empty())
+        ImGui::TextWrapped("%s", status.c_str());
+    ImGui::End();
+
+    if (molecule && show_contact_map)
+        contact_map_view.render(contacts, molecule->atoms);
+    changed |= update_highlight();
+    return changed;
+}
+
+bool MoleculeView::update(float delta_time)
+{
+    if (!trajectory || !playing)
+        return false;
+
+    // A frame the prefetcher hasn't decoded yet is dropped and the time keeps running so a later one is shown
+    // instead, but never past the prefetch window: frames beyond it aren't being decoded and playback would stall
+    float window = float(std::max<size_t>(trajectory->prefetchCount(), 1));
+    playback_time = std::min(playback_time + delta_time * frames_per_second, window);
+    if (playback_time < 1.0f)
+        return false;
+
+    int frame_count = int(trajectory->frameCount());
+    int next = frame + int(playback_time);
+    if (next >= frame_count)
+    {
+        if (loop)
+        {
+            next %= frame_count;
+        }
+        else
+        {
+            next = frame_count - 1;
+            playing = false;
+        }
+    }
+
+    if (!show_frame(next, false))
+        return false;
+    playback_time -= std::floor(playback_time);
+    return true;
+}
+
+bool MoleculeView::update_level_of_detail(const glm::mat4 &model, const glm::vec3 &camera_position,
+                                          float pixels_per_unit)
+{
+    if (!molecule)
+        return false;
+
+    // Levels are picked in the structure's own space, the model's scale enlarges it on screen
+    glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(camera_position, 1.0f));
+    float scale = std::cbrt(std::abs(glm::determinant(glm::mat3(model))));
+
+    if (representation == CARTOON)
+    {
+        // Traces are read again from the new coordinates, every chain is rebuilt and uploaded
+        if (cartoon_moved)
+        {
+            cartoon.clear();
+            cartoon_moved = false;
+            std::fill(cartoon_segments.begin(), cartoon_segments.end(), 0);
+        }
+        if (cartoon.update(*molecule, camera) == 0)
+            return false;
+        upload_cartoon();
+        return true;
+    }
+    if (!level_of_detail)
+        return false;
+
+    // New beads start at ATOMS level, so instances drawn coarse before are rebuilt even if no level changed
+    bool was_coarse = false;
+    if (beads_moved)
+    {
+        for (const CoarseGrain::ChainLevel &chain : coarse_grain.chains)
+            was_coarse |= chain.level != CoarseGrain::ATOMS;
+        coarse_grain.build(molecule->atoms);
+        beads_moved = false;
+    }
+    if (coarse_grain.update(camera, pixels_per_unit * scale) == 0 && !was_coarse)
+        return false;
+    update_instances();
+    return true;
+}
+
+void MoleculeView::draw(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection) const
+{
+    if (!molecule)
+        return;
+    if (representation == CARTOON)
+    {
+        for (size_t c = 0; c < cartoon_segments.size(); ++c)
+            cartoon_meshes[c]->Draw();
+    }
+    renderer.Draw(model, view, projection);
+}
+
+void MoleculeView::rebuild()
+{
+    atom_colors.resize(3 * molecule->atoms.size());
+    Color::fromScheme(ColorScheme(color_scheme), molecule.get(), atom_colors.data());
+    if (highlight)
+    {
+        for (size_t i = 0; i < highlighted.size(); ++i)
+            if (highlighted[i])
+                std::copy(HIGHLIGHT_COLOR, HIGHLIGHT_COLOR + 3, atom_colors.begin() + 3 * i);
+    }
+    update_instances();
+}
+
+void MoleculeView::update_instances()
+{
+    auto style = ImpostorRenderer::Representation(representation);
+    if (representation == CARTOON)
+        renderer.Update(*molecule, atom_colors.data(), ImpostorRenderer::BALL_AND_STICK, &outside_cartoon);
+    else if (level_of_detail)
+        renderer.Update(*molecule, atom_colors.data(), style, coarse_grain);
+    else
+        renderer.Update(*molecule, atom_colors.data(), style);
+}
+
+void MoleculeView::upload_cartoon()
+{
+    static const std::vector<float> no_vertices;
+    static const std::vector<unsigned int> no_indices;
+    while (cartoon_meshes.size() < cartoon.chains.size())
+        cartoon_meshes.push_back(std::make_unique<DrawableMesh>(GL_DYNAMIC_DRAW, no_vertices, no_indices));
+    cartoon_segments.resize(cartoon.chains.size(), 0);
+
+    for (size_t c = 0; c < cartoon.chains.size(); ++c)
+    {
+        const Cartoon::ChainMesh &chain = cartoon.chains[c];
+        if (chain.segments == cartoon_segments[c])
+            continue;
+        cartoon_meshes[c]->Update(GL_DYNAMIC_DRAW, chain.vertices, chain.indices);
+        cartoon_segments[c] = chain.segments;
+    }
+}
+
+void MoleculeView::update_contacts(bool new_frame)
+{
+    if (!molecule || !show_contact_map)
+        return;
+    if (new_frame)
+        contacts.update(molecule->atoms);
+    else
+        contacts.compute(molecule->atoms);
+}
+
+bool MoleculeView::update_highlight()
+{
+    std::vector<bool> atoms;
+    bool any = molecule && show_contact_map && contact_map_view.highlighted_atoms(molecule->atoms, atoms);
+    if (any == highlight && (!any || atoms == highlighted))
+        return false;
+    highlight = any;
+    highlighted.swap(atoms);
+    rebuild();
+    return true;
+}
+
+bool MoleculeView::show_frame(int index, bool wait)
+{
+    const float *xyz = wait ? trajectory->frame(size_t(index)) : trajectory->tryFrame(size_t(index));
+    if (!xyz)
+    {
+        if (wait)
+            status = "Could not read frame " + std::to_string(index);
+        return false;
+    }
+
+    if (align_frames)
+    {
+        Superposition fit = superposer->fit(xyz);
+        aligned_frame.resize(3 * trajectory->atomCount());
+        fit.apply(xyz, aligned_frame.data(), trajectory->atomCount());
+        frame_rmsd = fit.rmsd;
+        xyz = aligned_frame.data();
+    }
+
+    // Bonds and colors stay those of the structure, only positions change. Beads and tubes follow in
+    // update_level_of_detail()
+    molecule->atoms.setCoordinates(xyz);
+    renderer.UpdatePositions(xyz);
+    beads_moved = true;
+    cartoon_moved = true;
+    update_contacts(true);
+    frame = index;
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef OPENGL_MODEL_VIEWER_MOLECULE_VIEW_H
+#define OPENGL_MODEL_VIEWER_MOLECULE_VIEW_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "camera.h"
+#include "contact_map_view.h"
+#include "drawable_mesh.h"
+#include "impostor_renderer.h"
+#include "bio/Cartoon.h"
+#include "bio/CoarseGrain.h"
+#include "bio/ContactMap.h"
+#include "bio/MoleculeData.h"
+#include "bio/Superposition.h"
+#include "bio/TrajectoryPlayer.h"
+
+/*
+ * Structure loaded from a PDB, mmCIF or BinaryCIF file and drawn with the impostor renderer, optionally animated
+ * by a trajectory. Playback streams the frames of a TrajectoryPlayer: a new frame only rewrites the atom
+ * coordinates and the instance positions, and frames that aren't decoded in time are skipped instead of waited for.
+ *
+ * The contact map follows the frames through ContactMap::update(), the residue pair hovered or selected in it
+ * is highlighted in the 3D view. With level of detail on, chains far from the camera are drawn as residue beads
+ * or a tube through them (CoarseGrain), the instances are only rebuilt when a chain changes level.
+ *
+ * The cartoon representation draws one mesh per chain with the caller's shader, tessellated by Cartoon::update()
+ * from the camera distance, and keeps ligands, waters and other residues without a backbone trace as impostors.
+ */
+class MoleculeView {
+public:
+    // Entries of the representation combo, the impostor ones first
+    enum Representation
+    {
+        BALL_AND_STICK = ImpostorRenderer::BALL_AND_STICK,
+        LICORICE = ImpostorRenderer::LICORICE,
+        CARTOON
+    };
+
+    int representation = BALL_AND_STICK;
+    int color_scheme = 0; // ColorScheme
+    bool show_contact_map = false;
+    bool level_of_detail = true;
+
+    // Trajectory playback
+    bool playing = false;
+    bool loop = true;
+    float frames_per_second = 20.0f;
+    int frame = 0;
+    bool align_frames = false; // Superposes every frame onto the structure, hiding its overall drift and rotation
+
+    bool loaded() const { return molecule != nullptr; }
+
+    // Loads a structure by extension (.pdb/.ent, .cif/.mmcif, .bcif), replacing the current one and its trajectory.
+    // The camera is moved to look at it. Returns false and keeps the current one if no atoms could be read
+    bool load_structure(const std::string &path, Camera &camera);
+    // Opens a trajectory or multi-model file for the loaded structure, its atoms must match the structure's
+    bool load_trajectory(const std::string &path);
+
+    // Panel with the file paths, representation and playback controls. Returns true if the scene changed
+    bool render_ui(Camera &camera);
+    // Advances playback by delta_time seconds and applies the frame, returns true if the coordinates changed
+    bool update(float delta_time);
+    // Picks the coarse-grain level or the cartoon detail of every chain for a camera in world space,
+    // pixels_per_unit as given by CoarseGrain::pixelsPerUnit(). Returns true if anything was rebuilt, call before
+    // draw()
+    bool update_level_of_detail(const glm::mat4 &model, const glm::vec3 &camera_position, float pixels_per_unit);
+    void draw(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection) const;
+
+private:
+    std::unique_ptr<MoleculeData> molecule;
+    std::unique_ptr<TrajectoryPlayer> trajectory;
+    ImpostorRenderer renderer;
+    std::vector<float> atom_colors;
+    CoarseGrain coarse_grain;
+    bool beads_moved = false; // The beads are those of an earlier frame
+
+    Cartoon cartoon;
+    bool cartoon_moved = false; // The meshes are those of an earlier frame
+    std::vector<std::unique_ptr<DrawableMesh>> cartoon_meshes; // Per chain, kept for the next structure
+    std::vector<int> cartoon_segments; // Detail each mesh was uploaded with, 0 to upload it again
+    std::vector<bool> outside_cartoon; // Atoms of residues without a CA and an O, drawn next to the cartoon
+
+    ContactMap contacts;
+    ContactMapView contact_map_view;
+    std::vector<bool> highlighted; // Atoms of the contact map's pair, recolored when highlight is set
+    bool highlight = false;
+
+    char structure_path[512] = "";
+    char trajectory_path[512] = "";
+    std::string status;
+
+    float playback_time = 0.0f; // Time since the current frame was shown, in frames
+    std::unique_ptr<Superposer> superposer; // Fits frames onto the structure as loaded
+    std::vector<float> aligned_frame;
+    float frame_rmsd = 0.0f;
+
+    // Recolors the atoms, then rewrites the instances
+    void rebuild();
+    void update_instances();
+    // Uploads the chain meshes Cartoon::update() rebuilt
+    void upload_cartoon();
+    // Recomputes the contacts if the map is shown, new_frame only re-measures the candidate pairs
+    void update_contacts(bool new_frame);
+    // Follows the contact map's hovered or selected pair, returns true if the highlight changed
+    bool update_highlight();
+    bool show_frame(int index, bool wait);
+};
+
+#endif //OPENGL_MODEL_VIEWER_MOLECULE_VIEW_H
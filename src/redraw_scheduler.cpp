@@ -0,0 +1,19 @@
+#include "redraw_scheduler.h"
+
+#include <algorithm>
+
+void RedrawScheduler::request(int frames)
+{
+    pending_frames = std::max(pending_frames, frames < 0 ? settle_frames : frames);
+}
+
+bool RedrawScheduler::needs_redraw() const
+{
+    return !enabled || pending_frames > 0;
+}
+
+void RedrawScheduler::frame_rendered()
+{
+    if (pending_frames > 0)
+        pending_frames--;
+}
@@ -0,0 +1,30 @@
+#ifndef OPENGL_MODEL_VIEWER_REDRAW_SCHEDULER_H
+#define OPENGL_MODEL_VIEWER_REDRAW_SCHEDULER_H
+
+/*
+ * Decides whether the render loop has to draw a frame or can sleep until the next event.
+ * Anything that changes the picture (input, animations, uploads, UI) requests a few frames,
+ * when none are pending the loop blocks in glfwWaitEventsTimeout
+ */
+struct RedrawScheduler {
+    bool enabled = false; // Continuous rendering when false
+
+    // Frames drawn after the last change, ImGui needs a couple to settle hover states and layout.
+    // Raised by the render loop while TAA is accumulating its history
+    int settle_frames = 3;
+
+    // Longest single sleep while idle, wake-up conditions set by other threads are rechecked this often
+    double idle_timeout = 1.0;
+
+    // Requests that the next `frames` frames get drawn, settle_frames when < 0
+    void request(int frames = -1);
+
+    bool needs_redraw() const;
+
+    // Must be called once for every drawn frame
+    void frame_rendered();
+
+    int pending_frames = 1;
+};
+
+#endif //OPENGL_MODEL_VIEWER_REDRAW_SCHEDULER_H
@@ -0,0 +1,113 @@
+#include "render_target.h"
+
+#include <iostream>
+
+RenderTarget::~RenderTarget()
+{
+    release();
+}
+
+void RenderTarget::release()
+{
+    if (fbo)
+        glDeleteFramebuffers(1, &fbo);
+    if (color_texture)
+        glDeleteTextures(1, &color_texture);
+    if (depth_texture)
+        glDeleteTextures(1, &depth_texture);
+    if (color_renderbuffer)
+        glDeleteRenderbuffers(1, &color_renderbuffer);
+    if (depth_renderbuffer)
+        glDeleteRenderbuffers(1, &depth_renderbuffer);
+    fbo = color_texture = depth_texture = color_renderbuffer = depth_renderbuffer = 0;
+}
+
+void RenderTarget::resize(int new_width, int new_height, int new_samples)
+{
+    if (new_width == width && new_height == height && new_samples == samples && fbo)
+        return;
+
+    release();
+    width = new_width;
+    height = new_height;
+    samples = new_samples;
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    if (samples > 0)
+    {
+        // Multisampled targets are only ever resolved with a blit, renderbuffers are enough
+        glGenRenderbuffers(1, &color_renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_renderbuffer);
+
+        glGenRenderbuffers(1, &depth_renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+    else
+    {
+        attach_textures();
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEBUFFER:: Render target " << width << "x" << height
+                  << " (" << samples << " samples) is not complete" << std::endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::attach_textures()
+{
+    // Color attachment, linearly filtered so it can be upscaled
+    glGenTextures(1, &color_texture);
+    glBindTexture(GL_TEXTURE_2D, color_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Depth attachment as a texture so post-processing passes can read it
+    glGenTextures(1, &depth_texture);
+    glBindTexture(GL_TEXTURE_2D, depth_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0,
+                 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_texture, 0);
+}
+
+void RenderTarget::bind(int viewport_width, int viewport_height) const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, viewport_width, viewport_height);
+}
+
+void RenderTarget::blit_to_screen(int src_width, int src_height, int dst_width, int dst_height) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, src_width, src_height, 0, 0, dst_width, dst_height,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, dst_width, dst_height);
+}
+
+void RenderTarget::resolve_into(const RenderTarget &target, int region_width, int region_height) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.fbo);
+    // Depth can only be copied with nearest filtering, same-size blits never filter anyway
+    glBlitFramebuffer(0, 0, region_width, region_height, 0, 0, region_width, region_height,
+                      GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,45 @@
+#ifndef OPENGL_MODEL_VIEWER_RENDER_TARGET_H
+#define OPENGL_MODEL_VIEWER_RENDER_TARGET_H
+
+#include <glad/glad.h>
+
+/*
+ * Offscreen framebuffer with a color and a depth texture, or multisampled renderbuffers when samples > 0.
+ * The storage is sized for the full window, lower render resolutions only use its lower left corner
+ * so changing the resolution never reallocates
+ */
+class RenderTarget {
+public:
+    RenderTarget() = default;
+    ~RenderTarget();
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    // (Re)allocates the attachments, does nothing if neither size nor sample count changed
+    void resize(int width, int height, int samples = 0);
+
+    // Binds the framebuffer and restricts the viewport to the given region
+    void bind(int viewport_width, int viewport_height) const;
+
+    // Stretches the region [0, src) onto the whole default framebuffer with bilinear filtering
+    void blit_to_screen(int src_width, int src_height, int dst_width, int dst_height) const;
+
+    // Copies the region [0, size) into the same region of another target, resolving multisampled color and depth
+    void resolve_into(const RenderTarget &target, int region_width, int region_height) const;
+
+    unsigned int fbo = 0;
+    unsigned int color_texture = 0;
+    unsigned int depth_texture = 0;
+    unsigned int color_renderbuffer = 0; // Used instead of the textures when multisampled
+    unsigned int depth_renderbuffer = 0;
+    int width = 0;
+    int height = 0;
+    int samples = 0;
+
+private:
+    void release();
+    void attach_textures();
+};
+
+#endif //OPENGL_MODEL_VIEWER_RENDER_TARGET_H
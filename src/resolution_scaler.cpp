@@ -0,0 +1,27 @@
+#include "resolution_scaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+float ResolutionScaler::update(float gpu_milliseconds, int target_fps)
+{
+    if (gpu_milliseconds <= 0.0f || target_fps <= 0)
+        return scale;
+
+    float budget = 1000.0f / float(target_fps) * headroom;
+
+    // Cost scales with the pixel count, so correct the per-axis scale by the square root of the ratio
+    float desired = scale * std::sqrt(budget / gpu_milliseconds);
+    desired = std::clamp(desired, min_scale, max_scale);
+
+    // Dead band and damping keep the scale from oscillating around the budget
+    if (std::fabs(desired - scale) > 0.02f)
+        scale += (desired - scale) * 0.25f;
+
+    return scale;
+}
+
+int ResolutionScaler::scaled(int size) const
+{
+    return std::max(1, int(std::lround(float(size) * scale)));
+}
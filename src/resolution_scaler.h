@@ -0,0 +1,21 @@
+#ifndef OPENGL_MODEL_VIEWER_RESOLUTION_SCALER_H
+#define OPENGL_MODEL_VIEWER_RESOLUTION_SCALER_H
+
+/*
+ * Picks the render resolution of the 3D scene from the measured GPU frame time so a target frame rate holds.
+ * The scale applies to both axes, the pixel cost is assumed to grow with its square
+ */
+struct ResolutionScaler {
+    float scale = 1.0f; // Current fraction of the native resolution per axis
+    float min_scale = 0.35f;
+    float max_scale = 1.0f;
+    float headroom = 0.9f; // Fraction of the frame budget the GPU is allowed to use
+
+    // Feeds the latest GPU frame time and returns the new scale
+    float update(float gpu_milliseconds, int target_fps);
+
+    // Size of the scaled render region for a framebuffer size
+    int scaled(int size) const;
+};
+
+#endif //OPENGL_MODEL_VIEWER_RESOLUTION_SCALER_H
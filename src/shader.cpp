@@ -4,39 +4,53 @@
 #include <glm/gtc/type_ptr.hpp>
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath)
 {
     // Variables related to shader management
     std::string vertexCode; // Vertex shader
     std::string fragmentCode; // Fragment shader
-    std::ifstream vShaderFile; // Be used to read the vertex shader source code from a file
-    std::ifstream fShaderFile; // Be used to read the fragment shader source code from a file
 
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
+    if (!readSource(vertexPath, vertexCode) || !readSource(fragmentPath, fragmentCode))
     {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
+        std::cout << "ERROR: SHADER::" << vertexPath << "::" << fragmentPath << "::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+    }
 
-        vShaderFile.close();
-        fShaderFile.close();
+    // 2. Compile and link the program
+    std::string error;
+    ID = compileProgram(vertexCode, fragmentCode, error);
+    if (ID == 0)
+    {
+        std::cout << "ERROR::SHADER::" << vertexPath << "::" << fragmentPath << "::" << error << std::endl;
+        throw std::runtime_error("Shader compilation failed");
+    }
+}
 
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+bool Shader::readSource(const std::string& path, std::string& code)
+{
+    std::ifstream shaderFile; // Be used to read the shader source code from a file
+    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try
+    {
+        shaderFile.open(path);
+        std::stringstream shaderStream;
+        shaderStream << shaderFile.rdbuf();
+        shaderFile.close();
+        code = shaderStream.str();
     }
-    catch (std::ifstream::failure e)
+    catch (const std::ifstream::failure& e)
     {
-        std::cout << "ERROR: SHADER::" << vertexPath << "::" << fragmentPath << "::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        return false;
     }
+    return true;
+}
+
+unsigned int Shader::compileProgram(const std::string& vertexCode, const std::string& fragmentCode,
+                                    std::string& error)
+{
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
-    // 2. Compile shaders
-    unsigned int vertex, fragment;
+    unsigned int vertex, fragment, program;
     int success;
     char infoLog[512];
 
@@ -45,13 +59,14 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     glShaderSource(vertex, 1, &vShaderCode, NULL);
     glCompileShader(vertex);
 
-    // Print compile errors if any
+    // Collect compile errors if any
     glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
     if (!success)
     {
         glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::" << vertexPath << "::COMPILATION_FAILED\n" << infoLog << std::endl;
-        throw std::runtime_error("Vertex shader compilation failed");
+        error = std::string("VERTEX::COMPILATION_FAILED\n") + infoLog;
+        glDeleteShader(vertex);
+        return 0;
     }
 
     // Similar for Fragment Shader
@@ -59,33 +74,37 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     glShaderSource(fragment, 1, &fShaderCode, NULL);
     glCompileShader(fragment);
 
-    // Print compile errors if any
+    // Collect compile errors if any
     glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
     if (!success)
     {
         glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::" << fragmentPath << "::COMPILATION_FAILED\n" << infoLog << std::endl;
-        throw std::runtime_error("Fragment shader compilation failed");
+        error = std::string("FRAGMENT::COMPILATION_FAILED\n") + infoLog;
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return 0;
     }
 
     // Shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-
-    // Print linking errors if any
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        throw std::runtime_error("Shader linking failed");
-    }
+    program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
 
     // Delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    // Collect linking errors if any
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        error = std::string("PROGRAM::LINKING_FAILED\n") + infoLog;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
 }
 
 void Shader::use() const
@@ -108,6 +127,11 @@ void Shader::setFloat(const std::string& name, float value) const
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+void Shader::setVec2(const std::string &name, float v1, float v2) const
+{
+    glUniform2f(glGetUniformLocation(ID, name.c_str()), v1, v2);
+}
+
 void Shader::setVec3(const std::string &name, glm::vec3 v) const
 {
     setVec3(name, v.x, v.y, v.z);
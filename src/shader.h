@@ -18,16 +18,29 @@ class Shader
 public:
     unsigned int ID;
 
+    // Source files the program was built from, kept around so the program can be rebuilt
+    std::string vertexPath;
+    std::string fragmentPath;
+
     Shader(const char* vertexPath, const char* fragmentPath);
     void use() const;
 
     void setBool(const std::string& name, bool value) const;
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
+    void setVec2(const std::string& name, float v1, float v2) const;
     void setVec3(const std::string& name, glm::vec3 v) const;
     void setVec3(const std::string& name, float v1, float v2, float v3) const;
     void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const;
     void setMat4(const std::string& name, glm::mat4 matrix) const;
+
+    // Reads a whole source file, returns false if it couldn't be read
+    static bool readSource(const std::string& path, std::string& code);
+
+    // Compiles and links a program from the given sources in the current context.
+    // Returns the program ID, or 0 with the driver log in `error` on failure
+    static unsigned int compileProgram(const std::string& vertexCode, const std::string& fragmentCode,
+                                       std::string& error);
 };
 
 #endif
@@ -0,0 +1,187 @@
+#include "shader_watcher.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+// Modification time of a file, or the minimum time if it can't be queried (e.g. mid-save)
+static fs::file_time_type modified_time(const std::string &path)
+{
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    return ec ? fs::file_time_type::min() : time;
+}
+
+ShaderWatcher::ShaderWatcher(GLFWwindow *main_window, const std::vector<Shader*> &shaders, double poll_interval)
+    : poll_interval(poll_interval)
+{
+    for (Shader *shader : shaders)
+        watched.push_back({shader, modified_time(shader->vertexPath), modified_time(shader->fragmentPath)});
+
+    // Hidden 1x1 window sharing its objects with the main context, created on the main thread as GLFW requires
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    shared_window = glfwCreateWindow(1, 1, "Datalens shader compiler", nullptr, main_window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+    if (shared_window == nullptr)
+        std::cout << "Shader hot-reload: no shared context, compiling on the render thread" << std::endl;
+
+    worker = std::thread(&ShaderWatcher::watch_loop, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    running = false;
+    if (worker.joinable())
+        worker.join();
+
+    for (auto &build : pending)
+    {
+        if (build.fence)
+            glDeleteSync(build.fence);
+        if (build.program)
+            glDeleteProgram(build.program);
+    }
+
+    if (shared_window)
+        glfwDestroyWindow(shared_window);
+}
+
+void ShaderWatcher::watch_loop()
+{
+    if (shared_window)
+        glfwMakeContextCurrent(shared_window);
+
+    while (running)
+    {
+        for (auto &entry : watched)
+        {
+            auto vertex_time = modified_time(entry.shader->vertexPath);
+            auto fragment_time = modified_time(entry.shader->fragmentPath);
+            if (vertex_time == entry.vertex_time && fragment_time == entry.fragment_time)
+                continue;
+
+            entry.vertex_time = vertex_time;
+            entry.fragment_time = fragment_time;
+            build(entry);
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(poll_interval));
+    }
+
+    if (shared_window)
+        glfwMakeContextCurrent(nullptr);
+}
+
+void ShaderWatcher::build(WatchedShader &entry)
+{
+    PendingBuild result;
+    result.shader = entry.shader;
+    result.generation = next_generation++;
+
+    if (!Shader::readSource(entry.shader->vertexPath, result.vertex_code) ||
+        !Shader::readSource(entry.shader->fragmentPath, result.fragment_code))
+    {
+        // Editors often truncate before writing, pick it up on the next change
+        std::cout << "Shader hot-reload: couldn't read " << entry.shader->vertexPath << " / "
+                  << entry.shader->fragmentPath << std::endl;
+        return;
+    }
+
+    if (shared_window)
+    {
+        std::string error;
+        result.program = Shader::compileProgram(result.vertex_code, result.fragment_code, error);
+        if (result.program == 0)
+        {
+            std::cout << "ERROR::SHADER::" << entry.shader->vertexPath << "::" << entry.shader->fragmentPath
+                      << "::" << error << "Keeping the previous program" << std::endl;
+            return;
+        }
+
+        // The render thread may only use the program once the shared context is done with it
+        result.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        result.vertex_code.clear();
+        result.fragment_code.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending.push_back(std::move(result));
+    }
+
+    // Wake the render loop in case it is idling in glfwWaitEvents
+    glfwPostEmptyEvent();
+}
+
+bool ShaderWatcher::has_pending()
+{
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    return !pending.empty();
+}
+
+bool ShaderWatcher::update()
+{
+    std::vector<PendingBuild> ready;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        if (pending.empty())
+            return false;
+        ready.swap(pending);
+    }
+
+    bool swapped = false;
+    std::vector<PendingBuild> not_ready;
+    for (auto &build : ready)
+    {
+        // A build still in flight goes back behind newer ones, so an older build can finish after a newer one was
+        // installed. It must not replace it
+        unsigned long &installed = installed_generation[build.shader];
+        if (build.generation < installed)
+        {
+            if (build.fence)
+                glDeleteSync(build.fence);
+            if (build.program)
+                glDeleteProgram(build.program);
+            continue;
+        }
+
+        unsigned int program = build.program;
+        if (build.fence)
+        {
+            // Never block the frame, try again next frame if the build is still in flight
+            if (glClientWaitSync(build.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            {
+                not_ready.push_back(std::move(build));
+                continue;
+            }
+            glDeleteSync(build.fence);
+        }
+        else
+        {
+            std::string error;
+            program = Shader::compileProgram(build.vertex_code, build.fragment_code, error);
+            if (program == 0)
+            {
+                std::cout << "ERROR::SHADER::" << build.shader->vertexPath << "::" << build.shader->fragmentPath
+                          << "::" << error << "Keeping the previous program" << std::endl;
+                continue;
+            }
+        }
+
+        glDeleteProgram(build.shader->ID);
+        build.shader->ID = program;
+        installed = build.generation;
+        swapped = true;
+        std::cout << "Shader reloaded: " << build.shader->vertexPath << " / " << build.shader->fragmentPath << std::endl;
+    }
+
+    if (!not_ready.empty())
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        for (auto &build : not_ready)
+            pending.push_back(std::move(build));
+    }
+    return swapped;
+}
@@ -0,0 +1,77 @@
+#ifndef OPENGL_MODEL_VIEWER_SHADER_WATCHER_H
+#define OPENGL_MODEL_VIEWER_SHADER_WATCHER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.h"
+
+/*
+ * Watches the source files of a set of shaders and rebuilds them when they change on disk.
+ *
+ * Compilation happens on a hidden window whose context shares objects with the main one, so the
+ * render loop never stalls on the driver. If no shared context can be created the sources are still
+ * read in the background and compiled on the render thread in update().
+ * A rebuilt program only replaces Shader::ID once it linked successfully, otherwise the last good
+ * program stays active and the driver log is printed.
+ */
+class ShaderWatcher {
+public:
+    ShaderWatcher(GLFWwindow *main_window, const std::vector<Shader*> &shaders, double poll_interval = 0.25);
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // Swaps in programs that finished building, must be called on the render thread once per frame.
+    // Returns true if any program was replaced
+    bool update();
+
+    bool has_shared_context() const { return shared_window != nullptr; }
+
+    // True while rebuilt programs wait to be swapped in by update()
+    bool has_pending();
+
+private:
+    struct WatchedShader {
+        Shader *shader;
+        std::filesystem::file_time_type vertex_time;
+        std::filesystem::file_time_type fragment_time;
+    };
+
+    // Result of a rebuild, handed from the worker to the render thread
+    struct PendingBuild {
+        Shader *shader;
+        unsigned long generation = 0; // Increases with every build the worker starts
+        unsigned int program = 0; // Linked program when built on the shared context
+        GLsync fence = nullptr; // Signalled once the shared context finished the build
+        std::string vertex_code; // Sources to compile on the render thread otherwise
+        std::string fragment_code;
+    };
+
+    void watch_loop();
+    void build(WatchedShader &watched);
+
+    GLFWwindow *shared_window = nullptr;
+    std::vector<WatchedShader> watched;
+    double poll_interval;
+
+    std::mutex pending_mutex;
+    std::vector<PendingBuild> pending;
+
+    unsigned long next_generation = 1; // Worker thread only
+    std::unordered_map<Shader*, unsigned long> installed_generation; // Render thread only
+
+    std::atomic<bool> running{true};
+    std::thread worker;
+};
+
+#endif //OPENGL_MODEL_VIEWER_SHADER_WATCHER_H
@@ -12,7 +12,7 @@ Window::Window(int screen_width, int screen_height,
 )
 
 {
-	this->_scr_width = screen_height;
+	this->_scr_width = screen_width;
 	this->_scr_height = screen_height;
 
 	// Init & set major & minor OpenGL version to 3
@@ -21,6 +21,9 @@ Window::Window(int screen_width, int screen_height,
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	// The default framebuffer stays single-sampled, anti-aliasing happens offscreen (see AntiAliasing)
+	glfwWindowHint(GLFW_SAMPLES, 0);
 	window = glfwCreateWindow(screen_width, screen_height, "Datalens", nullptr, nullptr);
 
 	if (window == nullptr)
@@ -55,14 +58,28 @@ Window::Window(int screen_width, int screen_height,
     std::cout<<"Renderer: "<<renderer<<std::endl;
     std::cout<<"OpenGL version supported "<<version<<std::endl;
 
-    // Smooth out jagged edges (anti-aliasing)
-    glfwWindowHint(GLFW_SAMPLES, 8);
+    // Rasterize multisampled targets with all their samples
     glEnable(GL_MULTISAMPLE);
 
     // Vertical synchronization (vsync)
-	glfwSwapInterval(1);
+	set_vsync(vsync);
+
+	// Framebuffer size may differ from the window size on high-DPI displays
+	glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
 }
 
 float Window::get_aspect_ratio() const {
-    return float(_scr_width) / float(_scr_height);
+    if (framebuffer_width <= 0 || framebuffer_height <= 0)
+        return float(_scr_width) / float(_scr_height);
+    return float(framebuffer_width) / float(framebuffer_height);
+}
+
+void Window::on_framebuffer_resize(int width, int height) {
+    framebuffer_width = width;
+    framebuffer_height = height;
+}
+
+void Window::set_vsync(bool enabled) {
+    vsync = enabled;
+    glfwSwapInterval(enabled ? 1 : 0);
 }
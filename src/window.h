@@ -9,6 +9,11 @@ struct Window
 	unsigned int _scr_width;
 	unsigned int _scr_height;
 
+	// Size of the default framebuffer in pixels, kept up to date by on_framebuffer_resize
+	int framebuffer_width = 0;
+	int framebuffer_height = 0;
+	bool vsync = true;
+
 	Window(int screen_width, int screen_height,
            GLFWframebuffersizefun framebuffer_size_callback,
            GLFWcursorposfun mouse_callback,
@@ -17,4 +22,9 @@ struct Window
            );
 
     float get_aspect_ratio() const;
+
+    // Must be called from the framebuffer size callback
+    void on_framebuffer_resize(int width, int height);
+
+    void set_vsync(bool enabled);
 };